@@ -20,6 +20,7 @@
 #include <unordered_map>
 
 #include "xdmlib/element.h"
+#include "xdmlib/lazy_base64_data.h"
 #include "xmpmeta/xml/deserializer.h"
 #include "xmpmeta/xml/serializer.h"
 
@@ -55,7 +56,8 @@ class Audio : public Element {
       FromDeserializer(const xml::Deserializer& parent_deserializer);
 
   // Returns the Audio data, which has been base-64 decoded but is still
-  // encoded according to the mime type of the Audio.
+  // encoded according to the mime type of the Audio. Data read from XMP is
+  // decoded on the first call.
   const string& GetData() const;
 
   // Returns the Audio mime type.
@@ -71,7 +73,7 @@ class Audio : public Element {
   // Extracts audio fields.
   bool ParseAudioFields(const xml::Deserializer& deserializer);
 
-  string data_;  // The raw data, i.e. not base64-encoded.
+  LazyBase64Data data_;
   string mime_;
 };
 
@@ -18,12 +18,14 @@
 #include <libxml/tree.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
 #include "xdmlib/cameras.h"
 #include "xdmlib/device_pose.h"
 #include "xdmlib/profiles.h"
+#include "xmpmeta/xml/deserializer.h"
 #include "xmpmeta/xmp_data.h"
 
 namespace xmpmeta {
@@ -46,12 +48,22 @@ class Device {
   // parsing fails. Both the standard and extended XMP sections are required.
   static std::unique_ptr<Device> FromXmp(const XmpData& xmp);
 
-  // Creates a Device by extracting XMP metadata from a JPEG and parsing it.
+  // Same as above, but takes ownership of the XMP metadata so that only the
+  // revision is parsed up front. Each of the cameras, device pose and
+  // profiles is parsed on the first call to its getter. The XMP is released
+  // once all of them are parsed, except that image and audio data that is not
+  // decoded yet keeps the XMP alive, as it points into it.
+  static std::unique_ptr<Device> FromXmp(std::unique_ptr<XmpData> xmp);
+
+  // Creates a Device by extracting XMP metadata from a JPEG and parsing it
+  // like FromXmp(std::unique_ptr<XmpData>).
   // If using XMP for other things as well, FromXmp() should be used instead to
   // prevent redundant extraction of XMP from the JPEG.
   static std::unique_ptr<Device> FromJpegFile(const string& filename);
 
-  // Getters.
+  // Getters. These may parse the element, and are safe to call from several
+  // threads. Image and audio data are decoded on the first call to their
+  // GetData().
   const string& GetRevision() const;
   const Cameras* GetCameras() const;
   const DevicePose* GetDevicePose() const;
@@ -70,8 +82,14 @@ class Device {
   // Retrieves the namespaces of all child elements.
   void GetNamespaces(
       std::unordered_map<string, string>* ns_name_href_map) const;
-  // Parses Device fields and XDM children elements.
-  bool ParseFields(const XmpData& xmp);
+  // Parses the Device fields, and sets deserializer_ to parse the XDM
+  // children elements. source, if not null, owns xmp, and is shared with the
+  // image and audio data that is not decoded yet.
+  bool ParseFields(const XmpData& xmp,
+                   const std::shared_ptr<const XmpData>& source);
+  // Releases xmp_ and deserializer_ once every element has been parsed.
+  // Must be called with elements_mutex_ held.
+  void ReleaseXmpIfParsed() const;
   // Gathers all the XML namespaces of child elements.
   void PopulateNamespaces();
 
@@ -79,11 +97,23 @@ class Device {
   // when Device is constructed.
   std::unordered_map<string, xmlNsPtr> namespaces_;
 
+  // The XMP metadata the elements are parsed from, if owned, until they are
+  // all parsed.
+  mutable std::shared_ptr<const XmpData> xmp_;
+  // Deserializes the Device node, until the elements are all parsed.
+  mutable std::unique_ptr<xml::Deserializer> deserializer_;
+
+  // Guards the lazy parsing of the elements below.
+  mutable std::mutex elements_mutex_;
+  mutable bool device_pose_parsed_;
+  mutable bool profiles_parsed_;
+  mutable bool cameras_parsed_;
+
   // XDM fields and elements.
   string revision_;
-  std::unique_ptr<DevicePose> device_pose_;
-  std::unique_ptr<Profiles> profiles_;
-  std::unique_ptr<Cameras> cameras_;
+  mutable std::unique_ptr<DevicePose> device_pose_;
+  mutable std::unique_ptr<Profiles> profiles_;
+  mutable std::unique_ptr<Cameras> cameras_;
 };
 
 }  // namespace xdm
@@ -20,6 +20,7 @@
 #include <unordered_map>
 
 #include "xdmlib/element.h"
+#include "xdmlib/lazy_base64_data.h"
 #include "xmpmeta/xml/deserializer.h"
 #include "xmpmeta/xml/serializer.h"
 
@@ -54,7 +55,8 @@ class Image : public Element {
       FromDeserializer(const xml::Deserializer& parent_deserializer);
 
   // Returns the Image data, which has been base-64 decoded but is still
-  // encoded according to the mime type of the Image.
+  // encoded according to the mime type of the Image. Data read from XMP is
+  // decoded on the first call.
   const string& GetData() const;
 
   // Returns the Image mime type.
@@ -70,7 +72,7 @@ class Image : public Element {
   // Extracts image fields.
   bool ParseImageFields(const xml::Deserializer& deserializer);
 
-  string data_;  // The raw data, i.e. not base64-encoded.
+  LazyBase64Data data_;
   string mime_;
 };
 
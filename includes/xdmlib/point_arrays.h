@@ -0,0 +1,95 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XDM_POINT_ARRAYS_H_
+#define XMPMETA_XDM_POINT_ARRAYS_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "xdmlib/aligned_buffer.h"
+#include "xdmlib/point_cloud.h"
+
+namespace xmpmeta {
+namespace xdm {
+
+// The positions of a point cloud as a structure of arrays, i.e. separate x, y
+// and z arrays, which is the layout bulk geometry works best on. Each array
+// is aligned to AlignedBuffer::kAlignment bytes, and the kernels below process
+// several points per instruction where the target supports it.
+class PointArrays {
+ public:
+  // Creates the arrays from the given positions, e.g. from
+  // PointCloud::GetPositions(). Returns null if there are no positions.
+  static std::unique_ptr<PointArrays>
+      FromPositions(const PointCloudView<PointPosition>& positions);
+
+  size_t size() const { return size_; }
+
+  // The coordinates of the points.
+  const float* x() const { return x_; }
+  const float* y() const { return y_; }
+  const float* z() const { return z_; }
+  float* mutable_x() { return x_; }
+  float* mutable_y() { return y_; }
+  float* mutable_z() { return z_; }
+
+  // Returns the position of the point at the given index.
+  PointPosition GetPosition(size_t index) const;
+
+  // Gets the corners of the axis-aligned bounding box of the points.
+  void GetBounds(PointPosition* min, PointPosition* max) const;
+
+  // Returns the mean of the positions. Sums are accumulated in double
+  // precision.
+  PointPosition GetCentroid() const;
+
+  // Computes both of the above in a single pass over the points. Any of the
+  // arguments may be null.
+  void GetBoundsAndCentroid(PointPosition* min, PointPosition* max,
+                            PointPosition* centroid) const;
+
+  // Rotates all points and then translates them, e.g. by the pose of a camera
+  // or device. rotation_xyz_angle is a rotation axis and an angle in radians,
+  // as returned by CameraPose::GetOrientationRotationXYZAngle(), and
+  // translation is x, y, z, as returned by CameraPose::GetPositionXYZ().
+  // Either may be empty to skip that step. Returns false, leaving the points
+  // unchanged, if either has the wrong size or the axis is zero.
+  bool Transform(const std::vector<double>& rotation_xyz_angle,
+                 const std::vector<double>& translation);
+
+  // Returns the positions in the layout of the PointCloud Position field, for
+  // PointCloud::FromData.
+  string ToPositionData() const;
+
+  PointArrays(const PointArrays&) = delete;
+  void operator=(const PointArrays&) = delete;
+
+ private:
+  PointArrays();
+
+  size_t size_;
+  // Holds the x, y and z arrays, each starting on an aligned boundary.
+  AlignedBuffer buffer_;
+  float* x_;
+  float* y_;
+  float* z_;
+};
+
+}  // namespace xdm
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XDM_POINT_ARRAYS_H_
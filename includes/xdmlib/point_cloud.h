@@ -15,7 +15,10 @@
 #ifndef XMPMETA_XDM_POINT_CLOUD_H_
 #define XMPMETA_XDM_POINT_CLOUD_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -28,8 +31,49 @@
 namespace xmpmeta {
 namespace xdm {
 
+// The position of a point, as stored in the Position field: three
+// little-endian 32-bit floats.
+struct PointPosition {
+  float x;
+  float y;
+  float z;
+};
+static_assert(sizeof(PointPosition) == 12, "PointPosition must be packed");
+
+// The color of a point, as stored in the Color field.
+struct PointColor {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+};
+static_assert(sizeof(PointColor) == 3, "PointColor must be packed");
+
+// A read-only view of an array owned by a PointCloud. It is valid for as long
+// as the PointCloud is.
+template <typename T>
+class PointCloudView {
+ public:
+  PointCloudView() : data_(nullptr), size_(0) {}
+  PointCloudView(const T* data, size_t size) : data_(data), size_(size) {}
+
+  const T* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T& operator[](size_t index) const { return data_[index]; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+
+ private:
+  const T* data_;
+  size_t size_;
+};
+
+class PointCloudIndex;
+
 class PointCloud : public Element {
  public:
+  ~PointCloud() override;
+
   void GetNamespaces(
       std::unordered_map<string, string>* ns_name_href_map) override;
 
@@ -38,9 +82,14 @@ class PointCloud : public Element {
   // Creates a Point Cloud from the given fields. Returns null if position is
   // empty. The first two arguments are required fields, the rest are optional.
   // If the color or software fields are empty, they will not be serialized.
+  // If position_bits is not 0, the positions are serialized in a compact
+  // encoding instead of as raw floats: each coordinate is quantized to
+  // position_bits bits, between 1 and 21, over the bounding box of the points.
+  // The encoding also reorders the points, and their colors with them.
   static std::unique_ptr<PointCloud>
       FromData(int count, const string& position, const string& color,
-               bool metric, const string& software);
+               bool metric, const string& software,
+               const int position_bits = 0);
 
   // Returns the deserialized PointCloud; null if parsing fails.
   // The returned pointer is owned by the caller.
@@ -53,6 +102,25 @@ class PointCloud : public Element {
   const string& GetColor() const;
   bool GetMetric() const;
   const string& GetSoftware() const;
+  // The number of bits per coordinate of the compact position encoding, or 0
+  // if positions are serialized as raw floats.
+  int GetPositionBits() const;
+
+  // Returns the GetCount() positions of the points, or an empty view if the
+  // position data does not hold exactly that many. The view reads the data of
+  // GetPosition() in place. Floats are read in the host byte order, which
+  // must be little-endian.
+  PointCloudView<PointPosition> GetPositions() const;
+
+  // Returns the GetCount() colors of the points, or an empty view if there is
+  // no color data or it does not hold exactly that many. The view reads the
+  // data of GetColor() in place.
+  PointCloudView<PointColor> GetColors() const;
+
+  // Returns a spatial index of GetPositions() for nearest neighbor and radius
+  // queries, or null if there are no valid positions. The index is built on
+  // the first call and kept until this object is destroyed. Thread-safe.
+  const PointCloudIndex* GetIndex() const;
 
   PointCloud(const PointCloud&) = delete;
   void operator=(const PointCloud&) = delete;
@@ -62,6 +130,10 @@ class PointCloud : public Element {
 
   bool ParseFields(const xml::Deserializer& deserializer);
 
+  // Checks the sizes of the position and color data against count_, once,
+  // for GetPositions and GetColors.
+  void ValidateLayout();
+
   // Required fields.
   int count_;
   string position_;  // Raw data, i.e. not base64 encoded.
@@ -70,6 +142,15 @@ class PointCloud : public Element {
   bool metric_;
   string color_;  // Raw data, i.e. not base64 encoded.
   string software_;
+  int position_bits_;
+
+  // Set by ValidateLayout.
+  bool positions_valid_;
+  bool colors_valid_;
+
+  // Built by GetIndex, once.
+  mutable std::once_flag index_once_;
+  mutable std::unique_ptr<PointCloudIndex> index_;
 };
 
 }  // namespace xdm
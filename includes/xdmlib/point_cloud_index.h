@@ -0,0 +1,85 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XDM_POINT_CLOUD_INDEX_H_
+#define XMPMETA_XDM_POINT_CLOUD_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "xdmlib/point_cloud.h"
+
+namespace xmpmeta {
+namespace xdm {
+
+// A spatial index for nearest neighbor and radius queries over the positions
+// of a point cloud. It is a uniform voxel grid over the bounding box of the
+// points, sized for at most one cell per kTargetPointsPerCell points, with the
+// point indices sorted by cell. It references the positions rather than
+// copying them, and takes at most 4.5 bytes per point: a 4-byte index per
+// point, and a 4-byte offset per cell.
+class PointCloudIndex {
+ public:
+  static const size_t kTargetPointsPerCell = 8;
+
+  // Builds an index of the given positions, which must outlive it. Returns
+  // null if there are no positions, or too many to number with 32 bits.
+  static std::unique_ptr<PointCloudIndex>
+      FromPositions(const PointCloudView<PointPosition>& positions);
+
+  // Sets indices to the indices of the k points nearest to query, nearest
+  // first, or of all points if there are fewer than k. Points at the same
+  // distance are ordered by index.
+  void FindNearest(const PointPosition& query, size_t k,
+                   std::vector<size_t>* indices) const;
+
+  // Sets indices to the indices of the points within radius of center, in
+  // increasing order.
+  void FindWithinRadius(const PointPosition& center, float radius,
+                        std::vector<size_t>* indices) const;
+
+  // Returns the number of bytes allocated by the index.
+  size_t GetMemoryUsage() const;
+
+  PointCloudIndex(const PointCloudIndex&) = delete;
+  void operator=(const PointCloudIndex&) = delete;
+
+ private:
+  PointCloudIndex();
+
+  // Returns the cell that contains value on the given axis, clamped to the
+  // grid.
+  int GetCellCoordinate(float value, int axis) const;
+
+  // Returns the offset of the given cell in cell_starts_.
+  size_t GetCellIndex(int x, int y, int z) const;
+
+  PointCloudView<PointPosition> positions_;
+  // The grid covers the box from origin_ with dimensions_ cells of
+  // cell_size_ along each axis.
+  float origin_[3];
+  float cell_size_;
+  int dimensions_[3];
+  // The points of cell i are point_indices_[cell_starts_[i]] up to
+  // point_indices_[cell_starts_[i + 1]].
+  std::vector<uint32_t> cell_starts_;
+  std::vector<uint32_t> point_indices_;
+};
+
+}  // namespace xdm
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XDM_POINT_CLOUD_INDEX_H_
@@ -0,0 +1,115 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_BATCH_XMP_READER_H_
+#define XMPMETA_BATCH_XMP_READER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/port.h"
+#include "xmpmeta/xmp_data.h"
+
+namespace xmpmeta {
+
+// Options for BatchXmpReader.
+struct BatchXmpReaderOptions {
+  // The number of worker threads. If zero, uses the number of hardware
+  // threads.
+  int num_threads = 0;
+
+  // Caps the total size, in bytes, of the inputs that are being read or whose
+  // results are waiting to be delivered. An input larger than the cap is read
+  // on its own. If zero, there is no cap.
+  size_t max_in_flight_bytes = 0;
+
+  // If set, results are delivered in input order. Otherwise, they are
+  // delivered as soon as they are ready.
+  bool ordered = true;
+
+  // Passed to ReadXmpHeader and ReadXmpFromMemory.
+  bool skip_extended = false;
+};
+
+// The result of reading one input.
+struct BatchXmpResult {
+  // The position of the input in the list given to the reader.
+  size_t index = 0;
+
+  // Whether the XMP metadata was read successfully.
+  bool success = false;
+
+  // The metadata read from the input. Never null.
+  std::unique_ptr<XmpData> xmp_data;
+};
+
+// Reads the XMP metadata of many JPEG files or buffers on a pool of worker
+// threads. The threads are started with the reader and reused by every batch
+// until it is destroyed, so keep one reader for many batches. Batches given to
+// the same reader from several threads run one after another, and a callback
+// must not start another batch on its own reader. Results are
+// delivered to a callback on the calling thread, so the callback needs no
+// locking of its own. libxml2 is initialized once, before the first reader is
+// created, so that it may be used concurrently.
+// Example:
+//   BatchXmpReaderOptions options;
+//   options.max_in_flight_bytes = 256 << 20;
+//   BatchXmpReader reader(options);
+//   reader.ReadFiles(filenames, [](BatchXmpResult* result) {
+//     if (result->success) {
+//       auto gpano = GPano::FromXmp(*result->xmp_data);
+//       ...
+//     }
+//   });
+class BatchXmpReader {
+ public:
+  // Receives one result. The callback may take ownership of the XmpData.
+  typedef std::function<void(BatchXmpResult* result)> Callback;
+
+  explicit BatchXmpReader(const BatchXmpReaderOptions& options);
+
+  // Stops and joins the worker threads.
+  ~BatchXmpReader();
+
+  // Reads the XMP metadata of each JPEG file and passes each result to the
+  // callback. Returns once every result has been delivered.
+  void ReadFiles(const std::vector<string>& filenames,
+                 const Callback& callback) const;
+
+  // Same as above, but returns the results in input order.
+  std::vector<BatchXmpResult> ReadFiles(
+      const std::vector<string>& filenames) const;
+
+  // Reads the XMP metadata of JPEG files that have already been read into
+  // memory, and passes each result to the callback. Returns once every result
+  // has been delivered.
+  void ReadBuffers(const std::vector<string>& jpeg_contents,
+                   const Callback& callback) const;
+
+  // Disallow copying.
+  BatchXmpReader(const BatchXmpReader&) = delete;
+  void operator=(const BatchXmpReader&) = delete;
+
+ private:
+  class WorkerPool;
+
+  const BatchXmpReaderOptions options_;
+  const std::unique_ptr<WorkerPool> pool_;
+};
+
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_BATCH_XMP_READER_H_
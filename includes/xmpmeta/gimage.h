@@ -16,10 +16,12 @@
 #define XMPMETA_GIMAGE_H_
 
 #include <memory>
+#include <ostream>
 #include <string>
 #include <unordered_map>
 
 #include "xmpmeta/xmp_data.h"
+#include "xmpmeta/xmp_parser.h"
 #include "xmpmeta/xml/serializer.h"
 
 namespace xmpmeta {
@@ -49,6 +51,16 @@ class GImage {
   // prevent redundant extraction of XMP from the JPEG.
   static std::unique_ptr<GImage> FromJpegFile(const string& filename);
 
+  // Streams the base64-decoded GImage data from the extended XMP of a JPEG to
+  // sink in bounded chunks, decoding it as it is read from the mapped file.
+  // See ReadExtendedXmpBase64Property.
+  static bool ReadDataFromJpegFile(const string& filename,
+                                   const DataSink& sink);
+
+  // Same as above, but writes the data to the given stream.
+  static bool ReadDataFromJpegFile(const string& filename,
+                                   std::ostream* output);
+
   // Determines whether the requisite fields are present in the XMP metadata.
   // Only the Mime field is checked in order to make this fast. Therefore,
   // extended XMP is not needed.
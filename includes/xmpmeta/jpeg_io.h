@@ -15,6 +15,7 @@
 #ifndef XMPMETA_JPEG_IO_H_
 #define XMPMETA_JPEG_IO_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -55,14 +56,139 @@ struct ParseOptions {
 };
 
 
-// Parses the JPEG image file.
+// A non-owning view of a section in a JPEG buffer. The data pointer is only
+// valid for as long as the buffer it refers to.
+struct SectionView {
+  // Constructors.
+  SectionView() = default;
+  SectionView(int marker, bool is_image_section, size_t offset,
+              const char* data, size_t length);
+  explicit SectionView(const Section& section);
+
+  // Returns true if the section's marker matches an APP1 marker.
+  bool IsMarkerApp1() const;
+
+  // Returns true if the section's data starts with the given string.
+  bool HasPrefix(const string& prefix) const;
+
+  int marker = 0;
+  bool is_image_section = false;
+  // Offset of the section data from the start of the JPEG buffer. This is
+  // zero for views created from a Section.
+  size_t offset = 0;
+  const char* data = nullptr;
+  size_t length = 0;
+};
+
+// Indexes the sections of a JPEG image held in memory, without copying any
+// section data. The memory is either a read-only mapping of a file owned by
+// the index, or a buffer owned by the caller.
+class SectionIndex {
+ public:
+  // Maps the given file into memory and indexes it. Returns null if the file
+  // could not be opened or mapped.
+  static std::unique_ptr<SectionIndex> FromFile(const string& filename);
+
+  // Indexes the given buffer, which must outlive the returned index.
+  static std::unique_ptr<SectionIndex> FromBuffer(const char* data,
+                                                  size_t size);
+
+  ~SectionIndex();
+
+  // Returns all the sections in file order, including the image section if
+  // present. Empty if the buffer does not start with a valid JPEG marker.
+  const std::vector<SectionView>& Sections() const { return sections_; }
+
+  // Returns the APP1 sections whose data start with the given prefix.
+  std::vector<SectionView> FindApp1Sections(const string& prefix) const;
+
+  // The indexed bytes.
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  SectionIndex(const char* data, size_t size, void* mapping);
+
+  const char* data_;
+  size_t size_;
+  // Non-null if data_ is a mapping owned by this index.
+  void* mapping_;
+  // Backing storage when the file cannot be mapped.
+  string owned_data_;
+  std::vector<SectionView> sections_;
+
+  SectionIndex(const SectionIndex&) = delete;
+  void operator=(const SectionIndex&) = delete;
+};
+
+class BufferedReader;
+
+// Reads the sections of a JPEG stream one at a time, so that the image data
+// never has to be held in memory.
+class SectionReader {
+ public:
+  // Reads the start of image marker from input_stream, which must outlive
+  // the reader. The stream state is set as Parse sets it.
+  explicit SectionReader(std::istream* input_stream);
+  ~SectionReader();
+
+  // Reads the next section before the image data. Returns false once the
+  // start of scan marker is reached, or if the input is malformed;
+  // AtScanData() tells the two apart.
+  bool Next(Section* section);
+
+  // Returns true once the start of scan marker has been read.
+  bool AtScanData() const { return at_scan_data_; }
+
+  // Returns the number of bytes read from the stream so far. Once
+  // AtScanData() is true, this is the offset of the image data.
+  size_t Position() const;
+
+  // Writes the start of scan marker and copies the rest of the input to
+  // output_stream in fixed-size chunks. Returns false if AtScanData() is false
+  // or the output could not be written.
+  bool CopyScanData(std::ostream* output_stream);
+
+ private:
+  std::unique_ptr<BufferedReader> reader_;
+  bool at_scan_data_;
+  bool done_;
+
+  SectionReader(const SectionReader&) = delete;
+  void operator=(const SectionReader&) = delete;
+};
+
+// Parses the JPEG image file. As with std::istream::read, input_stream gets
+// eofbit and failbit if the input ends in the middle of a section.
 std::vector<Section> Parse(const ParseOptions& options,
                            std::istream* input_stream);
 
+// Returns views of the given sections, which must outlive the views.
+std::vector<SectionView> ToSectionViews(const std::vector<Section>& sections);
+
 // Writes JPEG data sections to a file.
 void WriteSections(const std::vector<Section>& sections,
                    std::ostream* output_stream);
 
+// Writes the JPEG data referenced by the section views to a file.
+void WriteSections(const std::vector<SectionView>& sections,
+                   std::ostream* output_stream);
+
+// Writes the start of image marker that begins a JPEG file.
+void WriteStartOfImage(std::ostream* output_stream);
+
+// Writes the start of scan marker that precedes the image data.
+void WriteStartOfScan(std::ostream* output_stream);
+
+// Writes a single section, including its marker and length.
+void WriteSection(const SectionView& section, std::ostream* output_stream);
+
+// Writes an APP1 section whose data is header followed by data, without
+// first copying them into one buffer.
+void WriteApp1Section(const char* header, size_t header_length,
+                      const char* data, size_t data_length,
+                      std::ostream* output_stream);
+
 }  // namespace xmpmeta
 
 #endif  // XMPMETA_JPEG_IO_H_
@@ -15,12 +15,49 @@
 #ifndef XMPMETA_MD5_H_
 #define XMPMETA_MD5_H_
 
+#include <cstddef>
 #include <string>
 
+#include "base/integral_types.h"
 #include "base/port.h"
 
 namespace xmpmeta {
 
+// The state of an MD5 computation.
+struct MD5Context {
+  uint32 buf[4];
+  uint32 bits[2];
+  uint32 in[16];
+};
+
+// Computes the MD5 hash of data that is added in pieces, so that it does not
+// have to be held in one buffer. The result is the same as that of MD5Hash on
+// the concatenated pieces.
+//
+// Usage example:
+//  MD5Hasher hasher;
+//  hasher.Update(first_part);
+//  hasher.Update(second_part);
+//  const string guid = hasher.Final();
+class MD5Hasher {
+ public:
+  MD5Hasher();
+
+  // Starts a new hash, dropping any data added so far.
+  void Init();
+
+  // Adds data to the hash.
+  void Update(const char* data, size_t length);
+  void Update(const string& data);
+
+  // Returns the hash of the data added since Init as a 32-character hex
+  // string, then starts a new hash.
+  string Final();
+
+ private:
+  MD5Context context_;
+};
+
 // Returns the MD5 hash of to_hash as a 32-character hex string.
 // Wrapper around OpenSSL to avoid Gyp dependency problems.
 string MD5Hash(const string& to_hash);
@@ -17,6 +17,7 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
 
 #include "xmpmeta/gaudio.h"
 #include "xmpmeta/gimage.h"
@@ -30,6 +31,15 @@ namespace xmpmeta {
 bool WriteVrPhotoMetaToXmp(const GImage& gimage, const GPano& gpano,
                            const GAudio* gaudio, XmpData* xmp_data);
 
+// Same as WriteVrPhotoMetaToXmp, but writes the XMP text directly, without
+// building XML documents. standard_xmp and extended_xmp are set to the XMP
+// packets of the standard and extended sections, as AddXmpMetaToJpegStream
+// would write them, and can be given to AddXmpPacketsToJpegStream. The
+// standard packet links the extended one.
+bool WriteVrPhotoMetaToXmpPackets(const GImage& gimage, const GPano& gpano,
+                                  const GAudio* gaudio, string* standard_xmp,
+                                  string* extended_xmp);
+
 }  // namespace xmpmeta
 
 #endif  // XMPMETA_VR_PHOTO_WRITER_H_
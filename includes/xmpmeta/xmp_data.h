@@ -15,6 +15,9 @@
 #ifndef XMPMETA_XMP_DATA_H_
 #define XMPMETA_XMP_DATA_H_
 
+#include <functional>
+#include <mutex>
+
 #include <libxml/tree.h>
 
 namespace xmpmeta {
@@ -34,13 +37,33 @@ class XmpData {
   const xmlDocPtr StandardSection() const;
   xmlDocPtr* MutableStandardSection();
 
-  // The extended XMP section.
+  // The extended XMP section. If it was set lazily, the first call to either
+  // of these parses it.
   const xmlDocPtr ExtendedSection() const;
   xmlDocPtr* MutableExtendedSection();
 
+  // Defers parsing of the extended section to the first call to
+  // ExtendedSection() or MutableExtendedSection(), which sets it to the result
+  // of parser. Any extended section already set is freed.
+  void SetLazyExtendedSection(const std::function<xmlDocPtr()>& parser);
+
+  // Returns true if the extended section is set or waiting to be parsed,
+  // without parsing it.
+  bool HasExtendedSection() const;
+
+  // Disallow copying.
+  XmpData(const XmpData&) = delete;
+  void operator=(const XmpData&) = delete;
+
  private:
+  // Parses the extended section if it was set lazily.
+  void ParseExtendedSection() const;
+
   xmlDocPtr xmp_;
-  xmlDocPtr xmp_extended_;
+  mutable xmlDocPtr xmp_extended_;
+  // Guards the lazy parse of the extended section.
+  mutable std::mutex extended_mutex_;
+  mutable std::function<xmlDocPtr()> extended_parser_;
 };
 
 }  // namespace xmpmeta
@@ -19,9 +19,14 @@
 #include <string>
 
 #include "base/port.h"
+#include "xmpmeta/base64.h"
 #include "xmpmeta/xmp_data.h"
+#include "xmpmeta/xmp_parser_context.h"
 
 namespace xmpmeta {
+namespace xml {
+class PropertyExtractor;
+}  // namespace xml
 
 // Populates a XmpData from the header of the JPEG file.
 bool ReadXmpHeader(const string& filename, bool skip_extended,
@@ -32,6 +37,38 @@ bool ReadXmpHeader(const string& filename, bool skip_extended,
 bool ReadXmpFromMemory(const string& jpeg_contents, bool skip_extended,
                        XmpData* xmp_data);
 
+// Same as the functions above, but parses with the given context so that its
+// parser state and dictionary are reused across files. See XmpParserContext.
+bool ReadXmpHeader(const string& filename, bool skip_extended,
+                   XmpParserContext* context, XmpData* xmp_data);
+bool ReadXmpFromMemory(const string& jpeg_contents, bool skip_extended,
+                       XmpParserContext* context, XmpData* xmp_data);
+
+// Same as ReadXmpHeader with skip_extended set to false, except that only the
+// standard section is parsed here. The extended section, if any, is parsed on
+// the first call to XmpData::ExtendedSection(), so callers that never need it
+// do not pay for it. The file stays mapped until then. Returns false if the
+// standard section cannot be parsed or the extended sections are malformed.
+bool ReadXmpHeaderLazily(const string& filename, XmpData* xmp_data);
+
+// Streams the standard XMP section of the JPEG file through the extractor
+// without building a DOM. Returns false if the file has no valid standard
+// section or if extraction fails. See xml::PropertyExtractor.
+bool ExtractXmpProperties(const string& filename,
+                          xml::PropertyExtractor* extractor);
+
+// Streams the base64-decoded value of the extended XMP property prefix:name,
+// such as GImage:Data, from the JPEG file to sink in chunks of at most 64 KiB.
+// The extended sections are scanned in offset order with
+// xml::StreamPropertyValue, and the value is decoded as it is read, so neither
+// the extended section, nor the encoded or decoded value, is held in memory.
+// The property may be an attribute of rdf:Description or a simple element.
+// Returns false if the property is not found, is not valid base64, or if the
+// sink fails, in which case some data may already have been passed to sink.
+bool ReadExtendedXmpBase64Property(const string& filename,
+                                   const string& prefix, const string& name,
+                                   const DataSink& sink);
+
 // Populates a XmpData from the header of the given stream (stream data is
 // in JPEG format).
 bool ReadXmpHeader(std::istream* input_stream, bool skip_extended,
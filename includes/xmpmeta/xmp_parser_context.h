@@ -0,0 +1,54 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XMP_PARSER_CONTEXT_H_
+#define XMPMETA_XMP_PARSER_CONTEXT_H_
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+namespace xmpmeta {
+
+// Reusable state for parsing XMP packets. Parsing with xmlReadMemory sets up a
+// new parser context and string dictionary for every packet; a context keeps
+// one libxml2 parser, reset between documents, and a dictionary pre-warmed
+// with the element and attribute names that XMP packets commonly use.
+//
+// A context is not thread-safe; use one per thread. Documents parsed by a
+// context share its dictionary, so they must not be modified on another thread
+// while the context is parsing. The documents stay valid after the context is
+// destroyed.
+class XmpParserContext {
+ public:
+  XmpParserContext();
+  ~XmpParserContext();
+
+  // Parses an XML document from memory, with the given xmlParserOption flags.
+  // Returns null if the document is not well-formed. The caller owns the
+  // returned document.
+  xmlDocPtr ReadMemory(const char* data, int size, int options);
+
+  // The dictionary shared by the documents parsed with this context.
+  const xmlDict* Dictionary() const;
+
+ private:
+  xmlParserCtxtPtr context_;
+
+  XmpParserContext(const XmpParserContext&) = delete;
+  void operator=(const XmpParserContext&) = delete;
+};
+
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XMP_PARSER_CONTEXT_H_
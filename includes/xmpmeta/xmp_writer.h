@@ -40,10 +40,35 @@ bool WriteLeftEyeAndXmpMeta(const string& left_data, const string& filename,
 // Updates a JPEG input stream with new XMP data and writes it to an
 // output stream.
 // This is equivalent to writeXMPMeta in geo/lightfield/metadata/XmpUtil.java.
+// The input is streamed: existing XMP sections are dropped, the new ones are
+// written after a leading EXIF section (or first otherwise), and the image
+// data is copied in fixed-size chunks, so memory use does not grow with the
+// image size.
 bool AddXmpMetaToJpegStream(std::istream* input_jpeg_stream,
                             const XmpData& xmp_data,
                             std::ostream* output_jpeg_stream);
 
+// Same as AddXmpMetaToJpegStream, but with XMP that is already serialized
+// into packets, e.g. by WriteVrPhotoMetaToXmpPackets. If extended_xmp is not
+// empty, standard_xmp must link it with the xmpNote:HasExtendedXMP property.
+bool AddXmpPacketsToJpegStream(std::istream* input_jpeg_stream,
+                               const string& standard_xmp,
+                               const string& extended_xmp,
+                               std::ostream* output_jpeg_stream);
+
+// Same as AddXmpMetaToJpegStream, but between two different files. On Linux
+// the image data is copied within the kernel.
+bool AddXmpMetaToJpegFile(const string& input_filename,
+                          const XmpData& xmp_data,
+                          const string& output_filename);
+
+// Replaces the XMP data of a JPEG file. If the new standard section fits in
+// the existing one, and the file's extended sections are already the new ones
+// (or neither has any), the new section is padded to the old length with XMP
+// packet padding and only those bytes are overwritten. Otherwise the whole
+// file is rewritten.
+bool UpdateXmpMetaInJpegFile(const string& filename, const XmpData& xmp_data);
+
 }  // namespace xmpmeta
 
 #endif  // XMPMETA_XMP_WRITER_H_
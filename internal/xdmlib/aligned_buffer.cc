@@ -0,0 +1,78 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/aligned_buffer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace xmpmeta {
+namespace xdm {
+
+const size_t AlignedBuffer::kAlignment;
+
+AlignedBuffer::AlignedBuffer() : data_(nullptr), size_(0) {}
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer&& other)
+    : storage_(std::move(other.storage_)), data_(other.data_),
+      size_(other.size_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& other) {
+  storage_ = std::move(other.storage_);
+  data_ = other.data_;
+  size_ = other.size_;
+  other.data_ = nullptr;
+  other.size_ = 0;
+  return *this;
+}
+
+void AlignedBuffer::Allocate(size_t size) {
+  Clear();
+  if (size == 0) {
+    return;
+  }
+  // Over-allocate so that an aligned start can be found in the storage.
+  storage_.reset(new char[size + kAlignment - 1]);
+  const uintptr_t address = reinterpret_cast<uintptr_t>(storage_.get());
+  const uintptr_t aligned_address =
+      (address + kAlignment - 1) & ~static_cast<uintptr_t>(kAlignment - 1);
+  data_ = storage_.get() + (aligned_address - address);
+  size_ = size;
+}
+
+void AlignedBuffer::Assign(const char* data, size_t size) {
+  Allocate(size);
+  if (size > 0) {
+    memcpy(data_, data, size);
+  }
+}
+
+void AlignedBuffer::Truncate(size_t size) {
+  if (size < size_) {
+    size_ = size;
+  }
+}
+
+void AlignedBuffer::Clear() {
+  storage_.reset();
+  data_ = nullptr;
+  size_ = 0;
+}
+
+}  // namespace xdm
+}  // namespace xmpmeta
@@ -0,0 +1,66 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XDM_ALIGNED_BUFFER_H_
+#define XMPMETA_XDM_ALIGNED_BUFFER_H_
+
+#include <cstddef>
+#include <memory>
+
+namespace xmpmeta {
+namespace xdm {
+
+// A heap buffer of bytes whose data starts on a kAlignment-byte boundary, so
+// that arrays of numbers stored in it can be read with wide vector loads.
+class AlignedBuffer {
+ public:
+  // A cache line on most current CPUs, and a multiple of the widest vector
+  // register.
+  static const size_t kAlignment = 64;
+
+  AlignedBuffer();
+  AlignedBuffer(AlignedBuffer&& other);
+  AlignedBuffer& operator=(AlignedBuffer&& other);
+
+  // Replaces the contents with size uninitialized bytes.
+  void Allocate(size_t size);
+
+  // Replaces the contents with a copy of the given bytes.
+  void Assign(const char* data, size_t size);
+
+  // Drops the bytes after the first size. The memory is not released.
+  void Truncate(size_t size);
+
+  // Releases the memory.
+  void Clear();
+
+  char* data() { return data_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  AlignedBuffer(const AlignedBuffer&) = delete;
+  void operator=(const AlignedBuffer&) = delete;
+
+ private:
+  std::unique_ptr<char[]> storage_;
+  // Points into storage_, or is null if nothing is allocated.
+  char* data_;
+  size_t size_;
+};
+
+}  // namespace xdm
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XDM_ALIGNED_BUFFER_H_
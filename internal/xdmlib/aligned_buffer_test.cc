@@ -0,0 +1,85 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/aligned_buffer.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+bool IsAligned(const char* data) {
+  return reinterpret_cast<uintptr_t>(data) % AlignedBuffer::kAlignment == 0;
+}
+
+TEST(AlignedBuffer, Empty) {
+  AlignedBuffer buffer;
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(0, buffer.size());
+  EXPECT_EQ(nullptr, buffer.data());
+
+  buffer.Allocate(0);
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST(AlignedBuffer, AllocateIsAligned) {
+  for (size_t size = 1; size < 200; size += 7) {
+    AlignedBuffer buffer;
+    buffer.Allocate(size);
+    EXPECT_EQ(size, buffer.size());
+    EXPECT_TRUE(IsAligned(buffer.data())) << "Size " << size;
+  }
+}
+
+TEST(AlignedBuffer, AssignTruncateAndClear) {
+  const std::string data("0123456789");
+  AlignedBuffer buffer;
+  buffer.Assign(data.data(), data.size());
+  EXPECT_EQ(data, std::string(buffer.data(), buffer.size()));
+  EXPECT_TRUE(IsAligned(buffer.data()));
+
+  buffer.Truncate(4);
+  EXPECT_EQ("0123", std::string(buffer.data(), buffer.size()));
+  // Truncating cannot grow the buffer.
+  buffer.Truncate(8);
+  EXPECT_EQ(4, buffer.size());
+
+  buffer.Clear();
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(nullptr, buffer.data());
+}
+
+TEST(AlignedBuffer, Move) {
+  AlignedBuffer buffer;
+  buffer.Assign("abc", 3);
+  const char* data = buffer.data();
+
+  AlignedBuffer moved(std::move(buffer));
+  EXPECT_EQ(data, moved.data());
+  EXPECT_EQ(3, moved.size());
+  EXPECT_TRUE(buffer.empty());
+
+  buffer = std::move(moved);
+  EXPECT_EQ(data, buffer.data());
+  EXPECT_TRUE(moved.empty());
+}
+
+}  // namespace
+}  // namespace xdm
+}  // namespace xmpmeta
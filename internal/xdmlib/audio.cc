@@ -16,7 +16,6 @@
 
 #include "glog/logging.h"
 #include "xdmlib/const.h"
-#include "xmpmeta/base64.h"
 
 using xmpmeta::xml::Deserializer;
 using xmpmeta::xml::Serializer;
@@ -53,7 +52,7 @@ std::unique_ptr<Audio> Audio::FromData(const string& data, const string& mime) {
     return nullptr;
   }
   std::unique_ptr<Audio> audio(new Audio());
-  audio->data_ = data;
+  audio->data_.SetData(data);
   audio->mime_ = mime;
   return audio;
 }
@@ -73,7 +72,7 @@ Audio::FromDeserializer(const Deserializer& parent_deserializer) {
   return audio;
 }
 
-const string& Audio::GetData() const { return data_; }
+const string& Audio::GetData() const { return data_.GetData(); }
 
 const string& Audio::GetMime() const { return mime_; }
 
@@ -83,7 +82,7 @@ bool Audio::Serialize(Serializer* serializer) const {
     return false;
   }
   string base64_encoded;
-  if (!EncodeBase64(data_, &base64_encoded)) {
+  if (!data_.GetBase64(&base64_encoded)) {
     return false;
   }
   if (!serializer->WriteProperty(XdmConst::Audio(), kMime, mime_)) {
@@ -97,7 +96,7 @@ bool Audio::ParseAudioFields(const Deserializer& deserializer) {
   if (!deserializer.ParseString(XdmConst::Audio(), kMime, &mime_)) {
     return false;
   }
-  return deserializer.ParseBase64(XdmConst::Audio(), kData , &data_);
+  return data_.ParseFrom(deserializer, XdmConst::Audio(), kData);
 }
 
 }  // namespace xdm
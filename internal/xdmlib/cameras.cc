@@ -55,20 +55,15 @@ Cameras::FromCameraArray(std::vector<std::unique_ptr<Camera>>* camera_list) {
 std::unique_ptr<Cameras>
 Cameras::FromDeserializer(const Deserializer& parent_deserializer) {
   std::unique_ptr<Cameras> cameras(new Cameras());
-  int i = 0;
-  std::unique_ptr<Deserializer> deserializer =
-      parent_deserializer.CreateDeserializerFromListElementAt(
-          XdmConst::Namespace(kNodeName), kNodeName, 0);
-  while (deserializer) {
+  for (const auto& deserializer :
+       parent_deserializer.CreateListElementDeserializers(
+           XdmConst::Namespace(kNodeName), kNodeName)) {
     std::unique_ptr<Camera> camera = Camera::FromDeserializer(*deserializer);
     if (camera == nullptr) {
       LOG(ERROR) << "Unable to deserialize a camera";
       return nullptr;
     }
     cameras->camera_list_.emplace_back(std::move(camera));
-    deserializer =
-        parent_deserializer.CreateDeserializerFromListElementAt(
-            XdmConst::Namespace(kNodeName), kNodeName, ++i);
   }
 
   if (cameras->camera_list_.empty()) {
@@ -16,6 +16,8 @@
 
 #include <libxml/tree.h>
 
+#include <utility>
+
 #include "glog/logging.h"
 #include "xdmlib/const.h"
 #include "xmpmeta/xml/const.h"
@@ -44,7 +46,9 @@ const char kNamespaceHref[] = "http://ns.xdm.org/photos/1.0/device/";
 }  // namespace
 
 // Private constructor.
-Device::Device() {}
+Device::Device()
+    : device_pose_parsed_(true), profiles_parsed_(true),
+      cameras_parsed_(true) {}
 
 std::unique_ptr<Device> Device::FromData(
     const string& revision,
@@ -70,25 +74,77 @@ std::unique_ptr<Device> Device::FromData(
 
 std::unique_ptr<Device> Device::FromXmp(const XmpData& xmp) {
   std::unique_ptr<Device> device(new Device());
-  if (!device->ParseFields(xmp)) {
+  if (!device->ParseFields(xmp, nullptr)) {
+    return nullptr;
+  }
+  // The caller keeps xmp, so parse the elements while it is alive.
+  device->GetCameras();
+  device->GetDevicePose();
+  device->GetProfiles();
+  return device;
+}
+
+std::unique_ptr<Device> Device::FromXmp(std::unique_ptr<XmpData> xmp) {
+  if (xmp == nullptr) {
+    LOG(ERROR) << "XmpData is null";
+    return nullptr;
+  }
+  std::unique_ptr<Device> device(new Device());
+  device->xmp_ = std::move(xmp);
+  if (!device->ParseFields(*device->xmp_, device->xmp_)) {
     return nullptr;
   }
   return device;
 }
 
 std::unique_ptr<Device> Device::FromJpegFile(const string& filename) {
-  XmpData xmp;
+  std::unique_ptr<XmpData> xmp(new XmpData());
   const bool kSkipExtended = false;
-  if (!ReadXmpHeader(filename, kSkipExtended, &xmp)) {
+  if (!ReadXmpHeader(filename, kSkipExtended, xmp.get())) {
     return nullptr;
   }
-  return FromXmp(xmp);
+  return FromXmp(std::move(xmp));
 }
 
 const string& Device::GetRevision() const { return revision_; }
-const Cameras* Device::GetCameras() const { return cameras_.get(); }
-const DevicePose* Device::GetDevicePose() const { return device_pose_.get(); }
-const Profiles* Device::GetProfiles() const { return profiles_.get(); }
+
+const Cameras* Device::GetCameras() const {
+  std::lock_guard<std::mutex> lock(elements_mutex_);
+  if (!cameras_parsed_) {
+    cameras_ = Cameras::FromDeserializer(*deserializer_);
+    cameras_parsed_ = true;
+    ReleaseXmpIfParsed();
+  }
+  return cameras_.get();
+}
+
+const DevicePose* Device::GetDevicePose() const {
+  std::lock_guard<std::mutex> lock(elements_mutex_);
+  if (!device_pose_parsed_) {
+    device_pose_ = DevicePose::FromDeserializer(*deserializer_);
+    device_pose_parsed_ = true;
+    ReleaseXmpIfParsed();
+  }
+  return device_pose_.get();
+}
+
+const Profiles* Device::GetProfiles() const {
+  std::lock_guard<std::mutex> lock(elements_mutex_);
+  if (!profiles_parsed_) {
+    profiles_ = Profiles::FromDeserializer(*deserializer_);
+    profiles_parsed_ = true;
+    ReleaseXmpIfParsed();
+  }
+  return profiles_.get();
+}
+
+void Device::ReleaseXmpIfParsed() const {
+  if (cameras_parsed_ && device_pose_parsed_ && profiles_parsed_) {
+    // Undecoded image and audio data keep their own reference to the XMP.
+    deserializer_.reset();
+    xmp_.reset();
+  }
+}
 
 // This cannot be const because of memory management for the namespaces.
 // namespaces_ are freed when the XML document(s) in xmp are freed.
@@ -114,6 +170,11 @@ bool Device::SerializeToXmp(XmpData* xmp) {
   xmlNodePtr device_node = xmlNewNode(nullptr, ToXmlChar(XdmConst::Device()));
   xmlAddChild(root_node, device_node);
 
+  // Parse any elements that have not been read yet.
+  const DevicePose* device_pose = GetDevicePose();
+  const Profiles* profiles = GetProfiles();
+  const Cameras* cameras = GetCameras();
+
   PopulateNamespaces();
   xmlNsPtr prev_ns = root_node->ns;
   for (const auto& entry : namespaces_) {
@@ -133,19 +194,19 @@ bool Device::SerializeToXmp(XmpData* xmp) {
   }
 
   // Serialize elements.
-  if (device_pose_) {
+  if (device_pose) {
     std::unique_ptr<Serializer> pose_serializer =
         device_serializer.CreateSerializer(
             XdmConst::Namespace(XdmConst::DevicePose()),
             XdmConst::DevicePose());
-    if (!device_pose_->Serialize(pose_serializer.get())) {
+    if (!device_pose->Serialize(pose_serializer.get())) {
       return false;
     }
   }
-  if (profiles_ && !profiles_->Serialize(&device_serializer)) {
+  if (profiles && !profiles->Serialize(&device_serializer)) {
     return false;
   }
-  if (cameras_ && !cameras_->Serialize(&device_serializer)) {
+  if (cameras && !cameras->Serialize(&device_serializer)) {
     return false;
   }
 
@@ -163,18 +224,20 @@ void Device::GetNamespaces(
   }
   ns_name_href_map->emplace(XmlConst::RdfPrefix(), XmlConst::RdfNodeNs());
   ns_name_href_map->emplace(XdmConst::Device(), kNamespaceHref);
-  if (device_pose_) {
+  // GetNamespaces is not const on the elements.
+  if (GetDevicePose()) {
     device_pose_->GetNamespaces(ns_name_href_map);
   }
-  if (profiles_) {
+  if (GetProfiles()) {
     profiles_->GetNamespaces(ns_name_href_map);
   }
-  if (cameras_) {
+  if (GetCameras()) {
     cameras_->GetNamespaces(ns_name_href_map);
   }
 }
 
-bool Device::ParseFields(const XmpData& xmp) {
+bool Device::ParseFields(const XmpData& xmp,
+                         const std::shared_ptr<const XmpData>& source) {
   if (xmp.ExtendedSection() == nullptr) {
     LOG(ERROR) << "XMP extended section is null";
     return false;
@@ -189,16 +252,15 @@ bool Device::ParseFields(const XmpData& xmp) {
     LOG(ERROR) << "No device node found";
     return false;
   }
-  const DeserializerImpl deserializer(device_node);
-  if (!deserializer.ParseString(XdmConst::Device(), kRevision, &revision_)) {
+  deserializer_.reset(new DeserializerImpl(device_node, source));
+  if (!deserializer_->ParseString(XdmConst::Device(), kRevision, &revision_)) {
     return false;
   }
 
-  // XDM elements.
-  cameras_ = Cameras::FromDeserializer(deserializer);
-  device_pose_ = DevicePose::FromDeserializer(deserializer);
-  profiles_ = Profiles::FromDeserializer(deserializer);
-
+  // XDM elements are parsed by their getters.
+  cameras_parsed_ = false;
+  device_pose_parsed_ = false;
+  profiles_parsed_ = false;
   return true;
 }
 
@@ -0,0 +1,63 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/device.h"
+
+#include <libxml/parser.h>
+
+#include <memory>
+#include <string>
+
+#include "glog/logging.h"
+#include "xmpmeta/benchmark.h"
+#include "xmpmeta/file.h"
+#include "xmpmeta/xmp_data.h"
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+// Measures the time and allocations of Device::FromXmp on the XDM device
+// fixture, then of reading the pose, profiles and each camera's audio mime.
+void BM_DeviceFromXmp() {
+  string xml;
+  ReadFileToStringOrDie(BenchmarkDataPath("xdm/device_testdata.txt"), &xml);
+  // Device reads the extended section, but requires both.
+  XmpData xmp;
+  *xmp.MutableStandardSection() =
+      xmlReadMemory(xml.data(), xml.size(), nullptr, nullptr, 0);
+  *xmp.MutableExtendedSection() =
+      xmlReadMemory(xml.data(), xml.size(), nullptr, nullptr, 0);
+  CHECK(xmp.StandardSection() != nullptr);
+  CHECK(xmp.ExtendedSection() != nullptr);
+
+  RunBenchmarkCase("DeviceFromXmp", xml.size(), 0, [&]() {
+    std::unique_ptr<Device> device = Device::FromXmp(xmp);
+    CHECK(device != nullptr);
+  });
+  RunBenchmarkCase("DeviceFromXmp/ReadElements", xml.size(), 0, [&]() {
+    std::unique_ptr<Device> device = Device::FromXmp(xmp);
+    CHECK(device != nullptr);
+    DoNotOptimize(device->GetDevicePose());
+    DoNotOptimize(device->GetProfiles());
+    for (const Camera* camera : device->GetCameras()->GetCameras()) {
+      DoNotOptimize(camera->GetAudio()->GetMime());
+    }
+  });
+}
+XMPMETA_BENCHMARK(BM_DeviceFromXmp);
+
+}  // namespace
+}  // namespace xdm
+}  // namespace xmpmeta
@@ -308,6 +308,53 @@ TEST(Device, ReadMetadata) {
   xmlFreeNs(rdf_ns);
 }
 
+TEST(Device, ReadMetadataLazily) {
+  std::vector<std::unique_ptr<Camera>> camera_list;
+  camera_list.emplace_back(CreateCamera());
+  camera_list.emplace_back(CreateCamera());
+  std::unique_ptr<Device> device =
+      Device::FromData("1.01", CreateDevicePose(), CreateProfiles(),
+                       Cameras::FromCameraArray(&camera_list));
+  ASSERT_NE(nullptr, device);
+  std::unique_ptr<XmpData> xmp_data = CreateXmpData(true);
+  ASSERT_TRUE(device->SerializeToXmp(xmp_data.get()));
+
+  // The Device keeps the XMP data to parse its elements from.
+  std::unique_ptr<Device> lazy_device = Device::FromXmp(std::move(xmp_data));
+  ASSERT_NE(nullptr, lazy_device);
+  EXPECT_EQ("1.01", lazy_device->GetRevision());
+
+  const Profiles* profiles = lazy_device->GetProfiles();
+  ASSERT_NE(nullptr, profiles);
+  EXPECT_EQ(profiles, lazy_device->GetProfiles());
+  ASSERT_EQ(1, profiles->GetProfiles().size());
+  ExpectProfileEquals(*CreateVrPhotoProfile(), *profiles->GetProfiles()[0]);
+
+  const DevicePose* pose = lazy_device->GetDevicePose();
+  ASSERT_NE(nullptr, pose);
+  EXPECT_EQ(3, pose->GetPosition().size());
+
+  // Serializing parses the elements that were not read yet. The Device then
+  // releases the XMP, which the undecoded audio data keeps alive.
+  std::unique_ptr<XmpData> new_xmp_data = CreateXmpData(true);
+  ASSERT_TRUE(lazy_device->SerializeToXmp(new_xmp_data.get()));
+  std::unique_ptr<Device> read_device = Device::FromXmp(*new_xmp_data);
+  ASSERT_NE(nullptr, read_device);
+  for (const Device* current : {lazy_device.get(), read_device.get()}) {
+    const Cameras* cameras = current->GetCameras();
+    ASSERT_NE(nullptr, cameras);
+    ASSERT_EQ(2, cameras->GetCameras().size());
+    for (const Camera* camera : cameras->GetCameras()) {
+      ASSERT_NE(nullptr, camera->GetAudio());
+      EXPECT_EQ(kMediaData, camera->GetAudio()->GetData());
+    }
+  }
+}
+
+TEST(Device, FromNullXmp) {
+  EXPECT_EQ(nullptr, Device::FromXmp(std::unique_ptr<XmpData>()));
+}
+
 }  // namespace
 }  // namespace xdm
 }  // namespace xmpmeta
@@ -16,7 +16,6 @@
 
 #include "glog/logging.h"
 #include "xdmlib/const.h"
-#include "xmpmeta/base64.h"
 
 using xmpmeta::xml::Deserializer;
 using xmpmeta::xml::Serializer;
@@ -52,7 +51,7 @@ std::unique_ptr<Image> Image::FromData(const string& data,
     return nullptr;
   }
   std::unique_ptr<Image> image(new Image());
-  image->data_ = data;
+  image->data_.SetData(data);
   image->mime_ = mime;
   return image;
 }
@@ -72,7 +71,7 @@ Image::FromDeserializer(const Deserializer& parent_deserializer) {
   return image;
 }
 
-const string& Image::GetData() const { return data_; }
+const string& Image::GetData() const { return data_.GetData(); }
 
 const string& Image::GetMime() const { return mime_; }
 
@@ -82,7 +81,7 @@ bool Image::Serialize(Serializer* serializer) const {
     return false;
   }
   string base64_encoded;
-  if (!EncodeBase64(data_, &base64_encoded)) {
+  if (!data_.GetBase64(&base64_encoded)) {
     return false;
   }
   if (!serializer->WriteProperty(XdmConst::Image(), kMime, mime_)) {
@@ -96,7 +95,7 @@ bool Image::ParseImageFields(const Deserializer& deserializer) {
   if (!deserializer.ParseString(XdmConst::Image(), kMime, &mime_)) {
     return false;
   }
-  return deserializer.ParseBase64(XdmConst::Image(), kData , &data_);
+  return data_.ParseFrom(deserializer, XdmConst::Image(), kData);
 }
 
 }  // namespace xdm
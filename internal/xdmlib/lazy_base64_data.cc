@@ -0,0 +1,97 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/lazy_base64_data.h"
+
+#include <utility>
+
+#include "glog/logging.h"
+#include "xmpmeta/base64.h"
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+// Decodes the given base64 text, appending the bytes to data unless it is
+// null. ParseFrom and GetData both use this, so data that ParseFrom accepts
+// always decodes.
+bool Decode(const xml::PropertyValue& base64, string* data) {
+  Base64Decoder decoder([data](const char* bytes, size_t size) {
+    if (data != nullptr) {
+      data->append(bytes, size);
+    }
+    return true;
+  });
+  return decoder.Update(base64.data(), base64.size()) && decoder.Finish();
+}
+
+}  // namespace
+
+LazyBase64Data::LazyBase64Data() : decoded_(true) {}
+
+void LazyBase64Data::SetData(const string& data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  data_ = data;
+  base64_ = xml::PropertyValue();
+  decoded_ = true;
+}
+
+bool LazyBase64Data::ParseFrom(const xml::Deserializer& deserializer,
+                               const string& prefix, const string& name) {
+  xml::PropertyValue base64;
+  if (!deserializer.ParseString(prefix, name, &base64)) {
+    return false;
+  }
+  // Borrowed text may not outlive the deserializer's document unless it keeps
+  // the document alive, so decode it now in that case.
+  const bool decode = !base64.self_contained();
+  string data;
+  if (decode) {
+    data.reserve(MaxDecodedBase64Size(base64.size()));
+  }
+  if (!Decode(base64, decode ? &data : nullptr)) {
+    LOG(ERROR) << name << " is not valid base64";
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  data_.swap(data);
+  base64_ = decode ? xml::PropertyValue() : std::move(base64);
+  decoded_ = decode;
+  return true;
+}
+
+const string& LazyBase64Data::GetData() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!decoded_) {
+    data_.reserve(MaxDecodedBase64Size(base64_.size()));
+    // ParseFrom checked that the data is valid.
+    Decode(base64_, &data_);
+    // Release the encoded text and its source.
+    base64_ = xml::PropertyValue();
+    decoded_ = true;
+  }
+  return data_;
+}
+
+bool LazyBase64Data::GetBase64(string* base64) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!decoded_) {
+    *base64 = base64_.ToString();
+    return true;
+  }
+  return EncodeBase64(data_, base64);
+}
+
+}  // namespace xdm
+}  // namespace xmpmeta
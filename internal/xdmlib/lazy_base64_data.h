@@ -0,0 +1,69 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XDM_LAZY_BASE64_DATA_H_
+#define XMPMETA_XDM_LAZY_BASE64_DATA_H_
+
+#include <mutex>
+#include <string>
+
+#include "xmpmeta/xml/deserializer.h"
+#include "xmpmeta/xml/property_value.h"
+
+namespace xmpmeta {
+namespace xdm {
+
+// Binary data that is stored base64-encoded in XMP, such as the payload of an
+// Image or Audio element. Data parsed from XMP is kept encoded until it is
+// first read, so elements whose data is never read do not pay for decoding
+// it, and serializing them writes the encoded data back as is.
+class LazyBase64Data {
+ public:
+  LazyBase64Data();
+
+  // Replaces the contents with the given raw data.
+  void SetData(const string& data);
+
+  // Reads the encoded data of the given property. The text is borrowed from
+  // the XMP and decoded on the first call to GetData() if the deserializer
+  // shares ownership of its document (see DeserializerImpl), and is decoded
+  // right away otherwise. Returns false if the property is missing or is not
+  // valid base64.
+  bool ParseFrom(const xml::Deserializer& deserializer, const string& prefix,
+                 const string& name);
+
+  // Returns the raw data, decoding it first if needed. Safe to call from
+  // several threads.
+  const string& GetData() const;
+
+  // Sets base64 to the encoded data. Returns false if encoding fails.
+  bool GetBase64(string* base64) const;
+
+  // Disallow copying.
+  LazyBase64Data(const LazyBase64Data&) = delete;
+  void operator=(const LazyBase64Data&) = delete;
+
+ private:
+  // Guards the decoding of base64_ into data_.
+  mutable std::mutex mutex_;
+  mutable bool decoded_;
+  mutable string data_;  // The raw data, once decoded.
+  // The encoded data, until decoded. Keeps its source alive.
+  mutable xml::PropertyValue base64_;
+};
+
+}  // namespace xdm
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XDM_LAZY_BASE64_DATA_H_
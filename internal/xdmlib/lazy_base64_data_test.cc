@@ -0,0 +1,122 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/lazy_base64_data.h"
+
+#include <libxml/tree.h>
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/utils.h"
+
+using xmpmeta::xml::DeserializerImpl;
+using xmpmeta::xml::ToXmlChar;
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+const char kPrefix[] = "Image";
+const char kNamespaceHref[] = "http://notarealh.ref";
+
+// Returns a node with an Image:Data property of the given value. The node is
+// freed along with the last reference to it.
+std::shared_ptr<xmlNode> CreateNode(const string& value) {
+  xmlNodePtr node = xmlNewNode(nullptr, ToXmlChar("Node"));
+  xmlNsPtr ns = xmlNewNs(nullptr, ToXmlChar(kNamespaceHref),
+                         ToXmlChar(kPrefix));
+  xmlSetNsProp(node, ns, ToXmlChar("Data"), ToXmlChar(value.data()));
+  return std::shared_ptr<xmlNode>(node, [ns](xmlNodePtr node) {
+    xmlFreeNode(node);
+    xmlFreeNs(ns);
+  });
+}
+
+TEST(LazyBase64Data, SetData) {
+  LazyBase64Data data;
+  EXPECT_EQ("", data.GetData());
+  data.SetData("123ABC");
+  EXPECT_EQ("123ABC", data.GetData());
+  string base64;
+  ASSERT_TRUE(data.GetBase64(&base64));
+  EXPECT_EQ("MTIzQUJD", base64);
+}
+
+TEST(LazyBase64Data, ParseFrom) {
+  LazyBase64Data data;
+  std::shared_ptr<xmlNode> node = CreateNode("MTIz\nQUJD");
+  std::weak_ptr<xmlNode> weak_node = node;
+  {
+    DeserializerImpl deserializer(node.get(), node);
+    ASSERT_TRUE(data.ParseFrom(deserializer, kPrefix, "Data"));
+  }
+  // The data points into the node, and keeps it alive until it is decoded.
+  node.reset();
+  EXPECT_FALSE(weak_node.expired());
+  // The encoded data is written back as is until it is decoded.
+  string base64;
+  ASSERT_TRUE(data.GetBase64(&base64));
+  EXPECT_EQ("MTIz\nQUJD", base64);
+
+  EXPECT_EQ("123ABC", data.GetData());
+  EXPECT_TRUE(weak_node.expired());
+  ASSERT_TRUE(data.GetBase64(&base64));
+  EXPECT_EQ("MTIzQUJD", base64);
+
+  data.SetData("xyz");
+  EXPECT_EQ("xyz", data.GetData());
+}
+
+TEST(LazyBase64Data, ParseFromWithoutSource) {
+  LazyBase64Data data;
+  std::shared_ptr<xmlNode> node = CreateNode("MTIz\nQUJD");
+  DeserializerImpl deserializer(node.get());
+  ASSERT_TRUE(data.ParseFrom(deserializer, kPrefix, "Data"));
+  // The node may be freed, so the data is decoded right away.
+  node.reset();
+  string base64;
+  ASSERT_TRUE(data.GetBase64(&base64));
+  EXPECT_EQ("MTIzQUJD", base64);
+  EXPECT_EQ("123ABC", data.GetData());
+}
+
+TEST(LazyBase64Data, ParseFromMissingProperty) {
+  LazyBase64Data data;
+  data.SetData("xyz");
+  xmlNodePtr node = xmlNewNode(nullptr, ToXmlChar("Node"));
+  DeserializerImpl deserializer(node);
+  EXPECT_FALSE(data.ParseFrom(deserializer, kPrefix, "Data"));
+  EXPECT_EQ("xyz", data.GetData());
+  xmlFreeNode(node);
+}
+
+TEST(LazyBase64Data, ParseFromInvalidBase64) {
+  for (const char* value : {"MTIz*UJD", "MTIzQ"}) {
+    std::shared_ptr<xmlNode> node = CreateNode(value);
+    LazyBase64Data data;
+    data.SetData("xyz");
+    EXPECT_FALSE(data.ParseFrom(DeserializerImpl(node.get(), node), kPrefix,
+                                "Data"));
+    EXPECT_FALSE(data.ParseFrom(DeserializerImpl(node.get()), kPrefix,
+                                "Data"));
+    EXPECT_EQ("xyz", data.GetData());
+  }
+}
+
+}  // namespace
+}  // namespace xdm
+}  // namespace xmpmeta
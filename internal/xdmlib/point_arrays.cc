@@ -0,0 +1,282 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/point_arrays.h"
+
+#include <algorithm>
+#include <cmath>
+
+// SSE2 is part of the x86-64 baseline, so no runtime check is needed. Other
+// targets use the portable loops.
+#if defined(__SSE2__) || defined(_M_X64)
+#define XDM_POINT_ARRAYS_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "glog/logging.h"
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+// The reduction kernels keep this many independent accumulators: two 4-float
+// vectors, which hides the latency of the vector adds.
+const size_t kLanes = 8;
+
+// The number of points summed in single precision before the sums are added
+// to the double precision totals.
+const size_t kSumBlockSize = 1024;
+
+// Returns the number of floats to reserve for an array of size floats so that
+// the next array starts on an aligned boundary.
+size_t PaddedSize(size_t size) {
+  const size_t floats_per_alignment = AlignedBuffer::kAlignment / sizeof(float);
+  return (size + floats_per_alignment - 1) / floats_per_alignment *
+      floats_per_alignment;
+}
+
+// Updates the per-lane minimums, maximums and sums with the given values.
+// size must be a multiple of kLanes, and values aligned to kLanes floats.
+void AccumulateLanes(const float* values, size_t size, float* lane_min,
+                     float* lane_max, float* lane_sum) {
+#ifdef XDM_POINT_ARRAYS_SSE2
+  __m128 min0 = _mm_loadu_ps(lane_min);
+  __m128 min1 = _mm_loadu_ps(lane_min + 4);
+  __m128 max0 = _mm_loadu_ps(lane_max);
+  __m128 max1 = _mm_loadu_ps(lane_max + 4);
+  __m128 sum0 = _mm_loadu_ps(lane_sum);
+  __m128 sum1 = _mm_loadu_ps(lane_sum + 4);
+  for (size_t i = 0; i < size; i += kLanes) {
+    const __m128 values0 = _mm_load_ps(values + i);
+    const __m128 values1 = _mm_load_ps(values + i + 4);
+    min0 = _mm_min_ps(min0, values0);
+    min1 = _mm_min_ps(min1, values1);
+    max0 = _mm_max_ps(max0, values0);
+    max1 = _mm_max_ps(max1, values1);
+    sum0 = _mm_add_ps(sum0, values0);
+    sum1 = _mm_add_ps(sum1, values1);
+  }
+  _mm_storeu_ps(lane_min, min0);
+  _mm_storeu_ps(lane_min + 4, min1);
+  _mm_storeu_ps(lane_max, max0);
+  _mm_storeu_ps(lane_max + 4, max1);
+  _mm_storeu_ps(lane_sum, sum0);
+  _mm_storeu_ps(lane_sum + 4, sum1);
+#else
+  for (size_t i = 0; i < size; i += kLanes) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      const float value = values[i + lane];
+      lane_min[lane] = std::min(lane_min[lane], value);
+      lane_max[lane] = std::max(lane_max[lane], value);
+      lane_sum[lane] += value;
+    }
+  }
+#endif
+}
+
+// The bounds and sum of the values of one coordinate.
+struct Extent {
+  float min;
+  float max;
+  double sum;
+};
+
+// Computes the extent of the values in a single pass. values must be aligned
+// to kLanes floats.
+Extent GetExtent(const float* values, size_t size) {
+  float lane_min[kLanes];
+  float lane_max[kLanes];
+  std::fill(lane_min, lane_min + kLanes, values[0]);
+  std::fill(lane_max, lane_max + kLanes, values[0]);
+  double sum = 0;
+  for (size_t block = 0; block < size; block += kSumBlockSize) {
+    const size_t block_size = std::min(size - block, kSumBlockSize);
+    const size_t lanes_size = block_size / kLanes * kLanes;
+    float lane_sum[kLanes] = {};
+    AccumulateLanes(values + block, lanes_size, lane_min, lane_max, lane_sum);
+    for (size_t i = block + lanes_size; i < block + block_size; ++i) {
+      lane_min[0] = std::min(lane_min[0], values[i]);
+      lane_max[0] = std::max(lane_max[0], values[i]);
+      lane_sum[0] += values[i];
+    }
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      sum += lane_sum[lane];
+    }
+  }
+  Extent extent;
+  extent.min = *std::min_element(lane_min, lane_min + kLanes);
+  extent.max = *std::max_element(lane_max, lane_max + kLanes);
+  extent.sum = sum;
+  return extent;
+}
+
+// Sets each point p to m * p + t, where m is a row-major 3x3 matrix. The
+// arrays must be aligned to 4 floats.
+void TransformPoints(const float* m, const float* t, size_t size, float* x,
+                     float* y, float* z) {
+  size_t i = 0;
+#ifdef XDM_POINT_ARRAYS_SSE2
+  __m128 mv[9];
+  for (int k = 0; k < 9; ++k) {
+    mv[k] = _mm_set1_ps(m[k]);
+  }
+  const __m128 tx = _mm_set1_ps(t[0]);
+  const __m128 ty = _mm_set1_ps(t[1]);
+  const __m128 tz = _mm_set1_ps(t[2]);
+  for (; i + 4 <= size; i += 4) {
+    const __m128 px = _mm_load_ps(x + i);
+    const __m128 py = _mm_load_ps(y + i);
+    const __m128 pz = _mm_load_ps(z + i);
+    _mm_store_ps(x + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(mv[0], px),
+                                              _mm_mul_ps(mv[1], py)),
+                                   _mm_add_ps(_mm_mul_ps(mv[2], pz), tx)));
+    _mm_store_ps(y + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(mv[3], px),
+                                              _mm_mul_ps(mv[4], py)),
+                                   _mm_add_ps(_mm_mul_ps(mv[5], pz), ty)));
+    _mm_store_ps(z + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(mv[6], px),
+                                              _mm_mul_ps(mv[7], py)),
+                                   _mm_add_ps(_mm_mul_ps(mv[8], pz), tz)));
+  }
+#endif
+  for (; i < size; ++i) {
+    const float px = x[i];
+    const float py = y[i];
+    const float pz = z[i];
+    x[i] = (m[0] * px + m[1] * py) + (m[2] * pz + t[0]);
+    y[i] = (m[3] * px + m[4] * py) + (m[5] * pz + t[1]);
+    z[i] = (m[6] * px + m[7] * py) + (m[8] * pz + t[2]);
+  }
+}
+
+}  // namespace
+
+// Private constructor.
+PointArrays::PointArrays()
+    : size_(0), x_(nullptr), y_(nullptr), z_(nullptr) {}
+
+// Public methods.
+std::unique_ptr<PointArrays>
+PointArrays::FromPositions(const PointCloudView<PointPosition>& positions) {
+  if (positions.empty()) {
+    LOG(ERROR) << "No positions given";
+    return nullptr;
+  }
+  std::unique_ptr<PointArrays> arrays(new PointArrays());
+  const size_t size = positions.size();
+  const size_t padded_size = PaddedSize(size);
+  arrays->size_ = size;
+  arrays->buffer_.Allocate(3 * padded_size * sizeof(float));
+  arrays->x_ = reinterpret_cast<float*>(arrays->buffer_.data());
+  arrays->y_ = arrays->x_ + padded_size;
+  arrays->z_ = arrays->y_ + padded_size;
+
+  float* x = arrays->x_;
+  float* y = arrays->y_;
+  float* z = arrays->z_;
+  for (size_t i = 0; i < size; ++i) {
+    x[i] = positions[i].x;
+    y[i] = positions[i].y;
+    z[i] = positions[i].z;
+  }
+  return arrays;
+}
+
+PointPosition PointArrays::GetPosition(size_t index) const {
+  return PointPosition{x_[index], y_[index], z_[index]};
+}
+
+void PointArrays::GetBounds(PointPosition* min, PointPosition* max) const {
+  GetBoundsAndCentroid(min, max, nullptr);
+}
+
+PointPosition PointArrays::GetCentroid() const {
+  PointPosition centroid;
+  GetBoundsAndCentroid(nullptr, nullptr, &centroid);
+  return centroid;
+}
+
+void PointArrays::GetBoundsAndCentroid(PointPosition* min, PointPosition* max,
+                                       PointPosition* centroid) const {
+  const Extent x = GetExtent(x_, size_);
+  const Extent y = GetExtent(y_, size_);
+  const Extent z = GetExtent(z_, size_);
+  if (min != nullptr) {
+    *min = PointPosition{x.min, y.min, z.min};
+  }
+  if (max != nullptr) {
+    *max = PointPosition{x.max, y.max, z.max};
+  }
+  if (centroid != nullptr) {
+    *centroid = PointPosition{static_cast<float>(x.sum / size_),
+                              static_cast<float>(y.sum / size_),
+                              static_cast<float>(z.sum / size_)};
+  }
+}
+
+bool PointArrays::Transform(const std::vector<double>& rotation_xyz_angle,
+                            const std::vector<double>& translation) {
+  if (!rotation_xyz_angle.empty() && rotation_xyz_angle.size() != 4) {
+    LOG(ERROR) << "Rotation must be an axis and an angle";
+    return false;
+  }
+  if (!translation.empty() && translation.size() != 3) {
+    LOG(ERROR) << "Translation must have three coordinates";
+    return false;
+  }
+
+  // Identity rotation by default.
+  double matrix[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  if (!rotation_xyz_angle.empty()) {
+    const double length = sqrt(rotation_xyz_angle[0] * rotation_xyz_angle[0] +
+                               rotation_xyz_angle[1] * rotation_xyz_angle[1] +
+                               rotation_xyz_angle[2] * rotation_xyz_angle[2]);
+    if (!(length > 0)) {
+      LOG(ERROR) << "Rotation axis is zero";
+      return false;
+    }
+    // Rodrigues' rotation formula.
+    const double ux = rotation_xyz_angle[0] / length;
+    const double uy = rotation_xyz_angle[1] / length;
+    const double uz = rotation_xyz_angle[2] / length;
+    const double c = cos(rotation_xyz_angle[3]);
+    const double s = sin(rotation_xyz_angle[3]);
+    const double t = 1 - c;
+    const double rotation[9] = {
+      t * ux * ux + c,      t * ux * uy - s * uz, t * ux * uz + s * uy,
+      t * ux * uy + s * uz, t * uy * uy + c,      t * uy * uz - s * ux,
+      t * ux * uz - s * uy, t * uy * uz + s * ux, t * uz * uz + c,
+    };
+    std::copy(rotation, rotation + 9, matrix);
+  }
+
+  // Single precision coefficients, so the kernel stays in floats.
+  float m[9];
+  std::copy(matrix, matrix + 9, m);
+  float t[3] = {0, 0, 0};
+  std::copy(translation.begin(), translation.end(), t);
+  TransformPoints(m, t, size_, x_, y_, z_);
+  return true;
+}
+
+string PointArrays::ToPositionData() const {
+  string data(size_ * sizeof(PointPosition), '\0');
+  PointPosition* positions = reinterpret_cast<PointPosition*>(&data[0]);
+  for (size_t i = 0; i < size_; ++i) {
+    positions[i] = GetPosition(i);
+  }
+  return data;
+}
+
+}  // namespace xdm
+}  // namespace xmpmeta
@@ -0,0 +1,135 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/point_arrays.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "xmpmeta/benchmark.h"
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+const std::vector<double> kRotation = {0.0, 0.6, 0.8, 0.5};
+const std::vector<double> kTranslation = {1.0, -2.0, 0.5};
+
+std::vector<PointPosition> CreatePositions(size_t count) {
+  std::vector<PointPosition> positions;
+  positions.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    positions.push_back(PointPosition{static_cast<float>(i % 1000),
+                                      static_cast<float>(i % 777) - 300,
+                                      static_cast<float>(i % 13) * 0.5f});
+  }
+  return positions;
+}
+
+// The array-of-structs loop that PointArrays::GetBoundsAndCentroid replaces.
+void GetBoundsAndCentroidOfStructs(const std::vector<PointPosition>& positions,
+                                   PointPosition* min, PointPosition* max,
+                                   PointPosition* centroid) {
+  *min = *max = positions[0];
+  double sum_x = 0;
+  double sum_y = 0;
+  double sum_z = 0;
+  for (const PointPosition& position : positions) {
+    min->x = std::min(min->x, position.x);
+    min->y = std::min(min->y, position.y);
+    min->z = std::min(min->z, position.z);
+    max->x = std::max(max->x, position.x);
+    max->y = std::max(max->y, position.y);
+    max->z = std::max(max->z, position.z);
+    sum_x += position.x;
+    sum_y += position.y;
+    sum_z += position.z;
+  }
+  const double count = positions.size();
+  *centroid = PointPosition{static_cast<float>(sum_x / count),
+                            static_cast<float>(sum_y / count),
+                            static_cast<float>(sum_z / count)};
+}
+
+// The array-of-structs loop that PointArrays::Transform replaces: rotates by
+// the axis-angle kRotation with Rodrigues' formula, then translates.
+void TransformStructs(std::vector<PointPosition>* positions) {
+  const double norm = std::sqrt(kRotation[0] * kRotation[0] +
+                                kRotation[1] * kRotation[1] +
+                                kRotation[2] * kRotation[2]);
+  const double x = kRotation[0] / norm;
+  const double y = kRotation[1] / norm;
+  const double z = kRotation[2] / norm;
+  const double c = std::cos(kRotation[3]);
+  const double s = std::sin(kRotation[3]);
+  const double t = 1 - c;
+  const float m[9] = {
+      static_cast<float>(t * x * x + c), static_cast<float>(t * x * y - s * z),
+      static_cast<float>(t * x * z + s * y),
+      static_cast<float>(t * x * y + s * z), static_cast<float>(t * y * y + c),
+      static_cast<float>(t * y * z - s * x),
+      static_cast<float>(t * x * z - s * y),
+      static_cast<float>(t * y * z + s * x), static_cast<float>(t * z * z + c)};
+  const float dx = static_cast<float>(kTranslation[0]);
+  const float dy = static_cast<float>(kTranslation[1]);
+  const float dz = static_cast<float>(kTranslation[2]);
+  for (PointPosition& p : *positions) {
+    const PointPosition r = p;
+    p.x = m[0] * r.x + m[1] * r.y + m[2] * r.z + dx;
+    p.y = m[3] * r.x + m[4] * r.y + m[5] * r.z + dy;
+    p.z = m[6] * r.x + m[7] * r.y + m[8] * r.z + dz;
+  }
+}
+
+// Measures points per second for the bounds and centroid, and for a pose
+// transform, over synthetic clouds of 10K to 10M points, both with a scalar
+// loop over the PointCloud layout and with PointArrays.
+void BM_PointArrays() {
+  for (size_t count : {10000, 1000000, 10000000}) {
+    const string suffix = "/" + std::to_string(count / 1000) + "K";
+    std::vector<PointPosition> positions = CreatePositions(count);
+    std::unique_ptr<PointArrays> arrays = PointArrays::FromPositions(
+        PointCloudView<PointPosition>(positions.data(), positions.size()));
+    CHECK(arrays != nullptr);
+
+    PointPosition min;
+    PointPosition max;
+    PointPosition centroid;
+    RunBenchmarkCase("BoundsAndCentroid/Structs" + suffix, 0, count, [&]() {
+      GetBoundsAndCentroidOfStructs(positions, &min, &max, &centroid);
+      DoNotOptimize(centroid);
+    });
+    RunBenchmarkCase("BoundsAndCentroid/PointArrays" + suffix, 0, count, [&]() {
+      arrays->GetBoundsAndCentroid(&min, &max, &centroid);
+      DoNotOptimize(centroid);
+    });
+    RunBenchmarkCase("Transform/Structs" + suffix, 0, count, [&]() {
+      TransformStructs(&positions);
+      DoNotOptimize(positions);
+    });
+    RunBenchmarkCase("Transform/PointArrays" + suffix, 0, count, [&]() {
+      CHECK(arrays->Transform(kRotation, kTranslation));
+      DoNotOptimize(arrays);
+    });
+  }
+}
+XMPMETA_BENCHMARK(BM_PointArrays);
+
+}  // namespace
+}  // namespace xdm
+}  // namespace xmpmeta
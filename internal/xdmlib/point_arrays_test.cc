@@ -0,0 +1,151 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/point_arrays.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+// Returns count points that are not a multiple of the kernels' lane count, so
+// that the tail loops run too.
+std::vector<PointPosition> CreatePositions(int count) {
+  std::vector<PointPosition> positions;
+  for (int i = 0; i < count; ++i) {
+    positions.push_back(PointPosition{static_cast<float>(i),
+                                      static_cast<float>(-2 * i),
+                                      static_cast<float>((i * 7) % 11)});
+  }
+  return positions;
+}
+
+std::unique_ptr<PointArrays> CreateArrays(
+    const std::vector<PointPosition>& positions) {
+  return PointArrays::FromPositions(
+      PointCloudView<PointPosition>(positions.data(), positions.size()));
+}
+
+bool IsAligned(const float* data) {
+  return reinterpret_cast<uintptr_t>(data) % AlignedBuffer::kAlignment == 0;
+}
+
+TEST(PointArrays, FromPositions) {
+  const std::vector<PointPosition> positions = CreatePositions(37);
+  std::unique_ptr<PointArrays> arrays = CreateArrays(positions);
+  ASSERT_NE(nullptr, arrays);
+  ASSERT_EQ(positions.size(), arrays->size());
+  EXPECT_TRUE(IsAligned(arrays->x()));
+  EXPECT_TRUE(IsAligned(arrays->y()));
+  EXPECT_TRUE(IsAligned(arrays->z()));
+  EXPECT_EQ(-72.0f, arrays->y()[36]);
+  EXPECT_EQ(2.0f, arrays->GetPosition(5).z);
+
+  const string data = arrays->ToPositionData();
+  EXPECT_EQ(string(reinterpret_cast<const char*>(positions.data()),
+                   positions.size() * sizeof(PointPosition)),
+            data);
+}
+
+TEST(PointArrays, FromNoPositions) {
+  EXPECT_EQ(nullptr, PointArrays::FromPositions(
+      PointCloudView<PointPosition>()));
+}
+
+TEST(PointArrays, GetBoundsAndCentroid) {
+  std::unique_ptr<PointArrays> arrays = CreateArrays(CreatePositions(37));
+  ASSERT_NE(nullptr, arrays);
+  PointPosition min;
+  PointPosition max;
+  arrays->GetBounds(&min, &max);
+  EXPECT_EQ(0.0f, min.x);
+  EXPECT_EQ(36.0f, max.x);
+  EXPECT_EQ(-72.0f, min.y);
+  EXPECT_EQ(0.0f, max.y);
+  EXPECT_EQ(0.0f, min.z);
+  EXPECT_EQ(10.0f, max.z);
+
+  const PointPosition centroid = arrays->GetCentroid();
+  EXPECT_FLOAT_EQ(18.0f, centroid.x);
+  EXPECT_FLOAT_EQ(-36.0f, centroid.y);
+  double z_sum = 0;
+  for (int i = 0; i < 37; ++i) {
+    z_sum += (i * 7) % 11;
+  }
+  EXPECT_FLOAT_EQ(z_sum / 37, centroid.z);
+}
+
+TEST(PointArrays, CentroidOfManyPoints) {
+  // Enough points to span several single precision summation blocks.
+  const std::vector<PointPosition> positions(
+      100003, PointPosition{0.1f, 1000.5f, -3.25f});
+  std::unique_ptr<PointArrays> arrays = CreateArrays(positions);
+  ASSERT_NE(nullptr, arrays);
+  const PointPosition centroid = arrays->GetCentroid();
+  EXPECT_NEAR(0.1, centroid.x, 1e-6);
+  EXPECT_NEAR(1000.5, centroid.y, 1e-2);
+  EXPECT_NEAR(-3.25, centroid.z, 1e-5);
+}
+
+TEST(PointArrays, Transform) {
+  const std::vector<PointPosition> positions = CreatePositions(19);
+  std::unique_ptr<PointArrays> arrays = CreateArrays(positions);
+  ASSERT_NE(nullptr, arrays);
+
+  // A quarter turn about the z axis maps (x, y) to (-y, x).
+  ASSERT_TRUE(arrays->Transform({0, 0, 2, kPi / 2}, {1, 2, 3}));
+  for (size_t i = 0; i < positions.size(); ++i) {
+    const PointPosition position = arrays->GetPosition(i);
+    EXPECT_NEAR(-positions[i].y + 1, position.x, 1e-4) << i;
+    EXPECT_NEAR(positions[i].x + 2, position.y, 1e-4) << i;
+    EXPECT_NEAR(positions[i].z + 3, position.z, 1e-4) << i;
+  }
+}
+
+TEST(PointArrays, TransformWithoutRotationOrTranslation) {
+  const std::vector<PointPosition> positions = CreatePositions(9);
+  std::unique_ptr<PointArrays> arrays = CreateArrays(positions);
+  ASSERT_NE(nullptr, arrays);
+
+  ASSERT_TRUE(arrays->Transform({}, {}));
+  EXPECT_EQ(-16.0f, arrays->GetPosition(8).y);
+
+  ASSERT_TRUE(arrays->Transform({}, {0.5, 0, 0}));
+  EXPECT_EQ(8.5f, arrays->GetPosition(8).x);
+
+  ASSERT_TRUE(arrays->Transform({1, 0, 0, kPi}, {}));
+  EXPECT_NEAR(16.0, arrays->GetPosition(8).y, 1e-4);
+}
+
+TEST(PointArrays, TransformRejectsInvalidPose) {
+  std::unique_ptr<PointArrays> arrays = CreateArrays(CreatePositions(3));
+  ASSERT_NE(nullptr, arrays);
+  EXPECT_FALSE(arrays->Transform({0, 0, 1}, {}));
+  EXPECT_FALSE(arrays->Transform({0, 0, 0, 1}, {}));
+  EXPECT_FALSE(arrays->Transform({}, {1, 2}));
+  EXPECT_EQ(1.0f, arrays->GetPosition(1).x);
+}
+
+}  // namespace
+}  // namespace xdm
+}  // namespace xmpmeta
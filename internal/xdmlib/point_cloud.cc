@@ -14,13 +14,21 @@
 
 #include "xdmlib/point_cloud.h"
 
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 #include "glog/logging.h"
 #include "strings/numbers.h"
 #include "xdmlib/const.h"
+#include "xdmlib/point_cloud_codec.h"
+#include "xdmlib/point_cloud_index.h"
 #include "xmpmeta/base64.h"
+#include "xmpmeta/xml/property_value.h"
 #include "xmpmeta/xml/utils.h"
 
 using xmpmeta::xml::Deserializer;
+using xmpmeta::xml::PropertyValue;
 using xmpmeta::xml::Serializer;
 
 namespace xmpmeta {
@@ -33,13 +41,50 @@ const char kColor[] = "Color";
 const char kPosition[] = "Position";
 const char kMetric[] = "Metric";
 const char kSoftware[] = "Software";
+const char kPositionEncoding[] = "PositionEncoding";
+
+// The value of the PositionEncoding property for the encoding in
+// point_cloud_codec.h. Positions are raw floats if the property is absent.
+const char kQuantizedEncoding[] = "Quantized";
 
 const char kNamespaceHref[] = "http://ns.xdm.org/photos/1.0/pointcloud/";
 
+// Decodes the base64 property straight into data, without an intermediate
+// string. Returns false if the property is missing or not valid base64.
+bool ParseBase64ToString(const Deserializer& deserializer, const char* name,
+                         string* data) {
+  PropertyValue base64_data;
+  if (!deserializer.ParseString(XdmConst::PointCloud(), name, &base64_data)) {
+    return false;
+  }
+  data->resize(MaxDecodedBase64Size(base64_data.size()));
+  size_t decoded_size;
+  if (!DecodeBase64(base64_data.data(), base64_data.size(), &(*data)[0],
+                    data->size(), &decoded_size)) {
+    data->clear();
+    return false;
+  }
+  data->resize(decoded_size);
+  return true;
+}
+
+// Returns true if data holds count elements of type T, and its storage is
+// aligned for T.
+template <typename T>
+bool HoldsElements(const string& data, int count) {
+  return count >= 0 &&
+      data.size() == static_cast<size_t>(count) * sizeof(T) &&
+      reinterpret_cast<uintptr_t>(data.data()) % alignof(T) == 0;
+}
+
 }  // namespace
 
 // Private constructor.
-PointCloud::PointCloud() : count_(-1), metric_(false) { }
+PointCloud::PointCloud()
+    : count_(-1), metric_(false), position_bits_(0), positions_valid_(false),
+      colors_valid_(false) {}
+
+PointCloud::~PointCloud() {}
 
 // Public methods.
 void PointCloud::GetNamespaces(std::unordered_map<string,
@@ -54,17 +99,25 @@ void PointCloud::GetNamespaces(std::unordered_map<string,
 
 std::unique_ptr<PointCloud>
 PointCloud::FromData(int count, const string& position, const string& color,
-                     bool metric, const string& software) {
+                     bool metric, const string& software,
+                     const int position_bits) {
   if (position.empty()) {
     LOG(ERROR) << "No position data given";
     return nullptr;
   }
+  if (position_bits != 0 && (position_bits < kMinQuantizedPositionBits ||
+                             position_bits > kMaxQuantizedPositionBits)) {
+    LOG(ERROR) << "Invalid number of bits per coordinate: " << position_bits;
+    return nullptr;
+  }
   std::unique_ptr<PointCloud> point_cloud(new PointCloud());
   point_cloud->count_ = count;
   point_cloud->position_ = position;
   point_cloud->metric_ = metric;
   point_cloud->color_ = color;
   point_cloud->software_ = software;
+  point_cloud->position_bits_ = position_bits;
+  point_cloud->ValidateLayout();
   return point_cloud;
 }
 
@@ -89,6 +142,32 @@ const string& PointCloud::GetPosition() const { return position_; }
 const string& PointCloud::GetColor() const { return color_; }
 bool PointCloud::GetMetric() const { return metric_; }
 const string& PointCloud::GetSoftware() const { return software_; }
+int PointCloud::GetPositionBits() const { return position_bits_; }
+
+PointCloudView<PointPosition> PointCloud::GetPositions() const {
+  if (!positions_valid_) {
+    return PointCloudView<PointPosition>();
+  }
+  return PointCloudView<PointPosition>(
+      reinterpret_cast<const PointPosition*>(position_.data()), count_);
+}
+
+PointCloudView<PointColor> PointCloud::GetColors() const {
+  if (!colors_valid_) {
+    return PointCloudView<PointColor>();
+  }
+  return PointCloudView<PointColor>(
+      reinterpret_cast<const PointColor*>(color_.data()), count_);
+}
+
+const PointCloudIndex* PointCloud::GetIndex() const {
+  std::call_once(index_once_, [this]() {
+    if (positions_valid_) {
+      index_ = PointCloudIndex::FromPositions(GetPositions());
+    }
+  });
+  return index_.get();
+}
 
 bool PointCloud::Serialize(Serializer* serializer) const {
   if (serializer == nullptr) {
@@ -96,8 +175,44 @@ bool PointCloud::Serialize(Serializer* serializer) const {
     return false;
   }
 
+  // The compact encoding reorders the points, so the colors are reordered
+  // into reordered_color to match.
+  const char* position = position_.data();
+  size_t position_size = position_.size();
+  const char* color = color_.data();
+  size_t color_size = color_.size();
+  string encoded_position;
+  string reordered_color;
+  const bool quantized = position_bits_ != 0 && positions_valid_;
+  if (position_bits_ != 0 && !positions_valid_) {
+    LOG(WARNING) << "Writing raw positions, as the position data does not "
+                 << "hold " << count_ << " points";
+  }
+  if (quantized) {
+    std::vector<uint32_t> order;
+    if (!EncodeQuantizedPositions(GetPositions(), position_bits_,
+                                  &encoded_position, &order)) {
+      return false;
+    }
+    position = encoded_position.data();
+    position_size = encoded_position.size();
+    if (colors_valid_) {
+      const PointColor* colors = GetColors().data();
+      reordered_color.resize(color_size);
+      PointColor* reordered_colors =
+          reinterpret_cast<PointColor*>(&reordered_color[0]);
+      for (size_t i = 0; i < order.size(); ++i) {
+        reordered_colors[i] = colors[order[i]];
+      }
+      color = reordered_color.data();
+    } else if (!color_.empty()) {
+      LOG(WARNING) << "Not writing color data that does not match the points";
+      color_size = 0;
+    }
+  }
+
   string base64_encoded_position;
-  if (!EncodeBase64(position_, &base64_encoded_position)) {
+  if (!EncodeBase64(position, position_size, &base64_encoded_position)) {
     LOG(WARNING) << "Position encoding failed";
     return false;
   }
@@ -107,6 +222,11 @@ bool PointCloud::Serialize(Serializer* serializer) const {
                                                SimpleItoa(count_))) {
     return false;
   }
+  if (quantized && !serializer->WriteProperty(XdmConst::PointCloud(),
+                                              kPositionEncoding,
+                                              kQuantizedEncoding)) {
+    return false;
+  }
   if (!serializer->WriteProperty(XdmConst::PointCloud(), kPosition,
                                  base64_encoded_position)) {
     return false;
@@ -116,9 +236,9 @@ bool PointCloud::Serialize(Serializer* serializer) const {
   serializer->WriteBoolProperty(XdmConst::PointCloud(), kMetric,
                                 metric_);
 
-  if (!color_.empty()) {
+  if (color_size > 0) {
     string base64_encoded_color;
-    if (!EncodeBase64(color_, &base64_encoded_color)) {
+    if (!EncodeBase64(color, color_size, &base64_encoded_color)) {
       LOG(ERROR) << "Base64 encoding of color failed";
     } else {
       serializer->WriteProperty(XdmConst::PointCloud(), kColor,
@@ -138,20 +258,47 @@ bool PointCloud::ParseFields(const Deserializer& deserializer) {
   if (!deserializer.ParseInt(XdmConst::PointCloud(), kCount, &count_)) {
     return false;
   }
-  if (!deserializer.ParseBase64(XdmConst::PointCloud(), kPosition,
-                                &position_)) {
+  if (!ParseBase64ToString(deserializer, kPosition, &position_)) {
     return false;
   }
+  string position_encoding;
+  if (deserializer.ParseString(XdmConst::PointCloud(), kPositionEncoding,
+                               &position_encoding)) {
+    if (position_encoding != kQuantizedEncoding) {
+      LOG(ERROR) << "Unknown point cloud position encoding: "
+                 << position_encoding;
+      return false;
+    }
+    const string encoded_position(std::move(position_));
+    if (!DecodeQuantizedPositions(encoded_position.data(),
+                                  encoded_position.size(), count_, &position_,
+                                  &position_bits_)) {
+      return false;
+    }
+  }
 
   // Optional fields.
   if (!deserializer.ParseBoolean(XdmConst::PointCloud(), kMetric, &metric_)) {
     // Set it to the default value.
     metric_ = false;
   }
-  deserializer.ParseBase64(XdmConst::PointCloud(), kColor, &color_);
+  ParseBase64ToString(deserializer, kColor, &color_);
   deserializer.ParseString(XdmConst::PointCloud(), kSoftware, &software_);
+  ValidateLayout();
   return true;
 }
 
+void PointCloud::ValidateLayout() {
+  positions_valid_ = HoldsElements<PointPosition>(position_, count_);
+  colors_valid_ = positions_valid_ && HoldsElements<PointColor>(color_, count_);
+  if (!positions_valid_) {
+    LOG(WARNING) << "Point cloud position data does not hold " << count_
+                 << " points";
+  } else if (!color_.empty() && !colors_valid_) {
+    LOG(WARNING) << "Point cloud color data does not hold " << count_
+                 << " colors";
+  }
+}
+
 }  // namespace xdm
 }  // namespace xmpmeta
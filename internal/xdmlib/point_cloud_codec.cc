@@ -0,0 +1,247 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/point_cloud_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+// The number of bits byte, and the minimum and step floats of each axis.
+const size_t kHeaderSize = 1 + 6 * sizeof(float);
+
+// The longest varint of a 63-bit Morton code.
+const int kMaxVarintSize = 9;
+
+// Spreads the low 21 bits of value out to every third bit.
+uint64_t SpreadBits(uint64_t value) {
+  value &= 0x1fffff;
+  value = (value | value << 32) & 0x1f00000000ffffULL;
+  value = (value | value << 16) & 0x1f0000ff0000ffULL;
+  value = (value | value << 8) & 0x100f00f00f00f00fULL;
+  value = (value | value << 4) & 0x10c30c30c30c30c3ULL;
+  value = (value | value << 2) & 0x1249249249249249ULL;
+  return value;
+}
+
+// The inverse of SpreadBits.
+uint32_t CompactBits(uint64_t value) {
+  value &= 0x1249249249249249ULL;
+  value = (value ^ (value >> 2)) & 0x10c30c30c30c30c3ULL;
+  value = (value ^ (value >> 4)) & 0x100f00f00f00f00fULL;
+  value = (value ^ (value >> 8)) & 0x1f0000ff0000ffULL;
+  value = (value ^ (value >> 16)) & 0x1f00000000ffffULL;
+  value = (value ^ (value >> 32)) & 0x1fffff;
+  return static_cast<uint32_t>(value);
+}
+
+float GetCoordinate(const PointPosition& position, int axis) {
+  return axis == 0 ? position.x : (axis == 1 ? position.y : position.z);
+}
+
+// Returns value quantized to a step of the grid from min, clamped to
+// max_step. Values that are not numbers map to 0.
+uint32_t Quantize(float value, float min, float step, uint32_t max_step) {
+  if (!(step > 0)) {
+    return 0;
+  }
+  const float steps = std::floor((value - min) / step + 0.5f);
+  if (!(steps >= 0)) {
+    return 0;
+  }
+  return steps >= max_step ? max_step : static_cast<uint32_t>(steps);
+}
+
+void AppendVarint(uint64_t value, string* data) {
+  while (value >= 0x80) {
+    data->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  data->push_back(static_cast<char>(value));
+}
+
+// Reads a varint at *position and advances it. Returns false if the varint
+// is truncated or longer than kMaxVarintSize bytes.
+bool ReadVarint(const uint8_t* data, size_t size, size_t* position,
+                uint64_t* value) {
+  uint64_t result = 0;
+  for (int i = 0; i < kMaxVarintSize && *position < size; ++i) {
+    const uint8_t byte = data[(*position)++];
+    result |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+    if (byte < 0x80) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Reads a varint of at most 8 bytes from the 8 bytes at data, without
+// branching on its length, and returns its length, or 0 if it is longer.
+// The bytes are read as a little-endian word, like the positions themselves.
+size_t ReadShortVarint(const uint8_t* data, uint64_t* value) {
+  uint64_t word;
+  memcpy(&word, data, sizeof(word));
+  // The high bit of each byte is clear in the last byte of the varint.
+  const uint64_t ends = ~word & 0x8080808080808080ULL;
+  if (ends == 0) {
+    return 0;
+  }
+  // All bits up to and including the first end bit.
+  const uint64_t mask = ((ends & (0 - ends)) << 1) - 1;
+  // Gather the 7-bit groups.
+  uint64_t result = word & mask & 0x7f7f7f7f7f7f7f7fULL;
+  result = ((result & 0x7f007f007f007f00ULL) >> 1) |
+      (result & 0x007f007f007f007fULL);
+  result = ((result & 0x3fff00003fff0000ULL) >> 2) |
+      (result & 0x00003fff00003fffULL);
+  result = ((result & 0x0fffffff00000000ULL) >> 4) |
+      (result & 0x000000000fffffffULL);
+  *value = result;
+  // The number of bytes in mask.
+  return (((mask & 0x8080808080808080ULL) >> 7) * 0x0101010101010101ULL) >> 56;
+}
+
+}  // namespace
+
+bool EncodeQuantizedPositions(const PointCloudView<PointPosition>& positions,
+                              int bits, string* data,
+                              std::vector<uint32_t>* order) {
+  if (bits < kMinQuantizedPositionBits || bits > kMaxQuantizedPositionBits) {
+    LOG(ERROR) << "Invalid number of bits per coordinate: " << bits;
+    return false;
+  }
+
+  // Bounding box. Comparisons skip coordinates that are not numbers.
+  float min[3];
+  float max[3];
+  std::fill(min, min + 3, std::numeric_limits<float>::infinity());
+  std::fill(max, max + 3, -std::numeric_limits<float>::infinity());
+  for (const PointPosition& position : positions) {
+    for (int axis = 0; axis < 3; ++axis) {
+      const float value = GetCoordinate(position, axis);
+      min[axis] = value < min[axis] ? value : min[axis];
+      max[axis] = value > max[axis] ? value : max[axis];
+    }
+  }
+  const uint32_t max_step = (1U << bits) - 1;
+  float step[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    if (!(min[axis] <= max[axis])) {
+      min[axis] = 0;
+      max[axis] = 0;
+    }
+    step[axis] = static_cast<float>(
+        (static_cast<double>(max[axis]) - min[axis]) / max_step);
+    if (!std::isfinite(step[axis])) {
+      step[axis] = 0;
+    }
+  }
+
+  std::vector<std::pair<uint64_t, uint32_t>> codes(positions.size());
+  for (size_t i = 0; i < positions.size(); ++i) {
+    const PointPosition& position = positions[i];
+    codes[i].first =
+        SpreadBits(Quantize(position.x, min[0], step[0], max_step)) |
+        SpreadBits(Quantize(position.y, min[1], step[1], max_step)) << 1 |
+        SpreadBits(Quantize(position.z, min[2], step[2], max_step)) << 2;
+    codes[i].second = i;
+  }
+  std::sort(codes.begin(), codes.end());
+
+  data->clear();
+  data->reserve(kHeaderSize + positions.size() * 3 * bits / 7 + 16);
+  data->push_back(static_cast<char>(bits));
+  for (int axis = 0; axis < 3; ++axis) {
+    data->append(reinterpret_cast<const char*>(&min[axis]), sizeof(float));
+    data->append(reinterpret_cast<const char*>(&step[axis]), sizeof(float));
+  }
+  order->resize(codes.size());
+  uint64_t previous_code = 0;
+  for (size_t i = 0; i < codes.size(); ++i) {
+    AppendVarint(codes[i].first - previous_code, data);
+    previous_code = codes[i].first;
+    (*order)[i] = codes[i].second;
+  }
+  return true;
+}
+
+bool DecodeQuantizedPositions(const char* data, size_t size, int count,
+                              string* positions, int* bits) {
+  if (size < kHeaderSize || count < 0) {
+    LOG(ERROR) << "Quantized position data is too short";
+    return false;
+  }
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  *bits = bytes[0];
+  if (*bits < kMinQuantizedPositionBits || *bits > kMaxQuantizedPositionBits) {
+    LOG(ERROR) << "Invalid number of bits per coordinate: " << *bits;
+    return false;
+  }
+  float min[3];
+  float step[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    memcpy(&min[axis], data + 1 + 2 * axis * sizeof(float), sizeof(float));
+    memcpy(&step[axis], data + 1 + (2 * axis + 1) * sizeof(float),
+           sizeof(float));
+  }
+  const uint64_t code_limit = 1ULL << (3 * *bits);
+  // Every point takes at least one byte, so check the count before allocating.
+  if (static_cast<size_t>(count) > size - kHeaderSize) {
+    LOG(ERROR) << "Quantized position data is too short for " << count
+               << " points";
+    return false;
+  }
+
+  positions->resize(static_cast<size_t>(count) * sizeof(PointPosition));
+  PointPosition* points = reinterpret_cast<PointPosition*>(&(*positions)[0]);
+  size_t position = kHeaderSize;
+  uint64_t code = 0;
+  for (int i = 0; i < count; ++i) {
+    uint64_t delta;
+    size_t length = 0;
+    if (position + sizeof(uint64_t) <= size) {
+      length = ReadShortVarint(bytes + position, &delta);
+      position += length;
+    }
+    if ((length == 0 && !ReadVarint(bytes, size, &position, &delta)) ||
+        delta >= code_limit - code) {
+      LOG(ERROR) << "Malformed quantized position data";
+      positions->clear();
+      return false;
+    }
+    code += delta;
+    points[i].x = min[0] + CompactBits(code) * step[0];
+    points[i].y = min[1] + CompactBits(code >> 1) * step[1];
+    points[i].z = min[2] + CompactBits(code >> 2) * step[2];
+  }
+  if (position != size) {
+    LOG(ERROR) << "Quantized position data holds more than " << count
+               << " points";
+    positions->clear();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace xdm
+}  // namespace xmpmeta
@@ -0,0 +1,56 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XDM_POINT_CLOUD_CODEC_H_
+#define XMPMETA_XDM_POINT_CLOUD_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "xdmlib/point_cloud.h"
+
+// The compact encoding of point cloud positions. Each coordinate is quantized
+// to a fixed number of bits over the bounding box of the points, the points
+// are sorted by the Morton code of their quantized coordinates, and the
+// differences between consecutive codes are written as varints. The data
+// starts with a header: the number of bits as one byte, then the minimum and
+// the quantization step of x, y and z as little-endian floats.
+namespace xmpmeta {
+namespace xdm {
+
+// The range of the number of bits per coordinate. 21 bits keep the Morton
+// code of a point in 64 bits.
+const int kMinQuantizedPositionBits = 1;
+const int kMaxQuantizedPositionBits = 21;
+
+// Encodes the positions with the given number of bits per coordinate into
+// data. Sets order to the original indices of the points in the order they
+// are encoded, e.g. to reorder the colors to match. Returns false if bits is
+// out of range.
+bool EncodeQuantizedPositions(const PointCloudView<PointPosition>& positions,
+                              int bits, string* data,
+                              std::vector<uint32_t>* order);
+
+// Decodes count positions from data into positions, and sets bits to the
+// number of bits per coordinate they were encoded with. Returns false if the
+// data is malformed or does not hold exactly count positions.
+bool DecodeQuantizedPositions(const char* data, size_t size, int count,
+                              string* positions, int* bits);
+
+}  // namespace xdm
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XDM_POINT_CLOUD_CODEC_H_
@@ -0,0 +1,162 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/point_cloud_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+PointCloudView<PointPosition> ToView(
+    const std::vector<PointPosition>& positions) {
+  return PointCloudView<PointPosition>(positions.data(), positions.size());
+}
+
+std::vector<PointPosition> CreateRandomPositions(size_t count) {
+  std::mt19937 generator(count);
+  std::uniform_real_distribution<float> distribution(-5.0f, 5.0f);
+  std::vector<PointPosition> positions(count);
+  for (PointPosition& position : positions) {
+    position.x = distribution(generator);
+    position.y = distribution(generator) * 2;
+    position.z = distribution(generator) + 100;
+  }
+  return positions;
+}
+
+TEST(PointCloudCodec, RoundTrip) {
+  const std::vector<PointPosition> positions = CreateRandomPositions(1000);
+  for (int bits : {1, 8, 12, 16, 21}) {
+    string data;
+    std::vector<uint32_t> order;
+    ASSERT_TRUE(EncodeQuantizedPositions(ToView(positions), bits, &data,
+                                         &order));
+    ASSERT_EQ(positions.size(), order.size());
+    std::vector<uint32_t> sorted_order(order);
+    std::sort(sorted_order.begin(), sorted_order.end());
+    for (size_t i = 0; i < sorted_order.size(); ++i) {
+      ASSERT_EQ(i, sorted_order[i]);
+    }
+
+    string decoded;
+    int decoded_bits;
+    ASSERT_TRUE(DecodeQuantizedPositions(data.data(), data.size(),
+                                         positions.size(), &decoded,
+                                         &decoded_bits));
+    EXPECT_EQ(bits, decoded_bits);
+    ASSERT_EQ(positions.size() * sizeof(PointPosition), decoded.size());
+    const PointPosition* points =
+        reinterpret_cast<const PointPosition*>(decoded.data());
+
+    // Half a step, with some room for float rounding.
+    const float max_step = (1 << bits) - 1;
+    const double x_error = 10.0 / max_step / 2 * 1.01 + 1e-5;
+    const double y_error = 20.0 / max_step / 2 * 1.01 + 1e-5;
+    const double z_error = 10.0 / max_step / 2 * 1.01 + 1e-5;
+    for (size_t i = 0; i < order.size(); ++i) {
+      const PointPosition& original = positions[order[i]];
+      EXPECT_NEAR(original.x, points[i].x, x_error) << bits;
+      EXPECT_NEAR(original.y, points[i].y, y_error) << bits;
+      EXPECT_NEAR(original.z, points[i].z, z_error) << bits;
+    }
+  }
+}
+
+TEST(PointCloudCodec, SmallerThanRawPositions) {
+  const std::vector<PointPosition> positions = CreateRandomPositions(10000);
+  string data;
+  std::vector<uint32_t> order;
+  ASSERT_TRUE(EncodeQuantizedPositions(ToView(positions), 16, &data, &order));
+  EXPECT_LT(data.size(), positions.size() * sizeof(PointPosition) / 2);
+}
+
+TEST(PointCloudCodec, RepeatedAndFlatPoints) {
+  const std::vector<PointPosition> positions(
+      5, PointPosition{1.5f, -2.0f, 0.0f});
+  string data;
+  std::vector<uint32_t> order;
+  ASSERT_TRUE(EncodeQuantizedPositions(ToView(positions), 10, &data, &order));
+  EXPECT_EQ(std::vector<uint32_t>({0, 1, 2, 3, 4}), order);
+
+  string decoded;
+  int bits;
+  ASSERT_TRUE(DecodeQuantizedPositions(data.data(), data.size(), 5, &decoded,
+                                       &bits));
+  const PointPosition* points =
+      reinterpret_cast<const PointPosition*>(decoded.data());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(1.5f, points[i].x);
+    EXPECT_EQ(-2.0f, points[i].y);
+    EXPECT_EQ(0.0f, points[i].z);
+  }
+}
+
+TEST(PointCloudCodec, InvalidBits) {
+  const std::vector<PointPosition> positions = CreateRandomPositions(3);
+  string data;
+  std::vector<uint32_t> order;
+  EXPECT_FALSE(EncodeQuantizedPositions(ToView(positions), 0, &data, &order));
+  EXPECT_FALSE(EncodeQuantizedPositions(ToView(positions), 22, &data,
+                                        &order));
+}
+
+TEST(PointCloudCodec, DecodeRejectsMalformedData) {
+  const std::vector<PointPosition> positions = CreateRandomPositions(20);
+  string data;
+  std::vector<uint32_t> order;
+  ASSERT_TRUE(EncodeQuantizedPositions(ToView(positions), 8, &data, &order));
+
+  string decoded;
+  int bits;
+  // Wrong counts.
+  EXPECT_FALSE(DecodeQuantizedPositions(data.data(), data.size(), 19,
+                                        &decoded, &bits));
+  EXPECT_FALSE(DecodeQuantizedPositions(data.data(), data.size(), 21,
+                                        &decoded, &bits));
+  // Truncated.
+  EXPECT_FALSE(DecodeQuantizedPositions(data.data(), 10, 0, &decoded,
+                                        &bits));
+  EXPECT_FALSE(DecodeQuantizedPositions(data.data(), data.size() - 1, 20,
+                                        &decoded, &bits));
+  // More points than bytes, rejected without allocating them.
+  EXPECT_FALSE(DecodeQuantizedPositions(data.data(), 26, 2147483647, &decoded,
+                                        &bits));
+  EXPECT_FALSE(DecodeQuantizedPositions(data.data(), 26, 2, &decoded, &bits));
+  // Invalid number of bits.
+  string invalid = data;
+  invalid[0] = 30;
+  EXPECT_FALSE(DecodeQuantizedPositions(invalid.data(), invalid.size(), 20,
+                                        &decoded, &bits));
+  // A code beyond 3 * 8 bits.
+  invalid = data.substr(0, 25) + string("\xff\xff\xff\x7f", 4);
+  EXPECT_FALSE(DecodeQuantizedPositions(invalid.data(), invalid.size(), 1,
+                                        &decoded, &bits));
+  // An unterminated varint.
+  invalid = data.substr(0, 25) + string(10, '\x80') + '\x01';
+  EXPECT_FALSE(DecodeQuantizedPositions(invalid.data(), invalid.size(), 1,
+                                        &decoded, &bits));
+  EXPECT_TRUE(decoded.empty());
+}
+
+}  // namespace
+}  // namespace xdm
+}  // namespace xmpmeta
@@ -0,0 +1,287 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/point_cloud_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+// The number of bisection steps used to choose the cell size.
+const int kCellSizeSteps = 40;
+
+float GetCoordinate(const PointPosition& position, int axis) {
+  return axis == 0 ? position.x : (axis == 1 ? position.y : position.z);
+}
+
+float GetSquaredDistance(const PointPosition& a, const PointPosition& b) {
+  const float dx = a.x - b.x;
+  const float dy = a.y - b.y;
+  const float dz = a.z - b.z;
+  return dx * dx + dy * dy + dz * dz;
+}
+
+// Returns the number of cells of the given size needed to cover extent.
+double GetCellCount(const float* extent, float cell_size) {
+  double count = 1;
+  for (int axis = 0; axis < 3; ++axis) {
+    count *= std::max(1.0, std::ceil(static_cast<double>(extent[axis]) /
+                                     cell_size));
+  }
+  return count;
+}
+
+// A candidate nearest neighbor. The priority queue of candidates keeps the
+// farthest on top, breaking ties by index.
+typedef std::pair<float, uint32_t> Candidate;
+
+}  // namespace
+
+// Private constructor.
+PointCloudIndex::PointCloudIndex() : cell_size_(1) {
+  std::fill(origin_, origin_ + 3, 0.0f);
+  std::fill(dimensions_, dimensions_ + 3, 1);
+}
+
+// Public methods.
+std::unique_ptr<PointCloudIndex>
+PointCloudIndex::FromPositions(const PointCloudView<PointPosition>& positions) {
+  if (positions.empty()) {
+    LOG(ERROR) << "No positions given";
+    return nullptr;
+  }
+  // Points and cell offsets are stored as 32-bit indices.
+  if (positions.size() > std::numeric_limits<uint32_t>::max()) {
+    LOG(ERROR) << "Too many positions to index: " << positions.size();
+    return nullptr;
+  }
+  std::unique_ptr<PointCloudIndex> index(new PointCloudIndex());
+  index->positions_ = positions;
+
+  // Bounding box. Comparisons skip coordinates that are not numbers, and the
+  // points with them end up in the first cell.
+  float min[3];
+  float max[3];
+  std::fill(min, min + 3, std::numeric_limits<float>::infinity());
+  std::fill(max, max + 3, -std::numeric_limits<float>::infinity());
+  for (const PointPosition& position : positions) {
+    for (int axis = 0; axis < 3; ++axis) {
+      const float value = GetCoordinate(position, axis);
+      if (value < min[axis]) {
+        min[axis] = value;
+      }
+      if (value > max[axis]) {
+        max[axis] = value;
+      }
+    }
+  }
+  float extent[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    if (!(min[axis] <= max[axis]) || std::isinf(max[axis] - min[axis])) {
+      min[axis] = 0;
+      max[axis] = 0;
+    }
+    index->origin_[axis] = min[axis];
+    extent[axis] = max[axis] - min[axis];
+  }
+
+  // Find the smallest cell size that needs at most the target number of
+  // cells. The cell count only decreases as the cell size grows.
+  const double max_cells = std::max<double>(
+      1, positions.size() / kTargetPointsPerCell);
+  const float max_extent = *std::max_element(extent, extent + 3);
+  if (max_extent > 0) {
+    float low = max_extent / static_cast<float>(max_cells);
+    float high = max_extent;
+    for (int step = 0; step < kCellSizeSteps; ++step) {
+      const float middle = low + (high - low) / 2;
+      if (GetCellCount(extent, middle) <= max_cells) {
+        high = middle;
+      } else {
+        low = middle;
+      }
+    }
+    index->cell_size_ = high;
+    for (int axis = 0; axis < 3; ++axis) {
+      index->dimensions_[axis] = std::max(
+          1, static_cast<int>(std::ceil(static_cast<double>(extent[axis]) /
+                                        high)));
+    }
+  }
+
+  // Sort the points by cell with a counting sort.
+  const size_t cell_count = static_cast<size_t>(index->dimensions_[0]) *
+      index->dimensions_[1] * index->dimensions_[2];
+  std::vector<uint32_t> point_cells(positions.size());
+  index->cell_starts_.assign(cell_count + 1, 0);
+  for (size_t i = 0; i < positions.size(); ++i) {
+    const PointPosition& position = positions[i];
+    point_cells[i] = index->GetCellIndex(
+        index->GetCellCoordinate(position.x, 0),
+        index->GetCellCoordinate(position.y, 1),
+        index->GetCellCoordinate(position.z, 2));
+    ++index->cell_starts_[point_cells[i] + 1];
+  }
+  for (size_t cell = 0; cell < cell_count; ++cell) {
+    index->cell_starts_[cell + 1] += index->cell_starts_[cell];
+  }
+  index->point_indices_.resize(positions.size());
+  std::vector<uint32_t> cell_ends(index->cell_starts_.begin(),
+                                  index->cell_starts_.end() - 1);
+  for (size_t i = 0; i < positions.size(); ++i) {
+    index->point_indices_[cell_ends[point_cells[i]]++] = i;
+  }
+  return index;
+}
+
+void PointCloudIndex::FindNearest(const PointPosition& query, size_t k,
+                                  std::vector<size_t>* indices) const {
+  indices->clear();
+  if (k == 0) {
+    return;
+  }
+  const int center[3] = {GetCellCoordinate(query.x, 0),
+                         GetCellCoordinate(query.y, 1),
+                         GetCellCoordinate(query.z, 2)};
+  std::priority_queue<Candidate> nearest;
+
+  // Visit the cells in rings of growing Chebyshev distance from the query's
+  // cell, until the unvisited cells cannot hold a nearer point.
+  for (int ring = 0;; ++ring) {
+    int begin[3];
+    int end[3];
+    for (int axis = 0; axis < 3; ++axis) {
+      begin[axis] = std::max(0, center[axis] - ring);
+      end[axis] = std::min(dimensions_[axis] - 1, center[axis] + ring);
+    }
+    for (int x = begin[0]; x <= end[0]; ++x) {
+      for (int y = begin[1]; y <= end[1]; ++y) {
+        // Cells inside the ring in x and y only need their outer z cells.
+        const bool inner = std::abs(x - center[0]) < ring &&
+            std::abs(y - center[1]) < ring;
+        const int z_step = inner ? 2 * ring : 1;
+        for (int z = inner ? center[2] - ring : begin[2]; z <= end[2];
+             z += z_step) {
+          if (z < 0) {
+            continue;
+          }
+          const size_t cell = GetCellIndex(x, y, z);
+          for (uint32_t i = cell_starts_[cell]; i < cell_starts_[cell + 1];
+               ++i) {
+            const uint32_t point = point_indices_[i];
+            const Candidate candidate(
+                GetSquaredDistance(query, positions_[point]), point);
+            if (nearest.size() < k) {
+              nearest.push(candidate);
+            } else if (candidate < nearest.top()) {
+              nearest.pop();
+              nearest.push(candidate);
+            }
+          }
+        }
+      }
+    }
+
+    // Every unvisited point lies beyond one of the sides of the visited box
+    // that are not on the edge of the grid.
+    float bound = std::numeric_limits<float>::infinity();
+    for (int axis = 0; axis < 3; ++axis) {
+      const float value = GetCoordinate(query, axis);
+      if (begin[axis] > 0) {
+        bound = std::min(bound, value - (origin_[axis] +
+                                         begin[axis] * cell_size_));
+      }
+      if (end[axis] < dimensions_[axis] - 1) {
+        bound = std::min(bound, origin_[axis] +
+                                (end[axis] + 1) * cell_size_ - value);
+      }
+    }
+    if (std::isinf(bound) ||
+        (nearest.size() == k && bound >= 0 &&
+         nearest.top().first < bound * bound)) {
+      break;
+    }
+  }
+
+  indices->resize(nearest.size());
+  for (size_t i = nearest.size(); i > 0; --i) {
+    (*indices)[i - 1] = nearest.top().second;
+    nearest.pop();
+  }
+}
+
+void PointCloudIndex::FindWithinRadius(const PointPosition& center,
+                                       float radius,
+                                       std::vector<size_t>* indices) const {
+  indices->clear();
+  if (!(radius >= 0)) {
+    return;
+  }
+  int begin[3];
+  int end[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    const float value = GetCoordinate(center, axis);
+    begin[axis] = GetCellCoordinate(value - radius, axis);
+    end[axis] = GetCellCoordinate(value + radius, axis);
+  }
+  const float squared_radius = radius * radius;
+  for (int x = begin[0]; x <= end[0]; ++x) {
+    for (int y = begin[1]; y <= end[1]; ++y) {
+      for (int z = begin[2]; z <= end[2]; ++z) {
+        const size_t cell = GetCellIndex(x, y, z);
+        for (uint32_t i = cell_starts_[cell]; i < cell_starts_[cell + 1];
+             ++i) {
+          const uint32_t point = point_indices_[i];
+          if (GetSquaredDistance(center, positions_[point]) <=
+              squared_radius) {
+            indices->push_back(point);
+          }
+        }
+      }
+    }
+  }
+  std::sort(indices->begin(), indices->end());
+}
+
+size_t PointCloudIndex::GetMemoryUsage() const {
+  return sizeof(*this) +
+      (cell_starts_.capacity() + point_indices_.capacity()) * sizeof(uint32_t);
+}
+
+// Private methods.
+int PointCloudIndex::GetCellCoordinate(float value, int axis) const {
+  const float cell = (value - origin_[axis]) / cell_size_;
+  if (!(cell >= 0)) {
+    return 0;
+  }
+  if (cell >= dimensions_[axis]) {
+    return dimensions_[axis] - 1;
+  }
+  return static_cast<int>(cell);
+}
+
+size_t PointCloudIndex::GetCellIndex(int x, int y, int z) const {
+  return (static_cast<size_t>(z) * dimensions_[1] + y) * dimensions_[0] + x;
+}
+
+}  // namespace xdm
+}  // namespace xmpmeta
@@ -0,0 +1,177 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xdmlib/point_cloud_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace xmpmeta {
+namespace xdm {
+namespace {
+
+PointCloudView<PointPosition> ToView(
+    const std::vector<PointPosition>& positions) {
+  return PointCloudView<PointPosition>(positions.data(), positions.size());
+}
+
+std::vector<PointPosition> CreateRandomPositions(size_t count,
+                                                 float z_scale) {
+  std::mt19937 generator(count);
+  std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+  std::vector<PointPosition> positions(count);
+  for (PointPosition& position : positions) {
+    position.x = distribution(generator);
+    position.y = distribution(generator) * 0.5f;
+    position.z = distribution(generator) * z_scale;
+  }
+  return positions;
+}
+
+float GetSquaredDistance(const PointPosition& a, const PointPosition& b) {
+  const float dx = a.x - b.x;
+  const float dy = a.y - b.y;
+  const float dz = a.z - b.z;
+  return dx * dx + dy * dy + dz * dz;
+}
+
+// Finds the nearest points by checking every point.
+std::vector<size_t> FindNearestBruteForce(
+    const std::vector<PointPosition>& positions, const PointPosition& query,
+    size_t k) {
+  std::vector<std::pair<float, size_t>> candidates;
+  for (size_t i = 0; i < positions.size(); ++i) {
+    candidates.emplace_back(GetSquaredDistance(query, positions[i]), i);
+  }
+  std::sort(candidates.begin(), candidates.end());
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < std::min(k, candidates.size()); ++i) {
+    indices.push_back(candidates[i].second);
+  }
+  return indices;
+}
+
+std::vector<size_t> FindWithinRadiusBruteForce(
+    const std::vector<PointPosition>& positions, const PointPosition& center,
+    float radius) {
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < positions.size(); ++i) {
+    if (GetSquaredDistance(center, positions[i]) <= radius * radius) {
+      indices.push_back(i);
+    }
+  }
+  return indices;
+}
+
+// Checks the index against brute force queries around and outside the
+// points.
+void ExpectMatchesBruteForce(const std::vector<PointPosition>& positions) {
+  std::unique_ptr<PointCloudIndex> index =
+      PointCloudIndex::FromPositions(ToView(positions));
+  ASSERT_NE(nullptr, index);
+
+  std::vector<PointPosition> queries = CreateRandomPositions(20, 1.0f);
+  queries.push_back(PointPosition{0, 0, 0});
+  queries.push_back(PointPosition{100, -50, 3});
+  queries.push_back(positions[0]);
+  std::vector<size_t> indices;
+  for (const PointPosition& query : queries) {
+    for (size_t k : {1, 5, 40}) {
+      index->FindNearest(query, k, &indices);
+      EXPECT_EQ(FindNearestBruteForce(positions, query, k), indices);
+    }
+    for (float radius : {0.0f, 0.5f, 3.0f, 1000.0f}) {
+      index->FindWithinRadius(query, radius, &indices);
+      EXPECT_EQ(FindWithinRadiusBruteForce(positions, query, radius),
+                indices);
+    }
+  }
+}
+
+TEST(PointCloudIndex, FromNoPositions) {
+  EXPECT_EQ(nullptr,
+            PointCloudIndex::FromPositions(PointCloudView<PointPosition>()));
+}
+
+TEST(PointCloudIndex, FromTooManyPositions) {
+  if (sizeof(size_t) <= sizeof(uint32_t)) {
+    return;
+  }
+  // The positions are rejected before any of them is read.
+  PointPosition point = {0.0f, 0.0f, 0.0f};
+  PointCloudView<PointPosition> positions(
+      &point, static_cast<size_t>(std::numeric_limits<uint32_t>::max()) + 1);
+  EXPECT_EQ(nullptr, PointCloudIndex::FromPositions(positions));
+}
+
+TEST(PointCloudIndex, MatchesBruteForce) {
+  ExpectMatchesBruteForce(CreateRandomPositions(3000, 1.0f));
+}
+
+TEST(PointCloudIndex, MatchesBruteForceOnAPlane) {
+  ExpectMatchesBruteForce(CreateRandomPositions(2000, 0.0f));
+}
+
+TEST(PointCloudIndex, MatchesBruteForceWithFewPoints) {
+  ExpectMatchesBruteForce(CreateRandomPositions(3, 1.0f));
+}
+
+TEST(PointCloudIndex, RepeatedPoints) {
+  const std::vector<PointPosition> positions(
+      50, PointPosition{1.0f, 2.0f, 3.0f});
+  std::unique_ptr<PointCloudIndex> index =
+      PointCloudIndex::FromPositions(ToView(positions));
+  ASSERT_NE(nullptr, index);
+
+  std::vector<size_t> indices;
+  index->FindNearest(PointPosition{0, 0, 0}, 3, &indices);
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2}), indices);
+  index->FindWithinRadius(PointPosition{1, 2, 3}, 0, &indices);
+  EXPECT_EQ(50, indices.size());
+}
+
+TEST(PointCloudIndex, NoResults) {
+  const std::vector<PointPosition> positions = CreateRandomPositions(10, 1.0f);
+  std::unique_ptr<PointCloudIndex> index =
+      PointCloudIndex::FromPositions(ToView(positions));
+  ASSERT_NE(nullptr, index);
+
+  std::vector<size_t> indices = {7};
+  index->FindNearest(positions[0], 0, &indices);
+  EXPECT_TRUE(indices.empty());
+  indices.push_back(7);
+  index->FindWithinRadius(PointPosition{100, 100, 100}, 1, &indices);
+  EXPECT_TRUE(indices.empty());
+  index->FindWithinRadius(positions[0], -1, &indices);
+  EXPECT_TRUE(indices.empty());
+}
+
+TEST(PointCloudIndex, MemoryUsage) {
+  const size_t count = 100000;
+  std::unique_ptr<PointCloudIndex> index = PointCloudIndex::FromPositions(
+      ToView(CreateRandomPositions(count, 1.0f)));
+  ASSERT_NE(nullptr, index);
+  EXPECT_LE(index->GetMemoryUsage(), count * 9 / 2 + 1024);
+}
+
+}  // namespace
+}  // namespace xdm
+}  // namespace xmpmeta
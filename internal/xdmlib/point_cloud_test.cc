@@ -16,12 +16,15 @@
 
 #include <libxml/tree.h>
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include "xdmlib/const.h"
+#include "xdmlib/point_cloud_index.h"
 #include "xmpmeta/file.h"
 #include "xmpmeta/test_util.h"
 #include "xmpmeta/base64.h"
@@ -327,6 +330,232 @@ TEST(PointCloud, ReadMetadata) {
   xmlFreeNs(point_cloud_ns);
 }
 
+// Returns the raw position data of the given points.
+string PositionData(const std::vector<PointPosition>& points) {
+  return string(reinterpret_cast<const char*>(points.data()),
+                points.size() * sizeof(PointPosition));
+}
+
+TEST(PointCloud, TypedViews) {
+  const std::vector<PointPosition> points = {{1.0f, 2.0f, 3.0f},
+                                             {-4.5f, 0.25f, 1e6f}};
+  const string color("\x01\x02\x03\xfd\xfe\xff", 6);
+  std::unique_ptr<PointCloud> point_cloud =
+      PointCloud::FromData(2, PositionData(points), color, true, "");
+  ASSERT_NE(nullptr, point_cloud);
+
+  const PointCloudView<PointPosition> positions = point_cloud->GetPositions();
+  ASSERT_EQ(2, positions.size());
+  EXPECT_EQ(point_cloud->GetPosition().data(),
+            reinterpret_cast<const char*>(positions.data()));
+  EXPECT_EQ(-4.5f, positions[1].x);
+  EXPECT_EQ(0.25f, positions[1].y);
+  EXPECT_EQ(1e6f, positions[1].z);
+
+  const PointCloudView<PointColor> colors = point_cloud->GetColors();
+  ASSERT_EQ(2, colors.size());
+  EXPECT_EQ(point_cloud->GetColor().data(),
+            reinterpret_cast<const char*>(colors.data()));
+  EXPECT_EQ(1, colors[0].r);
+  EXPECT_EQ(0xfe, colors[1].g);
+  EXPECT_EQ(0xff, colors[1].b);
+}
+
+TEST(PointCloud, TypedViewsRequireCount) {
+  const std::vector<PointPosition> points = {{1.0f, 2.0f, 3.0f}};
+  // Too many points for the data.
+  std::unique_ptr<PointCloud> point_cloud =
+      PointCloud::FromData(2, PositionData(points), "abc", false, "");
+  ASSERT_NE(nullptr, point_cloud);
+  EXPECT_TRUE(point_cloud->GetPositions().empty());
+  EXPECT_TRUE(point_cloud->GetColors().empty());
+  // The raw data is still available.
+  EXPECT_EQ(PositionData(points), point_cloud->GetPosition());
+
+  // Color data of the wrong size only drops the colors.
+  point_cloud = PointCloud::FromData(1, PositionData(points), "ab", false, "");
+  ASSERT_NE(nullptr, point_cloud);
+  EXPECT_EQ(1, point_cloud->GetPositions().size());
+  EXPECT_TRUE(point_cloud->GetColors().empty());
+}
+
+TEST(PointCloud, GetIndex) {
+  const std::vector<PointPosition> points = {
+      {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {5.0f, 5.0f, 5.0f}};
+  std::unique_ptr<PointCloud> point_cloud =
+      PointCloud::FromData(3, PositionData(points), "", false, "");
+  ASSERT_NE(nullptr, point_cloud);
+  const PointCloudIndex* index = point_cloud->GetIndex();
+  ASSERT_NE(nullptr, index);
+  EXPECT_EQ(index, point_cloud->GetIndex());
+
+  std::vector<size_t> indices;
+  index->FindNearest(PointPosition{4.0f, 4.0f, 4.0f}, 2, &indices);
+  EXPECT_EQ(std::vector<size_t>({2, 1}), indices);
+
+  // No index without valid positions.
+  point_cloud = PointCloud::FromData(4, PositionData(points), "", false, "");
+  ASSERT_NE(nullptr, point_cloud);
+  EXPECT_EQ(nullptr, point_cloud->GetIndex());
+}
+
+TEST(PointCloud, GetIndexOnManyThreads) {
+  std::vector<PointPosition> points;
+  for (int i = 0; i < 1000; i++) {
+    points.push_back({static_cast<float>(i % 10), static_cast<float>(i / 10),
+                      0.0f});
+  }
+  std::unique_ptr<PointCloud> point_cloud =
+      PointCloud::FromData(1000, PositionData(points), "", false, "");
+  ASSERT_NE(nullptr, point_cloud);
+
+  const int kNumThreads = 8;
+  std::vector<const PointCloudIndex*> indices(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t] { indices[t] = point_cloud->GetIndex(); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  ASSERT_NE(nullptr, indices[0]);
+  for (int t = 1; t < kNumThreads; t++) {
+    EXPECT_EQ(indices[0], indices[t]);
+  }
+}
+
+TEST(PointCloud, FromDataInvalidPositionBits) {
+  EXPECT_EQ(nullptr, PointCloud::FromData(1, "position", "", false, "", -1));
+  EXPECT_EQ(nullptr, PointCloud::FromData(1, "position", "", false, "", 22));
+}
+
+TEST(PointCloud, SerializeQuantizedPositions) {
+  const std::vector<PointPosition> points = {
+      {1.0f, 2.0f, 3.0f}, {-1.0f, 0.5f, 0.0f}, {0.0f, 0.0f, 0.0f},
+      {1.0f, -2.0f, 0.25f}};
+  const string color("\x01\x01\x01\x02\x02\x02\x03\x03\x03\x04\x04\x04",
+                     12);
+  std::unique_ptr<PointCloud> point_cloud =
+      PointCloud::FromData(4, PositionData(points), color, true, "", 16);
+  ASSERT_NE(nullptr, point_cloud);
+  EXPECT_EQ(16, point_cloud->GetPositionBits());
+
+  // Set up XML nodes.
+  const char* camera_name = "Camera";
+  std::unordered_map<string, xmlNsPtr> namespaces;
+  namespaces.emplace(camera_name, xmlNewNs(nullptr, ToXmlChar(kNamespaceHref),
+                                           ToXmlChar(camera_name)));
+  namespaces.emplace(XdmConst::PointCloud(),
+                     xmlNewNs(nullptr, ToXmlChar(kNamespaceHref),
+                              ToXmlChar(XdmConst::PointCloud())));
+  xmlNodePtr camera_node = xmlNewNode(nullptr, ToXmlChar(camera_name));
+  xmlDocPtr xml_doc = xmlNewDoc(ToXmlChar(XmlConst::Version()));
+  xmlDocSetRootElement(xml_doc, camera_node);
+
+  SerializerImpl serializer(namespaces, camera_node);
+  std::unique_ptr<Serializer> point_cloud_serializer =
+      serializer.CreateSerializer(
+          XdmConst::Namespace(XdmConst::PointCloud()), XdmConst::PointCloud());
+  ASSERT_NE(nullptr, point_cloud_serializer);
+  ASSERT_TRUE(point_cloud->Serialize(point_cloud_serializer.get()));
+  EXPECT_NE(string::npos, XmlDocToString(xml_doc).find(
+      "PointCloud:PositionEncoding=\"Quantized\""));
+
+  // The points come back reordered and quantized, with their colors.
+  DeserializerImpl deserializer(camera_node);
+  std::unique_ptr<PointCloud> read_point_cloud =
+      PointCloud::FromDeserializer(deserializer);
+  ASSERT_NE(nullptr, read_point_cloud);
+  EXPECT_EQ(16, read_point_cloud->GetPositionBits());
+  EXPECT_TRUE(read_point_cloud->GetMetric());
+  const PointCloudView<PointPosition> positions =
+      read_point_cloud->GetPositions();
+  const PointCloudView<PointColor> colors = read_point_cloud->GetColors();
+  ASSERT_EQ(4, positions.size());
+  ASSERT_EQ(4, colors.size());
+  std::vector<bool> found(points.size(), false);
+  for (size_t i = 0; i < positions.size(); ++i) {
+    const int original = colors[i].r - 1;
+    ASSERT_GE(original, 0);
+    ASSERT_LT(original, 4);
+    found[original] = true;
+    EXPECT_NEAR(points[original].x, positions[i].x, 1e-4);
+    EXPECT_NEAR(points[original].y, positions[i].y, 1e-4);
+    EXPECT_NEAR(points[original].z, positions[i].z, 1e-4);
+  }
+  EXPECT_EQ(std::vector<bool>(points.size(), true), found);
+
+  // Free all XML objects.
+  for (const auto& entry : namespaces) {
+    xmlFreeNs(entry.second);
+  }
+  xmlFreeDoc(xml_doc);
+}
+
+TEST(PointCloud, ReadMetadataUnknownPositionEncoding) {
+  std::unique_ptr<XmpData> xmp_data = CreateXmpData(true);
+  xmlNodePtr description_node =
+      GetFirstDescriptionElement(xmp_data->ExtendedSection());
+  xmlNodePtr camera_node = xmlNewNode(nullptr, ToXmlChar("Camera"));
+  xmlAddChild(description_node, camera_node);
+  xmlNsPtr camera_ns = xmlNewNs(nullptr, ToXmlChar(kNamespaceHref),
+                                ToXmlChar(XdmConst::Camera()));
+  xmlNodePtr point_cloud_node =
+      xmlNewNode(camera_ns, ToXmlChar(XdmConst::PointCloud()));
+  xmlAddChild(camera_node, point_cloud_node);
+
+  xmlNsPtr point_cloud_ns = xmlNewNs(nullptr, ToXmlChar(kNamespaceHref),
+                                     ToXmlChar(XdmConst::PointCloud()));
+  xmlSetNsProp(point_cloud_node, point_cloud_ns, ToXmlChar("Count"),
+               ToXmlChar("1"));
+  xmlSetNsProp(point_cloud_node, point_cloud_ns, ToXmlChar("Position"),
+               ToXmlChar("AAAAAAAAAAAAAAAA"));
+  xmlSetNsProp(point_cloud_node, point_cloud_ns,
+               ToXmlChar("PositionEncoding"), ToXmlChar("Draco"));
+
+  DeserializerImpl deserializer(description_node);
+  EXPECT_EQ(nullptr, PointCloud::FromDeserializer(deserializer));
+
+  xmlFreeNs(camera_ns);
+  xmlFreeNs(point_cloud_ns);
+}
+
+TEST(PointCloud, ReadMetadataTypedViews) {
+  std::unique_ptr<XmpData> xmp_data = CreateXmpData(true);
+  xmlNodePtr description_node =
+      GetFirstDescriptionElement(xmp_data->ExtendedSection());
+  xmlNodePtr camera_node = xmlNewNode(nullptr, ToXmlChar("Camera"));
+  xmlAddChild(description_node, camera_node);
+  xmlNsPtr camera_ns = xmlNewNs(nullptr, ToXmlChar(kNamespaceHref),
+                                ToXmlChar(XdmConst::Camera()));
+  xmlNodePtr point_cloud_node =
+      xmlNewNode(camera_ns, ToXmlChar(XdmConst::PointCloud()));
+  xmlAddChild(camera_node, point_cloud_node);
+
+  const std::vector<PointPosition> points = {
+      {1.0f, 2.0f, 3.0f}, {4.0f, 5.0f, 6.0f}, {7.0f, 8.0f, 9.0f}};
+  string base64_encoded_position;
+  ASSERT_TRUE(EncodeBase64(PositionData(points), &base64_encoded_position));
+  xmlNsPtr point_cloud_ns = xmlNewNs(nullptr, ToXmlChar(kNamespaceHref),
+                                     ToXmlChar(XdmConst::PointCloud()));
+  xmlSetNsProp(point_cloud_node, point_cloud_ns, ToXmlChar("Count"),
+               ToXmlChar("3"));
+  xmlSetNsProp(point_cloud_node, point_cloud_ns, ToXmlChar("Position"),
+               ToXmlChar(base64_encoded_position.data()));
+
+  DeserializerImpl deserializer(description_node);
+  std::unique_ptr<PointCloud> point_cloud =
+      PointCloud::FromDeserializer(deserializer);
+  ASSERT_NE(nullptr, point_cloud.get());
+  const PointCloudView<PointPosition> positions = point_cloud->GetPositions();
+  ASSERT_EQ(3, positions.size());
+  EXPECT_EQ(8.0f, positions[2].y);
+  EXPECT_TRUE(point_cloud->GetColors().empty());
+
+  xmlFreeNs(camera_ns);
+  xmlFreeNs(point_cloud_ns);
+}
+
 }  // namespace
 }  // namespace xdm
 }  // namespace xmpmeta
@@ -48,15 +48,9 @@ std::unique_ptr<Profiles> Profiles::FromProfileArray(
 std::unique_ptr<Profiles>
 Profiles::FromDeserializer(const Deserializer& parent_deserializer) {
   std::unique_ptr<Profiles> profiles(new Profiles());
-  int i = 0;
-  for (std::unique_ptr<Deserializer> deserializer =
-       parent_deserializer.CreateDeserializerFromListElementAt(
-           XdmConst::Namespace(XdmConst::Profiles()), XdmConst::Profiles(), i);
-       deserializer != nullptr;
-       deserializer =
-          parent_deserializer.CreateDeserializerFromListElementAt(
-              XdmConst::Namespace(XdmConst::Profiles()), XdmConst::Profiles(),
-              ++i)) {
+  for (const auto& deserializer :
+       parent_deserializer.CreateListElementDeserializers(
+           XdmConst::Namespace(XdmConst::Profiles()), XdmConst::Profiles())) {
     std::unique_ptr<Profile> profile = Profile::FromDeserializer(*deserializer);
     if (profile != nullptr) {
       profiles->profile_list_.emplace_back(std::move(profile));
@@ -14,26 +14,165 @@
 
 #include "xmpmeta/base64.h"
 
+#include "glog/logging.h"
 #include "strings/escaping.h"
 
 namespace xmpmeta {
+namespace {
+
+const int kInvalid = -1;
+const int kWhitespace = -2;
+const int kPadding = -3;
+
+// Returns the 6-bit value of a regular or web-safe base64 character, or one of
+// the negative constants above.
+int DecodeBase64Char(char c) {
+  if (c >= 'A' && c <= 'Z') {
+    return c - 'A';
+  }
+  if (c >= 'a' && c <= 'z') {
+    return c - 'a' + 26;
+  }
+  if (c >= '0' && c <= '9') {
+    return c - '0' + 52;
+  }
+  switch (c) {
+    case '+':
+    case '-':
+      return 62;
+    case '/':
+    case '_':
+      return 63;
+    case '=':
+      return kPadding;
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+      return kWhitespace;
+    default:
+      return kInvalid;
+  }
+}
+
+}  // namespace
 
 // Decodes the base64-encoded input range.
 bool DecodeBase64(const string& data, string* output) {
+  return DecodeBase64(data.data(), data.size(), output);
+}
+
+bool DecodeBase64(const char* data, size_t size, string* output) {
   // Support decoding of both web-safe and regular base64.
   // "Web-safe" base-64 replaces + with - and / with _, and omits
-  // trailing = padding characters.
-  if (strings::Base64Unescape(data, output)) {
-    return true;
-  }
-  return strings::WebSafeBase64Unescape(data, output);
+  // trailing = padding characters. Both are decoded in one pass, into an
+  // output sized from the input length; whitespace is skipped.
+  return strings::AnyBase64Unescape(data, size, output);
+}
+
+size_t MaxDecodedBase64Size(size_t size) {
+  // Every four characters decode to three bytes. Leftover characters are
+  // counted in full, as the decoder sizes its output the same way.
+  return 3 * (size / 4) + size % 4;
+}
+
+bool DecodeBase64(const char* data, size_t size, char* output,
+                  size_t output_size, size_t* decoded_size) {
+  return strings::AnyBase64Unescape(data, size, output, output_size,
+                                    decoded_size);
 }
 
 // Base64-encodes the given data.
 bool EncodeBase64(const string& data, string* output) {
-  strings::Base64Escape(reinterpret_cast<const uint8*>(data.c_str()),
-                        data.length(), output, false);
+  return EncodeBase64(data.data(), data.length(), output);
+}
+
+bool EncodeBase64(const char* data, size_t size, string* output) {
+  strings::Base64Escape(reinterpret_cast<const uint8*>(data), size, output,
+                        false);
   return output->length() > 0;
 }
 
+const size_t Base64Decoder::kChunkSize;
+
+Base64Decoder::Base64Decoder(const DataSink& sink)
+    : sink_(sink), group_(0), group_size_(0), padded_(false), failed_(false) {
+  buffer_.reserve(kChunkSize);
+}
+
+bool Base64Decoder::Update(const char* data, size_t size) {
+  if (failed_) {
+    return false;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    const int value = DecodeBase64Char(data[i]);
+    if (value >= 0) {
+      if (padded_) {
+        LOG(WARNING) << "Base64 data after padding";
+        failed_ = true;
+        return false;
+      }
+      group_ = group_ << 6 | static_cast<uint32_t>(value);
+      if (++group_size_ < 4) {
+        continue;
+      }
+      if (buffer_.size() + 3 > kChunkSize && !Flush()) {
+        return false;
+      }
+      buffer_.push_back(static_cast<char>(group_ >> 16));
+      buffer_.push_back(static_cast<char>(group_ >> 8));
+      buffer_.push_back(static_cast<char>(group_));
+      group_ = 0;
+      group_size_ = 0;
+    } else if (value == kPadding) {
+      // Padding may only complete a group of two or three characters.
+      if (!padded_ && group_size_ < 2) {
+        LOG(WARNING) << "Unexpected base64 padding";
+        failed_ = true;
+        return false;
+      }
+      padded_ = true;
+    } else if (value == kInvalid) {
+      LOG(WARNING) << "Invalid base64 character: " << data[i];
+      failed_ = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Base64Decoder::Finish() {
+  if (failed_) {
+    return false;
+  }
+  if (group_size_ == 1) {
+    LOG(WARNING) << "Base64 data ends in a partial group";
+    failed_ = true;
+    return false;
+  }
+  if (buffer_.size() + 2 > kChunkSize && !Flush()) {
+    return false;
+  }
+  if (group_size_ == 2) {
+    buffer_.push_back(static_cast<char>(group_ >> 4));
+  } else if (group_size_ == 3) {
+    buffer_.push_back(static_cast<char>(group_ >> 10));
+    buffer_.push_back(static_cast<char>(group_ >> 2));
+  }
+  group_ = 0;
+  group_size_ = 0;
+  padded_ = false;
+  return Flush();
+}
+
+bool Base64Decoder::Flush() {
+  if (!buffer_.empty() && !sink_(buffer_.data(), buffer_.size())) {
+    LOG(WARNING) << "Base64 sink failed";
+    failed_ = true;
+    return false;
+  }
+  buffer_.clear();
+  return true;
+}
+
 }  // namespace xmpmeta
@@ -15,19 +15,82 @@
 #ifndef XMPMETA_BASE64_H_
 #define XMPMETA_BASE64_H_
 
+#include <cstdint>
+#include <functional>
 #include <string>
 
 #include "base/port.h"
 
 namespace xmpmeta {
+// Receives consecutive pieces of data. Returns false to stop reading.
+typedef std::function<bool(const char* data, size_t size)> DataSink;
+
 // Decodes the base64-encoded input range. Supports decoding of both web-safe
 // and regular base64."Web-safe" base-64 replaces + with - and / with _, and
-// omits trailing = padding characters.
+// omits trailing = padding characters. Whitespace, such as the line breaks in
+// long attribute values, is skipped. The input is read once.
 bool DecodeBase64(const string& data, string* output);
 
+// Same as above, for the given range of characters.
+bool DecodeBase64(const char* data, size_t size, string* output);
+
+// Returns the most bytes that size characters of base64 can decode to.
+size_t MaxDecodedBase64Size(size_t size);
+
+// Same as above, but decodes into output, which has room for output_size
+// bytes, and sets decoded_size to the number of bytes written. An output of
+// MaxDecodedBase64Size(size) bytes is always large enough.
+bool DecodeBase64(const char* data, size_t size, char* output,
+                  size_t output_size, size_t* decoded_size);
+
 // Base64-encodes the given string.
 bool EncodeBase64(const string& data, string* output);
 
-}  // namespace meta
+// Same as above, for the given range of bytes.
+bool EncodeBase64(const char* data, size_t size, string* output);
+
+// Decodes base64 data that arrives in pieces, passing the decoded bytes to a
+// DataSink in chunks of at most kChunkSize bytes. Accepts both web-safe and
+// regular base64, with or without trailing = padding, and skips whitespace.
+// Example:
+//   Base64Decoder decoder([&](const char* data, size_t size) {
+//     output.write(data, size);
+//     return output.good();
+//   });
+//   if (!decoder.Update(piece.data(), piece.size()) || !decoder.Finish()) {
+//     ...
+//   }
+class Base64Decoder {
+ public:
+  // The largest number of bytes passed to the sink at once.
+  static const size_t kChunkSize = 64 * 1024;
+
+  explicit Base64Decoder(const DataSink& sink);
+
+  // Decodes the given piece of input. Returns false if it is not valid base64
+  // or if the sink fails.
+  bool Update(const char* data, size_t size);
+
+  // Decodes any remaining partial group and flushes the output. Returns false
+  // if the input ended in the middle of a group or if the sink fails.
+  bool Finish();
+
+  // Disallow copying.
+  Base64Decoder(const Base64Decoder&) = delete;
+  void operator=(const Base64Decoder&) = delete;
+
+ private:
+  bool Flush();
+
+  DataSink sink_;
+  string buffer_;
+  // The bits of the current group, and how many characters they came from.
+  uint32_t group_;
+  int group_size_;
+  bool padded_;
+  bool failed_;
+};
+
+}  // namespace xmpmeta
 
 #endif  // XMPMETA_BASE64_H_
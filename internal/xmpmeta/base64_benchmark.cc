@@ -0,0 +1,51 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/base64.h"
+
+#include <string>
+
+#include "glog/logging.h"
+#include "xmpmeta/benchmark.h"
+
+namespace xmpmeta {
+namespace {
+
+// Returns a name such as 100K for a size in bytes.
+string SizeName(size_t size) {
+  return size >= (1 << 20) ? std::to_string(size >> 20) + "M"
+                           : std::to_string(size >> 10) + "K";
+}
+
+// Measures EncodeBase64 and DecodeBase64 throughput, in bytes of binary
+// data, from 1 KB to the 100 MB of a large right-eye image.
+void BM_Base64() {
+  for (size_t size : {1 << 10, 100 << 10, 10 << 20, 100 << 20}) {
+    string data(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = static_cast<char>(i * 131 + (i >> 8));
+    }
+    string encoded;
+    RunBenchmarkCase("EncodeBase64/" + SizeName(size), size, 0,
+                     [&]() { CHECK(EncodeBase64(data, &encoded)); });
+    string decoded;
+    RunBenchmarkCase("DecodeBase64/" + SizeName(size), size, 0,
+                     [&]() { CHECK(DecodeBase64(encoded, &decoded)); });
+    CHECK(decoded == data);
+  }
+}
+XMPMETA_BENCHMARK(BM_Base64);
+
+}  // namespace
+}  // namespace xmpmeta
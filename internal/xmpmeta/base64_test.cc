@@ -14,6 +14,7 @@
 
 #include "xmpmeta/base64.h"
 
+#include <algorithm>
 #include <sstream>
 #include <string>
 
@@ -43,5 +44,115 @@ TEST(Base64, EncodeAndDecodeBase64) {
   ASSERT_EQ(data, decoded);
 }
 
+// Decodes input with a Base64Decoder, feeding it piece_size bytes at a time.
+bool DecodeInPieces(const string& input, size_t piece_size, string* output,
+                    size_t* max_chunk_size) {
+  *max_chunk_size = 0;
+  Base64Decoder decoder([&](const char* data, size_t size) {
+    *max_chunk_size = std::max(*max_chunk_size, size);
+    output->append(data, size);
+    return true;
+  });
+  for (size_t i = 0; i < input.size(); i += piece_size) {
+    if (!decoder.Update(input.data() + i,
+                        std::min(piece_size, input.size() - i))) {
+      return false;
+    }
+  }
+  return decoder.Finish();
+}
+
+TEST(Base64, DecoderMatchesDecodeBase64) {
+  string data;
+  for (int i = 0; i < 3 * Base64Decoder::kChunkSize + 2; i++) {
+    data.push_back(static_cast<char>(i * 7));
+  }
+  string encoded;
+  ASSERT_TRUE(EncodeBase64(data, &encoded));
+
+  for (size_t piece_size : {1, 5, 4096, 1 << 20}) {
+    string decoded;
+    size_t max_chunk_size;
+    ASSERT_TRUE(DecodeInPieces(encoded, piece_size, &decoded,
+                               &max_chunk_size));
+    EXPECT_EQ(data, decoded);
+    EXPECT_LE(max_chunk_size, Base64Decoder::kChunkSize);
+  }
+}
+
+TEST(Base64, DecodeBase64AtEveryLengthAndOffset) {
+  string data;
+  for (int i = 0; i < 48; i++) {
+    data.push_back(static_cast<char>(i * 37 + 11));
+  }
+  for (size_t length = 0; length <= data.size(); length++) {
+    string encoded;
+    EncodeBase64(data.substr(0, length), &encoded);
+    string decoded;
+    ASSERT_TRUE(DecodeBase64(encoded, &decoded));
+    EXPECT_EQ(data.substr(0, length), decoded);
+
+    // A newline or an invalid character anywhere in the input must be seen
+    // by the decoder, wherever it falls in a group of characters.
+    for (size_t position = 0; position < encoded.size(); position++) {
+      string wrapped = encoded;
+      wrapped.insert(position, "\n");
+      ASSERT_TRUE(DecodeBase64(wrapped, &decoded));
+      EXPECT_EQ(data.substr(0, length), decoded);
+
+      string invalid = encoded;
+      invalid[position] = '*';
+      EXPECT_FALSE(DecodeBase64(invalid, &decoded));
+    }
+  }
+}
+
+TEST(Base64, DecodeBase64AcceptsWebSafeAndWhitespace) {
+  string decoded;
+  ASSERT_TRUE(DecodeBase64("-_-_ZGF0\r\nYQ", &decoded));
+  EXPECT_EQ("\xfb\xff\xbf" "data", decoded);
+
+  // The two alphabets may also be mixed.
+  ASSERT_TRUE(DecodeBase64(" +_-/ ZGF0YQ==\n", &decoded));
+  EXPECT_EQ("\xfb\xff\xbf" "data", decoded);
+
+  EXPECT_FALSE(DecodeBase64("ZGF0YQ=*", &decoded));
+  EXPECT_TRUE(decoded.empty());
+}
+
+TEST(Base64, DecoderAcceptsPaddingWhitespaceAndWebSafe) {
+  string decoded;
+  size_t max_chunk_size;
+  ASSERT_TRUE(DecodeInPieces("+/+/ ZGF0\nYQ==", 3, &decoded,
+                             &max_chunk_size));
+  EXPECT_EQ("\xfb\xff\xbf" "data", decoded);
+
+  decoded.clear();
+  ASSERT_TRUE(DecodeInPieces("-_-_ZGF0YQ", 3, &decoded, &max_chunk_size));
+  EXPECT_EQ("\xfb\xff\xbf" "data", decoded);
+}
+
+TEST(Base64, DecoderRejectsInvalidInput) {
+  string decoded;
+  size_t max_chunk_size;
+  EXPECT_FALSE(DecodeInPieces("ZGF0YQ*=", 2, &decoded, &max_chunk_size));
+  EXPECT_FALSE(DecodeInPieces("ZGF0Y", 2, &decoded, &max_chunk_size));
+  EXPECT_FALSE(DecodeInPieces("ZGF0YQ==ZGF0", 2, &decoded, &max_chunk_size));
+  EXPECT_FALSE(DecodeInPieces("ZGF0=", 2, &decoded, &max_chunk_size));
+}
+
+TEST(Base64, DecoderStopsWhenSinkFails) {
+  int calls = 0;
+  Base64Decoder decoder([&calls](const char* data, size_t size) {
+    ++calls;
+    return false;
+  });
+  const string encoded(4 * Base64Decoder::kChunkSize, 'A');
+  EXPECT_FALSE(decoder.Update(encoded.data(), encoded.size()));
+  EXPECT_FALSE(decoder.Update(encoded.data(), encoded.size()));
+  EXPECT_FALSE(decoder.Finish());
+  EXPECT_EQ(1, calls);
+}
+
 }  // namespace
 }  // namespace xmpmeta
@@ -0,0 +1,292 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/batch_xmp_reader.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <libxml/parser.h>
+
+#include "xmpmeta/xmp_parser.h"
+
+namespace xmpmeta {
+namespace {
+
+std::once_flag xml_init_flag;
+
+// Returns the size of the file, or zero if it cannot be determined.
+size_t GetFileSize(const string& filename) {
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  const std::streamoff size = file ? static_cast<std::streamoff>(file.tellg())
+                                   : 0;
+  return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+// One batch of inputs, shared by the worker threads and the calling thread.
+// Workers claim inputs in order and are admitted in the same order, so the
+// inputs being read or waiting for delivery are always a contiguous range.
+// This guarantees that the next input to deliver in order is admitted even
+// under the memory cap.
+class BatchRun {
+ public:
+  // Returns the cost of the input at an index, for the memory cap.
+  typedef std::function<size_t(size_t index)> CostFunction;
+  // Reads the input at an index into xmp_data.
+  typedef std::function<bool(size_t index, XmpData* xmp_data)> ReadFunction;
+
+  BatchRun(const BatchXmpReaderOptions& options, size_t count,
+           const CostFunction& cost, const ReadFunction& read)
+      : options_(options), count_(count), cost_(cost), read_(read),
+        next_claim_(0), next_admission_(0), next_delivery_(0),
+        in_flight_count_(0), in_flight_bytes_(0) {}
+
+  // Claims, admits and reads inputs until there are none left. Called on each
+  // worker thread.
+  void Work() {
+    while (true) {
+      size_t index;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (next_claim_ == count_) {
+          return;
+        }
+        index = next_claim_++;
+      }
+      // Determine the cost outside the lock, since it may touch the disk.
+      const size_t cost = cost_(index);
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        admission_.wait(lock, [&] {
+          return next_admission_ == index && Admits(cost);
+        });
+        ++next_admission_;
+        ++in_flight_count_;
+        in_flight_bytes_ += cost;
+        costs_[index] = cost;
+      }
+      admission_.notify_all();
+
+      BatchXmpResult result;
+      result.index = index;
+      result.xmp_data.reset(new XmpData());
+      result.success = read_(index, result.xmp_data.get());
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completed_.emplace(index, std::move(result));
+      }
+      delivery_.notify_one();
+    }
+  }
+
+  // Delivers every result to callback on this thread, as the workers produce
+  // them.
+  void Deliver(const BatchXmpReader::Callback& callback) {
+    for (size_t delivered = 0; delivered < count_; ++delivered) {
+      size_t cost;
+      BatchXmpResult result = NextResult(&cost);
+      callback(&result);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_bytes_ -= cost;
+        --in_flight_count_;
+      }
+      admission_.notify_all();
+    }
+  }
+
+ private:
+
+  // Returns true if an input of the given cost may start. Requires mutex_.
+  bool Admits(size_t cost) const {
+    return options_.max_in_flight_bytes == 0 || in_flight_count_ == 0 ||
+           in_flight_bytes_ + cost <= options_.max_in_flight_bytes;
+  }
+
+  // Waits for and removes the next result to deliver, and sets cost to the
+  // cost its input was admitted with.
+  BatchXmpResult NextResult(size_t* cost) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    delivery_.wait(lock, [this] {
+      return options_.ordered ? completed_.count(next_delivery_) > 0
+                              : !completed_.empty();
+    });
+    auto it = options_.ordered ? completed_.find(next_delivery_)
+                               : completed_.begin();
+    BatchXmpResult result = std::move(it->second);
+    completed_.erase(it);
+    ++next_delivery_;
+    auto cost_it = costs_.find(result.index);
+    *cost = cost_it->second;
+    costs_.erase(cost_it);
+    return result;
+  }
+
+  const BatchXmpReaderOptions& options_;
+  const size_t count_;
+  const CostFunction cost_;
+  const ReadFunction read_;
+
+  std::mutex mutex_;
+  // Signaled when an input is admitted or a result is delivered.
+  std::condition_variable admission_;
+  // Signaled when a result is ready.
+  std::condition_variable delivery_;
+  size_t next_claim_;
+  size_t next_admission_;
+  size_t next_delivery_;
+  size_t in_flight_count_;
+  size_t in_flight_bytes_;
+  // The costs of the admitted inputs whose results are not yet delivered.
+  std::map<size_t, size_t> costs_;
+  // Results that are ready, by index.
+  std::map<size_t, BatchXmpResult> completed_;
+};
+
+// Returns the number of worker threads to start for the options.
+size_t GetNumThreads(const BatchXmpReaderOptions& options) {
+  const size_t num_threads = options.num_threads > 0
+                                 ? options.num_threads
+                                 : std::thread::hardware_concurrency();
+  return std::max<size_t>(1, num_threads);
+}
+
+}  // namespace
+
+// Worker threads that live as long as the reader. They sleep until a batch
+// starts, each call its work function, and sleep again once all have
+// returned from it.
+class BatchXmpReader::WorkerPool {
+ public:
+  explicit WorkerPool(size_t num_threads)
+      : work_(nullptr), generation_(0), num_working_(0), stopping_(false) {
+    for (size_t i = 0; i < num_threads; ++i) {
+      threads_.emplace_back(&WorkerPool::Loop, this);
+    }
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    start_.notify_all();
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  // Calls work on every worker thread and deliver on this one, and returns
+  // once all of them have returned. One batch runs at a time.
+  void Run(const std::function<void()>& work,
+           const std::function<void()>& deliver) {
+    std::lock_guard<std::mutex> batch_lock(batch_mutex_);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      work_ = &work;
+      ++generation_;
+      num_working_ = threads_.size();
+    }
+    start_.notify_all();
+    deliver();
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return num_working_ == 0; });
+    work_ = nullptr;
+  }
+
+ private:
+  void Loop() {
+    size_t last_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      start_.wait(lock, [&] {
+        return stopping_ || generation_ != last_generation;
+      });
+      if (stopping_) {
+        return;
+      }
+      last_generation = generation_;
+      const std::function<void()>* work = work_;
+      lock.unlock();
+      (*work)();
+      lock.lock();
+      if (--num_working_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  // Held for the whole of a batch.
+  std::mutex batch_mutex_;
+  std::mutex mutex_;
+  // Signaled when a batch starts or the pool stops.
+  std::condition_variable start_;
+  // Signaled when the last worker returns from the work of a batch.
+  std::condition_variable done_;
+  const std::function<void()>* work_;
+  size_t generation_;
+  size_t num_working_;
+  bool stopping_;
+};
+
+BatchXmpReader::BatchXmpReader(const BatchXmpReaderOptions& options)
+    : options_(options), pool_(new WorkerPool(GetNumThreads(options))) {
+  std::call_once(xml_init_flag, xmlInitParser);
+}
+
+BatchXmpReader::~BatchXmpReader() {}
+
+void BatchXmpReader::ReadFiles(const std::vector<string>& filenames,
+                               const Callback& callback) const {
+  // Documents are parsed without an XmpParserContext. Documents from a context
+  // share its dictionary, which the worker keeps adding to while the caller
+  // uses or frees the documents it has been given.
+  const bool skip_extended = options_.skip_extended;
+  BatchRun run(
+      options_, filenames.size(),
+      [&filenames](size_t index) { return GetFileSize(filenames[index]); },
+      [&filenames, skip_extended](size_t index, XmpData* xmp_data) {
+        return ReadXmpHeader(filenames[index], skip_extended, xmp_data);
+      });
+  pool_->Run([&run] { run.Work(); }, [&] { run.Deliver(callback); });
+}
+
+std::vector<BatchXmpResult> BatchXmpReader::ReadFiles(
+    const std::vector<string>& filenames) const {
+  std::vector<BatchXmpResult> results(filenames.size());
+  ReadFiles(filenames, [&results](BatchXmpResult* result) {
+    results[result->index] = std::move(*result);
+  });
+  return results;
+}
+
+void BatchXmpReader::ReadBuffers(const std::vector<string>& jpeg_contents,
+                                 const Callback& callback) const {
+  const bool skip_extended = options_.skip_extended;
+  BatchRun run(
+      options_, jpeg_contents.size(),
+      [&jpeg_contents](size_t index) { return jpeg_contents[index].size(); },
+      [&jpeg_contents, skip_extended](size_t index, XmpData* xmp_data) {
+        return ReadXmpFromMemory(jpeg_contents[index], skip_extended,
+                                 xmp_data);
+      });
+  pool_->Run([&run] { run.Work(); }, [&] { run.Deliver(callback); });
+}
+
+}  // namespace xmpmeta
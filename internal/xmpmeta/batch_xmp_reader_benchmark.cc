@@ -0,0 +1,63 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/batch_xmp_reader.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "xmpmeta/benchmark.h"
+#include "xmpmeta/file.h"
+
+namespace xmpmeta {
+namespace {
+
+// The number of copies of the testdata JPEG in the corpus.
+const int kCorpusSize = 128;
+
+// Measures files per second for BatchXmpReader::ReadBuffers with 1 up to the
+// number of hardware threads, over copies of the VR photo in testdata, whose
+// standard and extended XMP are both read.
+void BM_ReadBuffers() {
+  string jpeg;
+  ReadFileToStringOrDie(BenchmarkDataPath("left_with_xmp.jpg"), &jpeg);
+  const std::vector<string> corpus(kCorpusSize, jpeg);
+  const int64 corpus_bytes = static_cast<int64>(jpeg.size()) * kCorpusSize;
+
+  const int max_threads =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  for (int num_threads = 1;; num_threads = std::min(2 * num_threads,
+                                                     max_threads)) {
+    BatchXmpReaderOptions options;
+    options.num_threads = num_threads;
+    BatchXmpReader reader(options);
+    RunBenchmarkCase(
+        "ReadBuffers/" + std::to_string(num_threads) + "threads",
+        corpus_bytes, corpus.size(), [&]() {
+          reader.ReadBuffers(corpus, [](BatchXmpResult* result) {
+            CHECK(result->success);
+          });
+        });
+    if (num_threads == max_threads) {
+      break;
+    }
+  }
+}
+XMPMETA_BENCHMARK(BM_ReadBuffers);
+
+}  // namespace
+}  // namespace xmpmeta
@@ -0,0 +1,189 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/batch_xmp_reader.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/test_util.h"
+#include "xmpmeta/test_xmp_creator.h"
+#include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/utils.h"
+
+using xmpmeta::xml::DeserializerImpl;
+using xmpmeta::xml::GetFirstDescriptionElement;
+
+namespace xmpmeta {
+namespace {
+
+const int kNumInputs = 24;
+const char kBadPath[] = "bad_path.jpg";
+
+// Returns the contents of a JPEG whose standard section has the given mime.
+string MakeJpegWithMime(const string& mime) {
+  const string body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
+      "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+      "    <rdf:Description rdf:about=\"\"\n"
+      "      xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\"\n"
+      "      GImage:Mime=\"" + mime + "\"/>\n"
+      "  </rdf:RDF>\n"
+      "</x:xmpmeta>\n";
+  return TestXmpCreator::MakeJPEGFileContents(
+      {TestXmpCreator::CreateStandardXmpString(body)});
+}
+
+string MimeForInput(int index) { return "image/" + std::to_string(index); }
+
+// Returns the GImage:Mime of the standard section.
+string GetMime(const XmpData& xmp_data) {
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(xmp_data.StandardSection()));
+  string mime;
+  deserializer.ParseString("GImage", "Mime", &mime);
+  return mime;
+}
+
+std::vector<string> MakeBuffers() {
+  std::vector<string> buffers;
+  for (int i = 0; i < kNumInputs; ++i) {
+    buffers.push_back(MakeJpegWithMime(MimeForInput(i)));
+  }
+  return buffers;
+}
+
+TEST(BatchXmpReader, ReadFilesInOrder) {
+  std::vector<string> filenames;
+  for (int i = 0; i < kNumInputs; ++i) {
+    filenames.push_back(
+        TempFileAbsolutePath("batch_" + std::to_string(i) + ".jpg"));
+    TestXmpCreator::WriteJPEGFile(
+        filenames.back(),
+        {TestXmpCreator::CreateStandardXmpString(
+            "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+            "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+            "<rdf:Description rdf:about=\"\""
+            " xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+            " GImage:Mime=\"" + MimeForInput(i) + "\"/>"
+            "</rdf:RDF></x:xmpmeta>")});
+  }
+  filenames.push_back(kBadPath);
+
+  BatchXmpReaderOptions options;
+  options.num_threads = 4;
+  BatchXmpReader reader(options);
+  std::vector<BatchXmpResult> results = reader.ReadFiles(filenames);
+  ASSERT_EQ(filenames.size(), results.size());
+  for (int i = 0; i < kNumInputs; ++i) {
+    EXPECT_EQ(i, results[i].index);
+    ASSERT_TRUE(results[i].success);
+    EXPECT_EQ(MimeForInput(i), GetMime(*results[i].xmp_data));
+  }
+  EXPECT_FALSE(results.back().success);
+  EXPECT_NE(nullptr, results.back().xmp_data);
+}
+
+TEST(BatchXmpReader, ReadBuffersDeliversInOrderOnCallingThread) {
+  const std::vector<string> buffers = MakeBuffers();
+  BatchXmpReaderOptions options;
+  options.num_threads = 8;
+  BatchXmpReader reader(options);
+
+  const std::thread::id caller = std::this_thread::get_id();
+  size_t next_index = 0;
+  reader.ReadBuffers(buffers, [&](BatchXmpResult* result) {
+    EXPECT_EQ(caller, std::this_thread::get_id());
+    EXPECT_EQ(next_index, result->index);
+    ASSERT_TRUE(result->success);
+    EXPECT_EQ(MimeForInput(result->index), GetMime(*result->xmp_data));
+    ++next_index;
+  });
+  EXPECT_EQ(buffers.size(), next_index);
+}
+
+TEST(BatchXmpReader, ReadBuffersUnordered) {
+  const std::vector<string> buffers = MakeBuffers();
+  BatchXmpReaderOptions options;
+  options.num_threads = 3;
+  options.ordered = false;
+  BatchXmpReader reader(options);
+
+  std::vector<int> deliveries(buffers.size(), 0);
+  reader.ReadBuffers(buffers, [&](BatchXmpResult* result) {
+    ASSERT_LT(result->index, deliveries.size());
+    ++deliveries[result->index];
+    EXPECT_EQ(MimeForInput(result->index), GetMime(*result->xmp_data));
+  });
+  for (int count : deliveries) {
+    EXPECT_EQ(1, count);
+  }
+}
+
+TEST(BatchXmpReader, ReadBuffersUnderMemoryCap) {
+  const std::vector<string> buffers = MakeBuffers();
+  for (const bool ordered : {true, false}) {
+    BatchXmpReaderOptions options;
+    options.num_threads = 4;
+    options.ordered = ordered;
+    // Smaller than any single input, so inputs are read one at a time.
+    options.max_in_flight_bytes = 1;
+    BatchXmpReader reader(options);
+
+    size_t delivered = 0;
+    reader.ReadBuffers(buffers, [&](BatchXmpResult* result) {
+      EXPECT_TRUE(result->success);
+      ++delivered;
+    });
+    EXPECT_EQ(buffers.size(), delivered);
+  }
+}
+
+TEST(BatchXmpReader, ReusesReaderAcrossBatchesAndThreads) {
+  const std::vector<string> buffers = MakeBuffers();
+  BatchXmpReaderOptions options;
+  options.num_threads = 4;
+  BatchXmpReader reader(options);
+
+  // Batches from several threads share the reader's workers in turn.
+  std::vector<std::thread> callers;
+  std::vector<size_t> delivered(3, 0);
+  for (size_t caller = 0; caller < delivered.size(); ++caller) {
+    callers.emplace_back([&, caller] {
+      for (int batch = 0; batch < 5; ++batch) {
+        reader.ReadBuffers(buffers, [&](BatchXmpResult* result) {
+          EXPECT_EQ(MimeForInput(result->index), GetMime(*result->xmp_data));
+          ++delivered[caller];
+        });
+      }
+    });
+  }
+  for (std::thread& caller : callers) {
+    caller.join();
+  }
+  for (size_t count : delivered) {
+    EXPECT_EQ(5 * buffers.size(), count);
+  }
+}
+
+TEST(BatchXmpReader, ReadNothing) {
+  const BatchXmpReaderOptions options;
+  BatchXmpReader reader(options);
+  EXPECT_TRUE(reader.ReadFiles(std::vector<string>()).empty());
+}
+
+}  // namespace
+}  // namespace xmpmeta
@@ -0,0 +1,158 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Runs the benchmarks registered with XMPMETA_BENCHMARK. See benchmark.h.
+
+#include "xmpmeta/benchmark.h"
+
+#include <libxml/parser.h>
+#include <libxml/xmlmemory.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Counts every allocation made through operator new or libxml2.
+std::atomic<int64> allocation_count(0);
+
+void* CountedMalloc(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return malloc(size);
+}
+
+void* CountedRealloc(void* pointer, size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return realloc(pointer, size);
+}
+
+char* CountedStrdup(const char* text) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return strdup(text);
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  void* pointer = CountedMalloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void* pointer) noexcept { free(pointer); }
+
+void operator delete[](void* pointer) noexcept { free(pointer); }
+
+namespace xmpmeta {
+namespace {
+
+double min_time_seconds = 0.5;
+string testdata_dir = "testdata";
+
+std::vector<std::pair<const char*, BenchmarkFunction>>* Benchmarks() {
+  static std::vector<std::pair<const char*, BenchmarkFunction>> benchmarks;
+  return &benchmarks;
+}
+
+}  // namespace
+
+bool RegisterBenchmark(const char* name, BenchmarkFunction function) {
+  Benchmarks()->emplace_back(name, function);
+  return true;
+}
+
+void RunBenchmarkCase(const string& name, int64 bytes_per_call,
+                      int64 items_per_call,
+                      const std::function<void()>& function) {
+  typedef std::chrono::steady_clock Clock;
+  // Warm up caches and any lazily built state.
+  function();
+  int64 calls = 1;
+  double seconds = 0;
+  int64 allocations = 0;
+  while (true) {
+    const int64 first_allocation = allocation_count.load();
+    const Clock::time_point start = Clock::now();
+    for (int64 i = 0; i < calls; ++i) {
+      function();
+    }
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    allocations = allocation_count.load() - first_allocation;
+    if (seconds >= min_time_seconds) {
+      break;
+    }
+    // Aim a little past the minimum time, growing at most 10 times per step.
+    const double scale = seconds > 0 ? 1.2 * min_time_seconds / seconds : 10;
+    calls = static_cast<int64>(calls * (scale < 10 ? scale : 10)) + 1;
+  }
+
+  printf("%-48s %10lld calls %12.0f ns/call", name.c_str(),
+         static_cast<long long>(calls), 1e9 * seconds / calls);
+  if (bytes_per_call > 0) {
+    printf(" %9.1f MB/s", bytes_per_call * calls / seconds / 1e6);
+  }
+  if (items_per_call > 0) {
+    printf(" %12.0f items/s", items_per_call * calls / seconds);
+  }
+  printf(" %10.1f allocs/call\n", static_cast<double>(allocations) / calls);
+  fflush(stdout);
+}
+
+string BenchmarkDataPath(const string& filename) {
+  return testdata_dir + "/" + filename;
+}
+
+}  // namespace xmpmeta
+
+int main(int argc, char** argv) {
+  // Must come before libxml2 allocates anything.
+  xmlMemSetup(free, CountedMalloc, CountedRealloc, CountedStrdup);
+  xmlInitParser();
+
+  std::vector<string> filters;
+  for (int i = 1; i < argc; ++i) {
+    const string argument = argv[i];
+    if (argument.compare(0, 11, "--min_time=") == 0) {
+      xmpmeta::min_time_seconds = atof(argument.c_str() + 11);
+    } else if (argument.compare(0, 11, "--testdata=") == 0) {
+      xmpmeta::testdata_dir = argument.substr(11);
+    } else {
+      filters.push_back(argument);
+    }
+  }
+
+  for (const auto& benchmark : *xmpmeta::Benchmarks()) {
+    bool selected = filters.empty();
+    for (const string& filter : filters) {
+      selected = selected || strstr(benchmark.first, filter.c_str()) != nullptr;
+    }
+    if (selected) {
+      benchmark.second();
+    }
+  }
+  xmlCleanupParser();
+  return 0;
+}
@@ -0,0 +1,80 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_BENCHMARK_H_
+#define XMPMETA_BENCHMARK_H_
+
+#include <functional>
+#include <string>
+
+#include "base/integral_types.h"
+#include "base/port.h"
+
+// A small harness for the xmpmeta_benchmark binary. The cases of a module live
+// next to it in <module>_benchmark.cc, the way its tests live in
+// <module>_test.cc. Each file registers functions that time one or more cases
+// with RunBenchmarkCase.
+// Example:
+//   void BM_EncodeBase64() {
+//     const string data(1 << 20, 'x');
+//     string base64;
+//     RunBenchmarkCase("EncodeBase64/1M", data.size(), 0,
+//                      [&]() { EncodeBase64(data, &base64); });
+//   }
+//   XMPMETA_BENCHMARK(BM_EncodeBase64);
+//
+// Usage, from the root of the repository so that testdata/ is found:
+//   xmpmeta_benchmark [--min_time=<seconds>] [--testdata=<dir>] [filter...]
+// Only the benchmarks whose function names contain one of the filters run.
+// Each case prints its mean time per call, its throughput, and the number of
+// allocations per call, counting both operator new and libxml2 allocations.
+// Results go to stdout. Cases whose inputs make the library log warnings are
+// easier to read with 2>/dev/null.
+
+namespace xmpmeta {
+
+typedef void (*BenchmarkFunction)();
+
+// Registers a benchmark. Use XMPMETA_BENCHMARK instead of calling it.
+bool RegisterBenchmark(const char* name, BenchmarkFunction function);
+
+#define XMPMETA_BENCHMARK(function)                     \
+  static const bool function##_registered =             \
+      ::xmpmeta::RegisterBenchmark(#function, function)
+
+// Calls function repeatedly for at least --min_time seconds and prints the
+// results under name. bytes_per_call and items_per_call, if positive, are the
+// amount of data and the number of items, such as files or points, that one
+// call processes, and are reported per second.
+void RunBenchmarkCase(const string& name, int64 bytes_per_call,
+                      int64 items_per_call,
+                      const std::function<void()>& function);
+
+// Returns the path of a file in the testdata directory.
+string BenchmarkDataPath(const string& filename);
+
+// Keeps the compiler from optimizing away the computation of value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r"(&value) : "memory");
+#else
+  static const void* volatile sink;
+  sink = &value;
+#endif
+}
+
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_BENCHMARK_H_
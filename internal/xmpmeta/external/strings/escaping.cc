@@ -15,6 +15,7 @@
 #include "strings/escaping.h"
 
 #include <cassert>
+#include <cstring>
 
 #include "glog/logging.h"
 #include "strings/ascii_ctype.h"
@@ -153,6 +154,31 @@ bool Base64UnescapeInternal(const char* src_param, size_t szsrc, char* dest,
   // outside it instead of in every iteration.
 
   if (dest) {
+    // Decode runs of good data bytes, eight at a time, before the general
+    // loop below. Null bytes need no separate test here: like every other
+    // non-data byte they map to -1, and the input length is known, so this
+    // never reads past the end of the input.
+    while (szsrc >= 8 && destidx + 6 <= szdest) {
+      const unsigned int first = (unsigned(unbase64[src[0]]) << 18) |
+                                 (unsigned(unbase64[src[1]]) << 12) |
+                                 (unsigned(unbase64[src[2]]) << 6) |
+                                 (unsigned(unbase64[src[3]]));
+      const unsigned int second = (unsigned(unbase64[src[4]]) << 18) |
+                                  (unsigned(unbase64[src[5]]) << 12) |
+                                  (unsigned(unbase64[src[6]]) << 6) |
+                                  (unsigned(unbase64[src[7]]));
+      if ((first | second) & 0x80000000) break;
+      dest[destidx] = first >> 16;
+      dest[destidx + 1] = first >> 8;
+      dest[destidx + 2] = first;
+      dest[destidx + 3] = second >> 16;
+      dest[destidx + 4] = second >> 8;
+      dest[destidx + 5] = second;
+      destidx += 6;
+      src += 8;
+      szsrc -= 8;
+    }
+
     // This loop consumes 4 input bytes and produces 3 output bytes
     // per iteration.  We can't know at the start that there is enough
     // data left in the string for a full iteration, so the loop may
@@ -446,6 +472,41 @@ static const signed char kUnWebSafeBase64[] = {
   -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
   -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1
 };
+// Accepts both the regular and the web-safe alphabet.
+static const signed char kUnAnyBase64[] = {
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      62/*+*/, -1,      62/*-*/, -1,      63/*/ */,
+  52/*0*/, 53/*1*/, 54/*2*/, 55/*3*/, 56/*4*/, 57/*5*/, 58/*6*/, 59/*7*/,
+  60/*8*/, 61/*9*/, -1,      -1,      -1,      -1,      -1,      -1,
+  -1,       0/*A*/,  1/*B*/,  2/*C*/,  3/*D*/,  4/*E*/,  5/*F*/,  6/*G*/,
+  07/*H*/,  8/*I*/,  9/*J*/, 10/*K*/, 11/*L*/, 12/*M*/, 13/*N*/, 14/*O*/,
+  15/*P*/, 16/*Q*/, 17/*R*/, 18/*S*/, 19/*T*/, 20/*U*/, 21/*V*/, 22/*W*/,
+  23/*X*/, 24/*Y*/, 25/*Z*/, -1,      -1,      -1,      -1,      63/*_*/,
+  -1,      26/*a*/, 27/*b*/, 28/*c*/, 29/*d*/, 30/*e*/, 31/*f*/, 32/*g*/,
+  33/*h*/, 34/*i*/, 35/*j*/, 36/*k*/, 37/*l*/, 38/*m*/, 39/*n*/, 40/*o*/,
+  41/*p*/, 42/*q*/, 43/*r*/, 44/*s*/, 45/*t*/, 46/*u*/, 47/*v*/, 48/*w*/,
+  49/*x*/, 50/*y*/, 51/*z*/, -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1,
+  -1,      -1,      -1,      -1,      -1,      -1,      -1,      -1
+};
 
 static bool Base64UnescapeInternal(const char* src, size_t slen, string* dest,
                                    const signed char* unbase64) {
@@ -482,6 +543,42 @@ bool WebSafeBase64Unescape(const string& src, string* dest) {
   return Base64UnescapeInternal(src.data(), src.size(), dest, kUnWebSafeBase64);
 }
 
+bool Base64Unescape(const char* src, size_t slen, string* dest) {
+  return Base64UnescapeInternal(src, slen, dest, kUnBase64);
+}
+
+bool WebSafeBase64Unescape(const char* src, size_t slen, string* dest) {
+  return Base64UnescapeInternal(src, slen, dest, kUnWebSafeBase64);
+}
+
+bool AnyBase64Unescape(const char* src, size_t slen, string* dest) {
+  return Base64UnescapeInternal(src, slen, dest, kUnAnyBase64);
+}
+
+bool AnyBase64Unescape(const char* src, size_t slen, char* dest, size_t szdest,
+                       size_t* len) {
+  return Base64UnescapeInternal(src, slen, dest, szdest, kUnAnyBase64, len);
+}
+
+// Maps each 12-bit value to the two base64 characters that encode it, so
+// that the encoder needs two table lookups for every three bytes instead of
+// four.
+class Base64PairTable {
+ public:
+  explicit Base64PairTable(const char* base64) {
+    for (int i = 0; i < kNumPairs; ++i) {
+      pairs_[2 * i] = base64[i >> 6];
+      pairs_[2 * i + 1] = base64[i & 0x3f];
+    }
+  }
+
+  const char* Pair(unsigned int value) const { return &pairs_[2 * value]; }
+
+ private:
+  static const int kNumPairs = 1 << 12;
+  char pairs_[2 * kNumPairs];
+};
+
 // Base64Escape
 //
 // NOTE: We have to use an unsigned type for src because code built
@@ -489,7 +586,7 @@ bool WebSafeBase64Unescape(const string& src, string* dest) {
 // otherwised specified.
 int Base64EscapeInternal(const unsigned char *src, int szsrc,
                          char *dest, int szdest, const char *base64,
-                         bool do_padding) {
+                         const Base64PairTable& pairs, bool do_padding) {
   static const char kPad64 = '=';
 
   if (szsrc <= 0) return 0;
@@ -501,10 +598,10 @@ int Base64EscapeInternal(const unsigned char *src, int szsrc,
   // So we can pump through three-byte chunks atomically.
   while (szsrc > 2) { /* keep going until we have less than 24 bits */
     if ((szdest -= 4) < 0) return 0;
-    cur_dest[0] = base64[cur_src[0] >> 2];
-    cur_dest[1] = base64[((cur_src[0] & 0x03) << 4) + (cur_src[1] >> 4)];
-    cur_dest[2] = base64[((cur_src[1] & 0x0f) << 2) + (cur_src[2] >> 6)];
-    cur_dest[3] = base64[cur_src[2] & 0x3f];
+    const unsigned int value =
+        (cur_src[0] << 16) | (cur_src[1] << 8) | cur_src[2];
+    memcpy(cur_dest, pairs.Pair(value >> 12), 2);
+    memcpy(cur_dest + 2, pairs.Pair(value & 0xfff), 2);
 
     cur_dest += 4;
     cur_src += 3;
@@ -556,9 +653,17 @@ int Base64EscapeInternal(const unsigned char *src, int szsrc,
 static const char kBase64Chars[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+// Returns the pair table for kBase64Chars, which is built on first use.
+static const Base64PairTable& Base64CharPairs() {
+  static const Base64PairTable* const pairs =
+      new Base64PairTable(kBase64Chars);
+  return *pairs;
+}
+
 void Base64EscapeInternal(const unsigned char* src, size_t szsrc,
                           string* dest, bool do_padding,
-                          const char* base64_chars) {
+                          const char* base64_chars,
+                          const Base64PairTable& pairs) {
   const size_t calc_escaped_size =
       CalculateBase64EscapedLenInternal(szsrc, do_padding);
   dest->resize(calc_escaped_size);
@@ -566,7 +671,7 @@ void Base64EscapeInternal(const unsigned char* src, size_t szsrc,
       Base64EscapeInternal(src, static_cast<int>(szsrc),
                            dest->empty() ? NULL : &*dest->begin(),
                            static_cast<int>(dest->size()),
-                           base64_chars, do_padding);
+                           base64_chars, pairs, do_padding);
   DCHECK_EQ(calc_escaped_size, escaped_len);
   dest->erase(escaped_len);
 }
@@ -574,7 +679,8 @@ void Base64EscapeInternal(const unsigned char* src, size_t szsrc,
 void Base64Escape(const unsigned char* src, ptrdiff_t szsrc, string* dest,
                   bool do_padding) {
   if (szsrc < 0) return;
-  Base64EscapeInternal(src, szsrc, dest, do_padding, kBase64Chars);
+  Base64EscapeInternal(src, szsrc, dest, do_padding, kBase64Chars,
+                       Base64CharPairs());
 }
 
 // This is a templated function so that T can be either a char* or a string.
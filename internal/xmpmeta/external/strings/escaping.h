@@ -44,6 +44,7 @@ namespace strings {
 //    and the function returns false. Returns true on success.
 // ----------------------------------------------------------------------
 bool Base64Unescape(const string& src, string* dest);
+bool Base64Unescape(const char* src, size_t slen, string* dest);
 
 // ----------------------------------------------------------------------
 // WebSafeBase64Unescape()
@@ -57,6 +58,20 @@ bool Base64Unescape(const string& src, string* dest);
 //    this version src and dest must be different strings.
 // ----------------------------------------------------------------------
 bool WebSafeBase64Unescape(const string& src, string* dest);
+bool WebSafeBase64Unescape(const char* src, size_t slen, string* dest);
+
+// ----------------------------------------------------------------------
+// AnyBase64Unescape()
+//    Same as Base64Unescape, but accepts the characters of both the regular
+//    and the web-safe alphabet, so that input in either one is decoded in a
+//    single pass.
+// ----------------------------------------------------------------------
+bool AnyBase64Unescape(const char* src, size_t slen, string* dest);
+// Same as above, but decodes into dest, which has room for szdest bytes, and
+// sets len to the number of bytes decoded. Returns false if src is invalid or
+// does not fit in dest.
+bool AnyBase64Unescape(const char* src, size_t slen, char* dest, size_t szdest,
+                       size_t* len);
 
 // ----------------------------------------------------------------------
 // Base64Escape()
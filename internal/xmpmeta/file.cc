@@ -14,13 +14,90 @@
 
 #include "xmpmeta/file.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif  // __linux__
+
 #include "glog/logging.h"
 
 namespace xmpmeta {
 
 using std::string;
 
+namespace {
+
+// Size of the buffer used when copying files through user space.
+const size_t kCopyBufferSize = 1 << 16;
+
+#ifndef _WIN32
+// Copies length bytes from in_fd at offset to the current position of out_fd.
+// Returns the number of bytes copied, which is less than length on error.
+size_t CopyFileDescriptorRange(int in_fd, off_t offset, size_t length,
+                               int out_fd) {
+  size_t copied = 0;
+#ifdef __linux__
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+  // Copies within the kernel, and may share extents on filesystems that
+  // support it.
+  while (copied < length) {
+    const ssize_t result =
+        copy_file_range(in_fd, &offset, out_fd, nullptr, length - copied, 0);
+    if (result <= 0) {
+      break;
+    }
+    copied += result;
+  }
+#endif
+  // Falls back to sendfile if copy_file_range is unavailable, for example
+  // across filesystems on older kernels.
+  while (copied < length) {
+    const ssize_t result =
+        sendfile(out_fd, in_fd, &offset, length - copied);
+    if (result <= 0) {
+      break;
+    }
+    copied += result;
+  }
+#endif  // __linux__
+  std::vector<char> buffer(kCopyBufferSize);
+  while (copied < length) {
+    const ssize_t bytes_read =
+        pread(in_fd, buffer.data(), std::min(buffer.size(), length - copied),
+              offset);
+    if (bytes_read <= 0) {
+      break;
+    }
+    ssize_t bytes_written = 0;
+    while (bytes_written < bytes_read) {
+      const ssize_t result = write(out_fd, buffer.data() + bytes_written,
+                                   bytes_read - bytes_written);
+      if (result <= 0) {
+        return copied + bytes_written;
+      }
+      bytes_written += result;
+    }
+    offset += bytes_read;
+    copied += bytes_read;
+  }
+  return copied;
+}
+#endif  // _WIN32
+
+}  // namespace
+
 void WriteStringToFileOrDie(const string &data, const string &filename) {
   FILE* file_descriptor = fopen(filename.c_str(), "wb");
   if (!file_descriptor) {
@@ -56,6 +133,141 @@ void ReadFileToStringOrDie(const string &filename, string *data) {
   fclose(file_descriptor);
 }
 
+bool AppendFileRange(const string& input_filename, size_t offset,
+                     const string& output_filename) {
+#ifdef _WIN32
+  FILE* input_file = fopen(input_filename.c_str(), "rb");
+  if (!input_file) {
+    LOG(WARNING) << "Couldn't read file: " << input_filename;
+    return false;
+  }
+  FILE* output_file = fopen(output_filename.c_str(), "ab");
+  if (!output_file) {
+    LOG(WARNING) << "Couldn't write to file: " << output_filename;
+    fclose(input_file);
+    return false;
+  }
+  bool success = fseek(input_file, static_cast<long>(offset), SEEK_SET) == 0;
+  std::vector<char> buffer(kCopyBufferSize);
+  size_t bytes_read;
+  while (success &&
+         (bytes_read = fread(buffer.data(), 1, buffer.size(), input_file)) > 0) {
+    success = fwrite(buffer.data(), 1, bytes_read, output_file) == bytes_read;
+  }
+  fclose(input_file);
+  success = fclose(output_file) == 0 && success;
+  return success;
+#else
+  const int in_fd = open(input_filename.c_str(), O_RDONLY);
+  if (in_fd < 0) {
+    LOG(WARNING) << "Couldn't read file: " << input_filename;
+    return false;
+  }
+  struct stat input_stat;
+  if (fstat(in_fd, &input_stat) != 0 ||
+      static_cast<off_t>(offset) > input_stat.st_size) {
+    LOG(WARNING) << "Invalid offset " << offset << " in " << input_filename;
+    close(in_fd);
+    return false;
+  }
+  // copy_file_range does not accept descriptors opened with O_APPEND, so
+  // seek to the end instead.
+  const int out_fd = open(output_filename.c_str(), O_WRONLY);
+  if (out_fd < 0 || lseek(out_fd, 0, SEEK_END) < 0) {
+    LOG(WARNING) << "Couldn't write to file: " << output_filename;
+    close(in_fd);
+    if (out_fd >= 0) {
+      close(out_fd);
+    }
+    return false;
+  }
+  const size_t length = input_stat.st_size - offset;
+  const size_t copied = CopyFileDescriptorRange(in_fd, offset, length, out_fd);
+  close(in_fd);
+  const bool closed = close(out_fd) == 0;
+  if (copied != length || !closed) {
+    LOG(WARNING) << "Copied " << copied << " of " << length << " bytes from "
+                 << input_filename << " to " << output_filename;
+    return false;
+  }
+  return true;
+#endif  // _WIN32
+}
+
+bool WriteFileRange(const string& filename, size_t offset,
+                    const string& data) {
+#ifdef _WIN32
+  FILE* file = fopen(filename.c_str(), "r+b");
+  if (!file) {
+    LOG(WARNING) << "Couldn't write to file: " << filename;
+    return false;
+  }
+  bool success = fseek(file, static_cast<long>(offset), SEEK_SET) == 0 &&
+      fwrite(data.data(), 1, data.size(), file) == data.size();
+  success = fclose(file) == 0 && success;
+  return success;
+#else
+  const int fd = open(filename.c_str(), O_WRONLY);
+  if (fd < 0) {
+    LOG(WARNING) << "Couldn't write to file: " << filename;
+    return false;
+  }
+  size_t written = 0;
+  while (written < data.size()) {
+    const ssize_t result = pwrite(fd, data.data() + written,
+                                  data.size() - written, offset + written);
+    if (result <= 0) {
+      break;
+    }
+    written += result;
+  }
+  const bool closed = close(fd) == 0;
+  if (written != data.size() || !closed) {
+    LOG(WARNING) << "Wrote " << written << " of " << data.size()
+                 << " bytes to " << filename;
+    return false;
+  }
+  return true;
+#endif  // _WIN32
+}
+
+bool CreateTempFileNextTo(const string& filename, string* temp_filename) {
+  string name = filename + ".XXXXXX";
+#ifdef _WIN32
+  if (_mktemp_s(&name[0], name.size() + 1) != 0) {
+    LOG(WARNING) << "Couldn't create a temporary file for " << filename;
+    return false;
+  }
+  FILE* file = fopen(name.c_str(), "wbx");
+  if (!file) {
+    LOG(WARNING) << "Couldn't create file: " << name;
+    return false;
+  }
+  fclose(file);
+#else
+  const int fd = mkstemp(&name[0]);
+  if (fd < 0) {
+    LOG(WARNING) << "Couldn't create a temporary file for " << filename;
+    return false;
+  }
+  // mkstemp creates the file readable only by its owner.
+  struct stat file_stat;
+  if (stat(filename.c_str(), &file_stat) == 0 &&
+      fchmod(fd, file_stat.st_mode & 07777) != 0) {
+    LOG(WARNING) << "Couldn't set the permissions of " << name;
+    close(fd);
+    unlink(name.c_str());
+    return false;
+  }
+  if (close(fd) != 0) {
+    unlink(name.c_str());
+    return false;
+  }
+#endif  // _WIN32
+  *temp_filename = name;
+  return true;
+}
+
 string JoinPath(const string& dirname, const string& basename) {
 #ifdef _WIN32
     static const char separator = '\\';
@@ -23,6 +23,26 @@ void WriteStringToFileOrDie(const std::string &data,
                             const std::string &filename);
 void ReadFileToStringOrDie(const std::string &filename, std::string *data);
 
+// Appends the bytes of input_filename, from offset to the end of the file,
+// to output_filename. On Linux the data is copied with copy_file_range or
+// sendfile, so it does not pass through user space. Returns false if either
+// file could not be opened or the copy failed.
+bool AppendFileRange(const std::string& input_filename, size_t offset,
+                     const std::string& output_filename);
+
+// Overwrites the bytes of filename starting at offset with data, without
+// changing the rest of the file. Returns false if the file could not be
+// opened or the write was incomplete.
+bool WriteFileRange(const std::string& filename, size_t offset,
+                    const std::string& data);
+
+// Creates a new, empty file with a unique name in the same directory as
+// filename, and with the same permissions if filename exists, so that it can
+// later be renamed over filename. Sets temp_filename to its name. Returns
+// false if the file could not be created.
+bool CreateTempFileNextTo(const std::string& filename,
+                          std::string* temp_filename);
+
 // Join two path components, adding a slash if necessary.  If basename is an
 // absolute path then JoinPath ignores dirname and simply returns basename.
 std::string JoinPath(const std::string& dirname, const std::string& basename);
@@ -15,6 +15,7 @@
 #include "xmpmeta/gaudio.h"
 
 #include <memory>
+#include <sstream>
 #include <string>
 
 #include <libxml/tree.h>
@@ -68,6 +69,19 @@ TEST(GAudio, ParseVrPhotoXmp) {
   EXPECT_EQ(expected_audio_data, gaudio->GetData());
 }
 
+TEST(GAudio, ReadDataFromJpegFile) {
+  const string left_path = TestFileAbsolutePath(kLeftFile);
+  const string audio_path = TestFileAbsolutePath(kAudioFile);
+
+  std::ostringstream data;
+  ASSERT_TRUE(GAudio::ReadDataFromJpegFile(left_path, &data));
+  std::string expected_data;
+  ReadFileToStringOrDie(audio_path, &expected_data);
+  EXPECT_EQ(expected_data, data.str());
+
+  EXPECT_FALSE(GAudio::ReadDataFromJpegFile(kBadPath, &data));
+}
+
 TEST(GAudio, BadPath) {
   std::unique_ptr<GAudio> gaudio = GAudio::FromJpegFile(kBadPath);
   ASSERT_EQ(nullptr, gaudio);
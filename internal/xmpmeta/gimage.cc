@@ -21,6 +21,7 @@
 #include "xmpmeta/xmp_parser.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/property_extractor.h"
 #include "xmpmeta/xml/utils.h"
 
 using xmpmeta::xml::DeserializerImpl;
@@ -89,6 +90,21 @@ std::unique_ptr<GImage> GImage::FromJpegFile(const string& filename) {
   return FromXmp(xmp);
 }
 
+bool GImage::ReadDataFromJpegFile(const string& filename,
+                                  const DataSink& sink) {
+  return ReadExtendedXmpBase64Property(filename, kPrefix, kData, sink);
+}
+
+bool GImage::ReadDataFromJpegFile(const string& filename,
+                                  std::ostream* output) {
+  CHECK_NOTNULL(output);
+  return ReadDataFromJpegFile(
+      filename, [output](const char* data, size_t size) {
+        output->write(data, size);
+        return output->good();
+      });
+}
+
 bool GImage::IsPresent(const XmpData& xmp) {
   DeserializerImpl std_deserializer(
       GetFirstDescriptionElement(xmp.StandardSection()));
@@ -97,12 +113,11 @@ bool GImage::IsPresent(const XmpData& xmp) {
 }
 
 bool GImage::IsPresent(const string& filename) {
-  XmpData xmp;
-  const bool kSkipExtended = true;
-  if (!ReadXmpHeader(filename, kSkipExtended, &xmp)) {
-    return false;
-  }
-  return IsPresent(xmp);
+  xml::PropertyExtractor extractor(
+      std::vector<std::pair<string, string>>{{kPrefix, kMime}});
+  string mime;
+  return ExtractXmpProperties(filename, &extractor) &&
+         extractor.ParseString(kPrefix, kMime, &mime);
 }
 
 bool GImage::Serialize(xml::Serializer* std_serializer,
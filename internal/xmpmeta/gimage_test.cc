@@ -15,6 +15,7 @@
 #include "xmpmeta/gimage.h"
 
 #include <memory>
+#include <sstream>
 #include <string>
 
 #include <libxml/tree.h>
@@ -66,6 +67,19 @@ TEST(GImage, ParseVrPhotoXmp) {
   EXPECT_EQ(expected_image_data, gimage->GetData());
 }
 
+TEST(GImage, ReadDataFromJpegFile) {
+  const string left_path = TestFileAbsolutePath(kLeftFile);
+  const string right_path = TestFileAbsolutePath(kRightFile);
+
+  std::ostringstream data;
+  ASSERT_TRUE(GImage::ReadDataFromJpegFile(left_path, &data));
+  std::string expected_data;
+  ReadFileToStringOrDie(right_path, &expected_data);
+  EXPECT_EQ(expected_data, data.str());
+
+  EXPECT_FALSE(GImage::ReadDataFromJpegFile(kBadPath, &data));
+}
+
 TEST(GImage, BadPath) {
   std::unique_ptr<GImage> gimage = GImage::FromJpegFile(kBadPath);
   ASSERT_EQ(nullptr, gimage);
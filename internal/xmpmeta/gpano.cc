@@ -18,10 +18,12 @@
 #include "xmpmeta/xmp_parser.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/property_extractor.h"
 #include "xmpmeta/xml/serializer.h"
 #include "xmpmeta/xml/utils.h"
 
 using xmpmeta::PanoMetaData;
+using xmpmeta::xml::Deserializer;
 using xmpmeta::xml::DeserializerImpl;
 using xmpmeta::xml::GetFirstDescriptionElement;
 using xmpmeta::xml::ToXmlChar;
@@ -45,10 +47,9 @@ const char kPoseHeadingDegrees[] = "PoseHeadingDegrees";
 const char kProjectionType[] = "ProjectionType";
 const char kUsePanoramaViewer[] = "UsePanoramaViewer";
 
-// Extracts metadata from xmp.
-bool ParseGPanoFields(const XmpData& xmp, PanoMetaData* meta_data) {
-  DeserializerImpl std_deserializer(
-      GetFirstDescriptionElement(xmp.StandardSection()));
+// Extracts metadata from the standard section's deserializer.
+bool ParseGPanoFields(const Deserializer& std_deserializer,
+                      PanoMetaData* meta_data) {
   if (!std_deserializer.ParseInt(kPrefix, kCroppedAreaLeftPixels,
                                  &meta_data->cropped_left)) {
     return false;
@@ -124,17 +125,34 @@ std::unique_ptr<GPano> GPano::CreateFromData(const PanoMetaData& metadata) {
 
 std::unique_ptr<GPano> GPano::FromXmp(const XmpData& xmp) {
   std::unique_ptr<GPano> gpano(new GPano());
-  const bool success = ParseGPanoFields(xmp, &gpano->meta_data_);
+  DeserializerImpl std_deserializer(
+      GetFirstDescriptionElement(xmp.StandardSection()));
+  const bool success = ParseGPanoFields(std_deserializer, &gpano->meta_data_);
   return success ? std::move(gpano) : nullptr;
 }
 
 std::unique_ptr<GPano> GPano::FromJpegFile(const string& filename) {
-  XmpData xmp;
-  const bool kSkipExtended = true;
-  if (!ReadXmpHeader(filename, kSkipExtended, &xmp)) {
+  // Only the GPano properties are needed, so stream over the standard section
+  // instead of building its DOM.
+  xml::PropertyExtractor extractor({
+      {kPrefix, kCroppedAreaLeftPixels},
+      {kPrefix, kCroppedAreaTopPixels},
+      {kPrefix, kCroppedAreaImageWidthPixels},
+      {kPrefix, kCroppedAreaImageHeightPixels},
+      {kPrefix, kFullPanoWidthPixels},
+      {kPrefix, kFullPanoWidthPixelsDeprecated},
+      {kPrefix, kFullPanoHeightPixels},
+      {kPrefix, kFullPanoHeightPixelsDeprecated},
+      {kPrefix, kInitialViewHeadingDegrees},
+      {kPrefix, kPoseHeadingDegrees},
+      {kPrefix, kProjectionType},
+      {kPrefix, kUsePanoramaViewer}});
+  if (!ExtractXmpProperties(filename, &extractor)) {
     return nullptr;
   }
-  return FromXmp(xmp);
+  std::unique_ptr<GPano> gpano(new GPano());
+  const bool success = ParseGPanoFields(extractor, &gpano->meta_data_);
+  return success ? std::move(gpano) : nullptr;
 }
 
 bool GPano::Serialize(xml::Serializer* serializer) const {
@@ -14,9 +14,18 @@
 
 #include "xmpmeta/jpeg_io.h"
 
+#include <algorithm>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "glog/logging.h"
 
 namespace xmpmeta {
@@ -32,46 +41,191 @@ const int kSos = 0xda;   // Start of scan.
 // Number of bytes used to store a section's length in a JPEG file.
 const int kSectionLengthByteSize = 2;
 
-// Returns the number of bytes available to be read. Sets the seek position
-// to the place it was in before calling this function.
-size_t GetBytesAvailable(std::istream* input_stream) {
-  const std::streamoff pos = input_stream->tellg();
-  if (pos == -1) {
-    return 0;
+// Size of the buffer used to read input streams. The image data is also
+// copied in chunks of this size.
+const size_t kReadBufferSize = 1 << 16;
+
+// Outcome of reading the start of a section.
+enum class SectionStart {
+  // A section with a length follows.
+  kSection,
+  // The start of scan marker was read; the image data follows.
+  kScanData,
+  // There are no more sections, or the input is malformed.
+  kEnd,
+};
+
+}  // namespace
+
+// Reads an input stream through a large internal buffer, so that scanning
+// markers does not cost a stream call per byte. The size of a seekable stream
+// is computed once; non-seekable streams such as pipes are read until they
+// run out of data.
+class BufferedReader {
+ public:
+  explicit BufferedReader(std::istream* input_stream)
+      : input_stream_(input_stream),
+        stream_buffer_(input_stream->good() ? input_stream->rdbuf() : nullptr),
+        buffer_(kReadBufferSize), begin_(0), end_(0), start_position_(-1),
+        stream_size_(-1), bytes_filled_(0) {
+    if (stream_buffer_ == nullptr) {
+      return;
+    }
+    const std::streamoff position =
+        stream_buffer_->pubseekoff(0, std::ios::cur, std::ios::in);
+    if (position == -1) {
+      return;
+    }
+    const std::streamoff end =
+        stream_buffer_->pubseekoff(0, std::ios::end, std::ios::in);
+    if (end == -1 ||
+        stream_buffer_->pubseekpos(position, std::ios::in) != position) {
+      return;
+    }
+    start_position_ = position;
+    stream_size_ = end > position ? end - position : 0;
   }
 
-  input_stream->seekg(0, std::ios::end);
-  if (!input_stream->good()) {
-    return 0;
+  // Leaves a seekable stream positioned at the first unconsumed byte.
+  ~BufferedReader() {
+    if (start_position_ != -1) {
+      stream_buffer_->pubseekpos(start_position_ + BytesConsumed(),
+                                 std::ios::in);
+    }
   }
 
-  const std::streamoff end = input_stream->tellg();
-  if (end == -1) {
-    return 0;
+  // Returns the next byte as an integer, or -1 if no byte can be read.
+  int ReadByte() {
+    if (begin_ == end_ && !Fill()) {
+      SetEndOfStream();
+      return -1;
+    }
+    return static_cast<unsigned char>(buffer_[begin_++]);
   }
-  input_stream->seekg(pos);
 
-  if (end <= pos) {
-    return 0;
+  // Reads exactly length bytes into data. Returns false if the input ends
+  // first.
+  bool Read(size_t length, char* data) {
+    const size_t buffered = std::min(length, end_ - begin_);
+    std::copy_n(&buffer_[begin_], buffered, data);
+    begin_ += buffered;
+    length -= buffered;
+    data += buffered;
+    if (length == 0) {
+      return true;
+    }
+    if (length >= buffer_.size()) {
+      // Large reads bypass the buffer.
+      const std::streamsize read = ReadFromStream(data, length);
+      if (read != static_cast<std::streamsize>(length)) {
+        SetEndOfStream();
+        return false;
+      }
+      return true;
+    }
+    if (!Fill() || end_ < length) {
+      begin_ = end_;
+      SetEndOfStream();
+      return false;
+    }
+    std::copy_n(&buffer_[0], length, data);
+    begin_ = length;
+    return true;
   }
-  return end - pos;
-}
 
-// Returns the first byte in the stream cast to an integer.
-int ReadByteAsInt(std::istream* input_stream) {
-  unsigned char byte;
-  input_stream->read(reinterpret_cast<char*>(&byte), 1);
-  if (!input_stream->good()) {
-    // Return an invalid value - no byte can be read as -1.
-    return -1;
+  // Skips length bytes. Returns false if the input ends first.
+  bool Skip(size_t length) {
+    while (length > end_ - begin_) {
+      length -= end_ - begin_;
+      begin_ = end_;
+      if (!Fill()) {
+        SetEndOfStream();
+        return false;
+      }
+    }
+    begin_ += length;
+    return true;
   }
-  return static_cast<int>(byte);
-}
+
+  // Appends all the remaining bytes to data.
+  void ReadToEnd(string* data) {
+    do {
+      data->append(&buffer_[begin_], end_ - begin_);
+      begin_ = end_;
+    } while (Fill());
+  }
+
+  // Writes all the remaining bytes to output_stream, one buffer at a time.
+  bool CopyToEnd(std::ostream* output_stream) {
+    do {
+      output_stream->write(&buffer_[begin_], end_ - begin_);
+      begin_ = end_;
+    } while (output_stream->good() && Fill());
+    return output_stream->good();
+  }
+
+  // Returns the number of bytes consumed since the reader was created.
+  size_t Position() const { return static_cast<size_t>(BytesConsumed()); }
+
+  // Returns true if the number of bytes left in the input is known.
+  bool HasKnownSize() const { return stream_size_ != -1; }
+
+  // Returns the number of bytes left in the input. Only valid if
+  // HasKnownSize() is true.
+  size_t BytesAvailable() const {
+    return static_cast<size_t>(stream_size_ - BytesConsumed());
+  }
+
+ private:
+  // Sets eofbit and failbit on the stream after a read past its end, as
+  // std::istream::read does. Reads that stop exactly at the end, such as
+  // ReadToEnd, leave the state as it was.
+  void SetEndOfStream() {
+    input_stream_->setstate(std::ios::eofbit | std::ios::failbit);
+  }
+
+  // Replaces the buffer contents with the next bytes of the stream. Returns
+  // false if there are none.
+  bool Fill() {
+    begin_ = 0;
+    end_ = static_cast<size_t>(ReadFromStream(&buffer_[0], buffer_.size()));
+    return end_ > 0;
+  }
+
+  std::streamsize ReadFromStream(char* data, size_t length) {
+    if (stream_buffer_ == nullptr) {
+      return 0;
+    }
+    const std::streamsize read = stream_buffer_->sgetn(data, length);
+    bytes_filled_ += read;
+    return read;
+  }
+
+  std::streamoff BytesConsumed() const {
+    return bytes_filled_ - static_cast<std::streamoff>(end_ - begin_);
+  }
+
+  std::istream* input_stream_;
+  std::streambuf* stream_buffer_;
+  std::vector<char> buffer_;
+  // The unread bytes are buffer_[begin_, end_).
+  size_t begin_;
+  size_t end_;
+  // Position of the stream when the reader was created, or -1 if the stream
+  // is not seekable.
+  std::streamoff start_position_;
+  // Number of bytes in the stream after start_position_, or -1 if unknown.
+  std::streamoff stream_size_;
+  // Number of bytes read from the stream so far.
+  std::streamoff bytes_filled_;
+};
+
+namespace {
 
 // Reads the length of a section from 2 bytes.
-size_t Read2ByteLength(std::istream* input_stream, bool *error) {
-  const int length_high = ReadByteAsInt(input_stream);
-  const int length_low = ReadByteAsInt(input_stream);
+size_t Read2ByteLength(BufferedReader* reader, bool *error) {
+  const int length_high = reader->ReadByte();
+  const int length_low = reader->ReadByte();
   if (length_high == -1 || length_low == -1) {
     *error = true;
     return 0;
@@ -80,6 +234,70 @@ size_t Read2ByteLength(std::istream* input_stream, bool *error) {
   return length_high << 8 | length_low;
 }
 
+// Reads the marker and length at the start of the next section. On kSection,
+// data_size is set to the number of data bytes that follow.
+SectionStart ReadSectionStart(BufferedReader* reader, int* marker,
+                              size_t* data_size) {
+  int chr = reader->ReadByte();  // Short for character.
+  if (chr == -1) {
+    return SectionStart::kEnd;
+  }
+  if (chr != 0xff) {
+    LOG(WARNING) << "Read non-padding byte: " << chr;
+    return SectionStart::kEnd;
+  }
+  // Skip padding bytes.
+  while ((chr = reader->ReadByte()) == 0xff) {
+  }
+  if (chr == -1) {
+    LOG(WARNING) << "No more bytes in file available to be read.";
+    return SectionStart::kEnd;
+  }
+
+  *marker = chr;
+  if (*marker == kSos) {
+    return SectionStart::kScanData;
+  }
+
+  bool error;
+  const size_t length = Read2ByteLength(reader, &error);
+  if (error || length < kSectionLengthByteSize) {
+    // No sections to read.
+    LOG(WARNING) << "No sections to read; section length is " << length;
+    return SectionStart::kEnd;
+  }
+
+  // The length of sections in non-seekable streams is checked as they are
+  // read.
+  if (reader->HasKnownSize() &&
+      length - kSectionLengthByteSize > reader->BytesAvailable()) {
+    LOG(WARNING) << "Invalid section length = " << length
+                 << " total bytes available = " << reader->BytesAvailable();
+    return SectionStart::kEnd;
+  }
+  *data_size = length - kSectionLengthByteSize;
+  return SectionStart::kSection;
+}
+
+// Reads data_size bytes of section data into section.
+bool ReadSectionData(int marker, size_t data_size, BufferedReader* reader,
+                     Section* section) {
+  section->marker = marker;
+  section->is_image_section = false;
+  section->data.resize(data_size);
+  if (section->data.size() != data_size) {
+    LOG(WARNING) << "Discrepancy in section data size "
+                 << section->data.size() << "and data size " << data_size;
+    return false;
+  }
+  if (data_size > 0 && !reader->Read(data_size, &section->data[0])) {
+    LOG(WARNING) << "Section data ended early; expected " << data_size
+                 << " bytes";
+    return false;
+  }
+  return true;
+}
+
 bool HasPrefixString(const string& to_check, const string& prefix) {
   if (to_check.size() < prefix.size()) {
     return false;
@@ -87,6 +305,64 @@ bool HasPrefixString(const string& to_check, const string& prefix) {
   return std::equal(prefix.begin(), prefix.end(), to_check.begin());
 }
 
+// Indexes the sections in a JPEG buffer. Follows the same rules as Parse, so
+// a malformed section ends the index with the sections found so far.
+std::vector<SectionView> IndexSections(const char* data, size_t size) {
+  std::vector<SectionView> sections;
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  if (size < 2 || bytes[0] != 0xff || bytes[1] != kSoi) {
+    LOG(WARNING) << "File's first two bytes does not match the sequence \xff"
+                 << kSoi;
+    return sections;
+  }
+
+  size_t position = 2;
+  while (position < size) {
+    if (bytes[position] != 0xff) {
+      LOG(WARNING) << "Read non-padding byte: "
+                   << static_cast<int>(bytes[position]);
+      return sections;
+    }
+    // Skip padding bytes.
+    while (++position < size && bytes[position] == 0xff) {
+    }
+    if (position == size) {
+      LOG(WARNING) << "No more bytes in file available to be read.";
+      return sections;
+    }
+
+    const int marker = bytes[position++];
+    if (marker == kSos) {
+      // The image data runs to the end of the buffer.
+      sections.emplace_back(marker, true, position, data + position,
+                            size - position);
+      return sections;
+    }
+
+    if (size - position < kSectionLengthByteSize) {
+      LOG(WARNING) << "No sections to read; section length is missing";
+      return sections;
+    }
+    const size_t length = bytes[position] << 8 | bytes[position + 1];
+    position += kSectionLengthByteSize;
+    if (length < kSectionLengthByteSize) {
+      LOG(WARNING) << "No sections to read; section length is " << length;
+      return sections;
+    }
+
+    const size_t data_size = length - kSectionLengthByteSize;
+    if (data_size > size - position) {
+      LOG(WARNING) << "Invalid section length = " << length
+                   << " total bytes available = " << size - position;
+      return sections;
+    }
+    sections.emplace_back(marker, false, position, data + position,
+                          data_size);
+    position += data_size;
+  }
+  return sections;
+}
+
 }  // namespace
 
 Section::Section(const string& buffer) {
@@ -99,79 +375,145 @@ bool Section::IsMarkerApp1() {
   return marker == kApp1;
 }
 
+SectionView::SectionView(int marker, bool is_image_section, size_t offset,
+                         const char* data, size_t length)
+    : marker(marker), is_image_section(is_image_section), offset(offset),
+      data(data), length(length) {}
+
+SectionView::SectionView(const Section& section)
+    : marker(section.marker), is_image_section(section.is_image_section),
+      data(section.data.data()), length(section.data.size()) {}
+
+bool SectionView::IsMarkerApp1() const {
+  return marker == kApp1;
+}
+
+bool SectionView::HasPrefix(const string& prefix) const {
+  return length >= prefix.size() &&
+      std::equal(prefix.begin(), prefix.end(), data);
+}
+
+SectionIndex::SectionIndex(const char* data, size_t size, void* mapping)
+    : data_(data), size_(size), mapping_(mapping) {}
+
+SectionIndex::~SectionIndex() {
+#ifndef _WIN32
+  if (mapping_ != nullptr) {
+    munmap(mapping_, size_);
+  }
+#endif
+}
+
+std::unique_ptr<SectionIndex> SectionIndex::FromFile(const string& filename) {
+#ifdef _WIN32
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  if (!file.is_open()) {
+    LOG(WARNING) << "Could not read file: " << filename;
+    return nullptr;
+  }
+  std::unique_ptr<SectionIndex> index(new SectionIndex(nullptr, 0, nullptr));
+  index->owned_data_.assign(std::istreambuf_iterator<char>(file),
+                            std::istreambuf_iterator<char>());
+  index->data_ = index->owned_data_.data();
+  index->size_ = index->owned_data_.size();
+#else
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(WARNING) << "Could not read file: " << filename;
+    return nullptr;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+    LOG(WARNING) << "Not a regular file: " << filename;
+    close(fd);
+    return nullptr;
+  }
+  const size_t size = static_cast<size_t>(file_stat.st_size);
+  void* mapping = nullptr;
+  // Empty files cannot be mapped; they are indexed as an empty buffer.
+  if (size > 0) {
+    mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      LOG(WARNING) << "Could not map file: " << filename;
+      close(fd);
+      return nullptr;
+    }
+  }
+  // The mapping stays valid after the descriptor is closed.
+  close(fd);
+  std::unique_ptr<SectionIndex> index(
+      new SectionIndex(static_cast<const char*>(mapping), size, mapping));
+#endif
+  index->sections_ = IndexSections(index->data_, index->size_);
+  return index;
+}
+
+std::unique_ptr<SectionIndex> SectionIndex::FromBuffer(const char* data,
+                                                       size_t size) {
+  std::unique_ptr<SectionIndex> index(new SectionIndex(data, size, nullptr));
+  index->sections_ = IndexSections(data, size);
+  return index;
+}
+
+std::vector<SectionView> SectionIndex::FindApp1Sections(
+    const string& prefix) const {
+  std::vector<SectionView> found;
+  for (const SectionView& section : sections_) {
+    if (section.IsMarkerApp1() && section.HasPrefix(prefix)) {
+      found.push_back(section);
+    }
+  }
+  return found;
+}
+
 std::vector<Section> Parse(const ParseOptions& options,
                            std::istream* input_stream) {
   std::vector<Section> sections;
+  BufferedReader reader(input_stream);
   // Return early if this is not the start of a JPEG section.
-  if (ReadByteAsInt(input_stream) != 0xff ||
-      ReadByteAsInt(input_stream) != kSoi) {
+  if (reader.ReadByte() != 0xff || reader.ReadByte() != kSoi) {
     LOG(WARNING) << "File's first two bytes does not match the sequence \xff"
                  << kSoi;
     return std::vector<Section>();
   }
 
-  int chr;  // Short for character.
-  while ((chr = ReadByteAsInt(input_stream)) != -1) {
-    if (chr != 0xff) {
-      LOG(WARNING) << "Read non-padding byte: " << chr;
-      return sections;
-    }
-    // Skip padding bytes.
-    while ((chr = ReadByteAsInt(input_stream)) == 0xff) {
-    }
-    if (chr == -1) {
-      LOG(WARNING) << "No more bytes in file available to be read.";
-      return sections;
-    }
-
-    const int marker = chr;
-    if (marker == kSos) {
-      // kSos indicates the image data will follow and no metadata after that,
-      // so read all data at one time.
-      if (!options.read_meta_only) {
-        Section section;
-        section.marker = marker;
-        section.is_image_section = true;
-        const size_t bytes_available = GetBytesAvailable(input_stream);
-        section.data.resize(bytes_available);
-        input_stream->read(&section.data[0], bytes_available);
-        if (input_stream->good()) {
+  int marker;
+  size_t data_size;
+  while (true) {
+    switch (ReadSectionStart(&reader, &marker, &data_size)) {
+      case SectionStart::kEnd:
+        return sections;
+      case SectionStart::kScanData:
+        // kSos indicates the image data will follow and no metadata after
+        // that, so read all data at one time.
+        if (!options.read_meta_only) {
+          Section section;
+          section.marker = marker;
+          section.is_image_section = true;
+          if (reader.HasKnownSize()) {
+            section.data.resize(reader.BytesAvailable());
+            if (!section.data.empty() &&
+                !reader.Read(section.data.size(), &section.data[0])) {
+              return sections;
+            }
+          } else {
+            reader.ReadToEnd(&section.data);
+          }
           sections.push_back(section);
         }
-      }
-      // All sections have been read.
-      return sections;
-    }
-
-    bool error;
-    const size_t length = Read2ByteLength(input_stream, &error);
-    if (error || length < kSectionLengthByteSize) {
-      // No sections to read.
-      LOG(WARNING) << "No sections to read; section length is " << length;
-      return sections;
-    }
-
-    const size_t bytes_left = GetBytesAvailable(input_stream);
-    if (length - kSectionLengthByteSize > bytes_left) {
-      LOG(WARNING) << "Invalid section length = " << length
-                   << " total bytes available = " << bytes_left;
-      return sections;
+        // All sections have been read.
+        return sections;
+      case SectionStart::kSection:
+        break;
     }
 
     if (!options.read_meta_only || marker == kApp1) {
       Section section;
-      section.marker = marker;
-      section.is_image_section = false;
-      const size_t data_size = length - kSectionLengthByteSize;
-      section.data.resize(data_size);
-      if (section.data.size() != data_size) {
-        LOG(WARNING) << "Discrepancy in section data size "
-                     << section.data.size() << "and data size " << data_size;
+      if (!ReadSectionData(marker, data_size, &reader, &section)) {
         return sections;
       }
-      input_stream->read(&section.data[0], section.data.size());
-      if (input_stream->good() && (options.section_header.empty() ||
-            HasPrefixString(section.data, options.section_header))) {
+      if (options.section_header.empty() ||
+          HasPrefixString(section.data, options.section_header)) {
         sections.push_back(section);
         // Return if we have specified to return the 1st section with
         // the given name.
@@ -181,29 +523,116 @@ std::vector<Section> Parse(const ParseOptions& options,
       }
     } else {
       // Skip this section since all EXIF/XMP meta will be in kApp1 section.
-      input_stream->ignore(length - kSectionLengthByteSize);
+      reader.Skip(data_size);
     }
   }
-  return sections;
+}
+
+SectionReader::SectionReader(std::istream* input_stream)
+    : reader_(new BufferedReader(input_stream)), at_scan_data_(false),
+      done_(false) {
+  if (reader_->ReadByte() != 0xff || reader_->ReadByte() != kSoi) {
+    LOG(WARNING) << "File's first two bytes does not match the sequence \xff"
+                 << kSoi;
+    done_ = true;
+  }
+}
+
+SectionReader::~SectionReader() {}
+
+bool SectionReader::Next(Section* section) {
+  if (done_) {
+    return false;
+  }
+  int marker;
+  size_t data_size;
+  switch (ReadSectionStart(reader_.get(), &marker, &data_size)) {
+    case SectionStart::kEnd:
+      done_ = true;
+      return false;
+    case SectionStart::kScanData:
+      at_scan_data_ = true;
+      done_ = true;
+      return false;
+    case SectionStart::kSection:
+      break;
+  }
+  if (!ReadSectionData(marker, data_size, reader_.get(), section)) {
+    done_ = true;
+    return false;
+  }
+  return true;
+}
+
+size_t SectionReader::Position() const {
+  return reader_->Position();
+}
+
+bool SectionReader::CopyScanData(std::ostream* output_stream) {
+  if (!at_scan_data_) {
+    return false;
+  }
+  WriteStartOfScan(output_stream);
+  return reader_->CopyToEnd(output_stream);
+}
+
+std::vector<SectionView> ToSectionViews(const std::vector<Section>& sections) {
+  std::vector<SectionView> views;
+  views.reserve(sections.size());
+  for (const Section& section : sections) {
+    views.emplace_back(section);
+  }
+  return views;
 }
 
 void WriteSections(const std::vector<Section>& sections,
                    std::ostream* output_stream) {
+  WriteSections(ToSectionViews(sections), output_stream);
+}
+
+void WriteSections(const std::vector<SectionView>& sections,
+                   std::ostream* output_stream) {
+  WriteStartOfImage(output_stream);
+  for (const SectionView& section : sections) {
+    WriteSection(section, output_stream);
+  }
+}
+
+void WriteStartOfImage(std::ostream* output_stream) {
   output_stream->put(0xff);
   output_stream->put(kSoi);
-  for (const Section& section : sections) {
-    output_stream->put(0xff);
-    output_stream->put(section.marker);
-    if (!section.is_image_section) {
-      const int section_length = static_cast<int>(section.data.length()) + 2;
-      // It's not the image data.
-      const int lh = section_length >> 8;
-      const int ll = section_length & 0xff;
-      output_stream->put(lh);
-      output_stream->put(ll);
-    }
-    output_stream->write(section.data.c_str(), section.data.length());
+}
+
+void WriteStartOfScan(std::ostream* output_stream) {
+  output_stream->put(0xff);
+  output_stream->put(kSos);
+}
+
+void WriteSection(const SectionView& section, std::ostream* output_stream) {
+  output_stream->put(0xff);
+  output_stream->put(section.marker);
+  if (!section.is_image_section) {
+    const int section_length = static_cast<int>(section.length) + 2;
+    // It's not the image data.
+    const int lh = section_length >> 8;
+    const int ll = section_length & 0xff;
+    output_stream->put(lh);
+    output_stream->put(ll);
   }
+  output_stream->write(section.data, section.length);
+}
+
+void WriteApp1Section(const char* header, size_t header_length,
+                      const char* data, size_t data_length,
+                      std::ostream* output_stream) {
+  const int section_length =
+      static_cast<int>(header_length + data_length) + 2;
+  output_stream->put(0xff);
+  output_stream->put(kApp1);
+  output_stream->put(section_length >> 8);
+  output_stream->put(section_length & 0xff);
+  output_stream->write(header, header_length);
+  output_stream->write(data, data_length);
 }
 
 }  // namespace xmpmeta
@@ -0,0 +1,67 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/jpeg_io.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "xmpmeta/benchmark.h"
+
+namespace xmpmeta {
+namespace {
+
+// Returns a JPEG with the given number of 64-byte APPn sections, cycling
+// through APP1 to APP15, followed by 64 KB of image data.
+string CreateJpegWithSections(int section_count) {
+  string jpeg = "\xff\xd8";
+  const string payload(62, 'x');
+  for (int i = 0; i < section_count; ++i) {
+    jpeg += '\xff';
+    jpeg += static_cast<char>(0xe1 + i % 15);
+    jpeg += '\0';
+    jpeg += static_cast<char>(payload.size() + 2);
+    jpeg += payload;
+  }
+  jpeg += "\xff\xda";
+  jpeg += string(64 * 1024, '\0');
+  return jpeg;
+}
+
+// Measures sections per second for Parse, which reads through a buffered
+// reader, and for SectionIndex, which indexes the bytes in place.
+void BM_ParseSections() {
+  for (int section_count : {16, 256, 4096}) {
+    const string jpeg = CreateJpegWithSections(section_count);
+    std::istringstream stream(jpeg);
+    ParseOptions options;
+    options.read_meta_only = true;
+    RunBenchmarkCase(
+        "Parse/" + std::to_string(section_count), 0, section_count, [&]() {
+          stream.clear();
+          stream.seekg(0);
+          DoNotOptimize(Parse(options, &stream));
+        });
+    RunBenchmarkCase(
+        "SectionIndex/" + std::to_string(section_count), 0, section_count,
+        [&]() {
+          DoNotOptimize(SectionIndex::FromBuffer(jpeg.data(), jpeg.size()));
+        });
+  }
+}
+XMPMETA_BENCHMARK(BM_ParseSections);
+
+}  // namespace
+}  // namespace xmpmeta
@@ -15,6 +15,7 @@
 #include "xmpmeta/jpeg_io.h"
 
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -54,7 +55,7 @@ const char* kXmpMalformedBody =
     "</x:xmpmeta>\n";
 
 // XMP extension test data.
-const char* kXmpExtensionHeaderPart2 = "123ABCxxxxxxxx";
+const char* kXmpExtensionHeaderPart2 = "123ABC";
 const char* kXmpExtensionBody =
     "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
     "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
@@ -64,6 +65,29 @@ const char* kXmpExtensionBody =
     "  </rdf:RDF>\n"
     "</x:xmpmeta>\n";
 
+// A stream buffer over a string that cannot seek, like a pipe. Hands out at
+// most a few bytes per underflow to exercise buffer refills.
+class NonSeekableStreamBuf : public std::streambuf {
+ public:
+  explicit NonSeekableStreamBuf(const string& data) : data_(data) {}
+
+ protected:
+  int_type underflow() override {
+    if (position_ == data_.size()) {
+      return traits_type::eof();
+    }
+    const size_t length = std::min<size_t>(7, data_.size() - position_);
+    char* begin = &data_[position_];
+    setg(begin, begin, begin + length);
+    position_ += length;
+    return traits_type::to_int_type(*begin);
+  }
+
+ private:
+  string data_;
+  size_t position_ = 0;
+};
+
 TEST(JpegIO, ParseStandardXmp) {
   const string filename = TempFileAbsolutePath("test.jpg");
   std::vector<string> standard_xmp;
@@ -203,5 +227,127 @@ TEST(JpegIO, ParseJpegWithExtendedXmpReadEverything) {
   EXPECT_TRUE(sections.at(sections.size() - 1).is_image_section);
 }
 
+TEST(JpegIO, ParseNonSeekableStream) {
+  const string filename = TestFileAbsolutePath(kJpegTestDataPath);
+  string contents;
+  ReadFileToStringOrDie(filename, &contents);
+  std::istringstream seekable_stream(contents);
+  const std::vector<Section> expected = Parse(ParseOptions(), &seekable_stream);
+
+  NonSeekableStreamBuf stream_buffer(contents);
+  std::istream stream(&stream_buffer);
+  const std::vector<Section> sections = Parse(ParseOptions(), &stream);
+  ASSERT_EQ(expected.size(), sections.size());
+  for (int i = 0; i < sections.size(); ++i) {
+    EXPECT_EQ(expected[i].marker, sections[i].marker);
+    EXPECT_EQ(expected[i].is_image_section, sections[i].is_image_section);
+    EXPECT_EQ(expected[i].data, sections[i].data);
+  }
+}
+
+TEST(JpegIO, ParseNonSeekableStreamWithTruncatedSection) {
+  string contents = "\xff\xd8\xff\xe1";
+  contents += '\0';
+  contents += "\x06" "abcd\xff\xe1";
+  contents += '\0';
+  contents += "\x40" "ab";
+  NonSeekableStreamBuf stream_buffer(contents);
+  std::istream stream(&stream_buffer);
+  const std::vector<Section> sections = Parse(ParseOptions(), &stream);
+  ASSERT_EQ(1, sections.size());
+  EXPECT_EQ("abcd", sections[0].data);
+  // As with std::istream::read, the short read is reported on the stream.
+  EXPECT_TRUE(stream.eof());
+  EXPECT_TRUE(stream.fail());
+}
+
+TEST(JpegIO, ParseLeavesStreamAfterFirstMatchingSection) {
+  string contents = "\xff\xd8\xff\xe1";
+  contents += '\0';
+  contents += "\x06" "abcd\xff\xe1";
+  contents += '\0';
+  contents += "\x04" "ef";
+  std::istringstream stream(contents);
+  ParseOptions parse_options;
+  parse_options.section_header = "ab";
+  parse_options.section_header_return_first = true;
+  EXPECT_EQ(1, Parse(parse_options, &stream).size());
+  EXPECT_TRUE(stream.good());
+  EXPECT_EQ(10, stream.tellg());
+}
+
+TEST(JpegIO, SectionIndexMatchesParse) {
+  const string filename = TestFileAbsolutePath(kJpegTestDataPath);
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  ASSERT_TRUE(file.is_open());
+  const std::vector<Section> sections = Parse(ParseOptions(), &file);
+
+  std::unique_ptr<SectionIndex> index = SectionIndex::FromFile(filename);
+  ASSERT_NE(nullptr, index);
+  const std::vector<SectionView>& views = index->Sections();
+  ASSERT_EQ(sections.size(), views.size());
+  for (int i = 0; i < sections.size(); ++i) {
+    EXPECT_EQ(sections[i].marker, views[i].marker);
+    EXPECT_EQ(sections[i].is_image_section, views[i].is_image_section);
+    EXPECT_EQ(sections[i].data, string(views[i].data, views[i].length));
+    // Views point into the mapped file rather than into copies.
+    EXPECT_EQ(index->data() + views[i].offset, views[i].data);
+  }
+}
+
+TEST(JpegIO, SectionIndexFromBuffer) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string filename = TempFileAbsolutePath("test.jpg");
+  TestXmpCreator::WriteJPEGFile(filename, xmp_sections);
+  string contents;
+  ReadFileToStringOrDie(filename, &contents);
+
+  std::unique_ptr<SectionIndex> index =
+      SectionIndex::FromBuffer(contents.data(), contents.size());
+  EXPECT_EQ(contents.data(), index->data());
+  EXPECT_EQ(1, index->FindApp1Sections(XmpConst::Header()).size());
+  const std::vector<SectionView> extended_sections =
+      index->FindApp1Sections(XmpConst::ExtensionHeader());
+  ASSERT_EQ(2, extended_sections.size());
+  EXPECT_EQ(xmp_sections[1], string(extended_sections[0].data,
+                                    extended_sections[0].length));
+}
+
+TEST(JpegIO, SectionIndexRejectsNonJpeg) {
+  const string contents = "not a jpeg";
+  std::unique_ptr<SectionIndex> index =
+      SectionIndex::FromBuffer(contents.data(), contents.size());
+  EXPECT_TRUE(index->Sections().empty());
+  EXPECT_EQ(nullptr, SectionIndex::FromFile(TempFileAbsolutePath("none.jpg")));
+}
+
+TEST(JpegIO, SectionIndexStopsAtTruncatedSection) {
+  string contents = "\xff\xd8\xff\xe1";
+  contents += '\0';
+  contents += "\x06" "abcd\xff\xe1";
+  contents += '\0';
+  contents += "\x40" "ab";
+  std::unique_ptr<SectionIndex> index =
+      SectionIndex::FromBuffer(contents.data(), contents.size());
+  ASSERT_EQ(1, index->Sections().size());
+  EXPECT_EQ("abcd", string(index->Sections()[0].data,
+                           index->Sections()[0].length));
+}
+
+TEST(JpegIO, WriteSectionViews) {
+  const string filename = TestFileAbsolutePath(kJpegTestDataPath);
+  string contents;
+  ReadFileToStringOrDie(filename, &contents);
+  std::unique_ptr<SectionIndex> index =
+      SectionIndex::FromBuffer(contents.data(), contents.size());
+  std::ostringstream output;
+  WriteSections(index->Sections(), &output);
+  EXPECT_EQ(contents, output.str());
+}
+
 }  // namespace
 }  // namespace xmpmeta
@@ -0,0 +1,64 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/md5.h"
+
+#include <algorithm>
+#include <string>
+
+#include "xmpmeta/benchmark.h"
+
+namespace xmpmeta {
+namespace {
+
+// Returns size bytes of data that does not compress to a pattern.
+string CreateData(size_t size) {
+  string data(size, '\0');
+  uint32 state = 1;
+  for (char& c : data) {
+    state = state * 1103515245 + 12345;
+    c = static_cast<char>(state >> 16);
+  }
+  return data;
+}
+
+// Measures MD5Hash throughput from 1 KB, about one XMP section, to 16 MB, a
+// large extended section.
+void BM_MD5Hash() {
+  for (size_t size : {1 << 10, 64 << 10, 16 << 20}) {
+    const string data = CreateData(size);
+    RunBenchmarkCase("MD5Hash/" + std::to_string(size >> 10) + "K", size, 0,
+                     [&]() { DoNotOptimize(MD5Hash(data)); });
+  }
+}
+XMPMETA_BENCHMARK(BM_MD5Hash);
+
+// Measures MD5Hasher over 16 MB added in the 64 KB pieces of extended XMP
+// sections, which should match MD5Hash on the whole buffer.
+void BM_MD5Hasher() {
+  const size_t kSize = 16 << 20;
+  const size_t kPieceSize = 65000;
+  const string data = CreateData(kSize);
+  MD5Hasher hasher;
+  RunBenchmarkCase("MD5Hasher/16384K", kSize, 0, [&]() {
+    for (size_t start = 0; start < kSize; start += kPieceSize) {
+      hasher.Update(data.data() + start, std::min(kPieceSize, kSize - start));
+    }
+    DoNotOptimize(hasher.Final());
+  });
+}
+XMPMETA_BENCHMARK(BM_MD5Hasher);
+
+}  // namespace
+}  // namespace xmpmeta
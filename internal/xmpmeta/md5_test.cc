@@ -14,6 +14,7 @@
 
 #include "xmpmeta/md5.h"
 
+#include <algorithm>
 #include <sstream>
 #include <string>
 
@@ -54,5 +55,48 @@ TEST(MD5, MD5HashNullString) {
   ASSERT_EQ(kExpectedHashLength, value.length());
 }
 
+TEST(MD5, MD5HashKnownValues) {
+  EXPECT_EQ("d41d8cd98f00b204e9800998ecf8427e", MD5Hash(""));
+  EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", MD5Hash("abc"));
+  EXPECT_EQ("57edf4a22be3c955ac49da2e2107b67a",
+            MD5Hash("1234567890123456789012345678901234567890"
+                    "1234567890123456789012345678901234567890"));
+}
+
+TEST(MD5, MD5HasherMatchesMD5Hash) {
+  string data;
+  for (int i = 0; i < 1000; i++) {
+    data.push_back(static_cast<char>(i * 7));
+  }
+  const string expected = MD5Hash(data);
+
+  // Split the data at every size, to cover partial and whole blocks.
+  for (size_t piece_size = 1; piece_size <= 130; piece_size++) {
+    MD5Hasher hasher;
+    for (size_t position = 0; position < data.size();
+         position += piece_size) {
+      hasher.Update(data.data() + position,
+                    std::min(piece_size, data.size() - position));
+    }
+    ASSERT_EQ(expected, hasher.Final()) << "Piece size " << piece_size;
+  }
+}
+
+TEST(MD5, MD5HasherRestarts) {
+  MD5Hasher hasher;
+  EXPECT_EQ(MD5Hash(""), hasher.Final());
+
+  hasher.Update("abc");
+  EXPECT_EQ(MD5Hash("abc"), hasher.Final());
+  // Final starts a new hash.
+  hasher.Update("abc");
+  EXPECT_EQ(MD5Hash("abc"), hasher.Final());
+
+  hasher.Update("dropped");
+  hasher.Init();
+  hasher.Update("abc");
+  EXPECT_EQ(MD5Hash("abc"), hasher.Final());
+}
+
 }  // namespace
 }  // namespace xmpmeta
@@ -0,0 +1,214 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/number_parser.h"
+
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+
+#include "base/port.h"
+
+namespace xmpmeta {
+namespace {
+
+// The most significant decimal digits that always fit in a uint64.
+const int kMaxSignificantDigits = 19;
+
+// Powers of ten that are exactly representable as doubles.
+const double kExactPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+const int kMaxExactPowerOfTen = 22;
+
+// The largest integer below which all integers are exactly representable as
+// doubles.
+const uint64 kMaxExactDoubleInteger = 1ULL << 53;
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+         c == '\v';
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Narrows [*begin, *end) to exclude leading and trailing whitespace. Returns
+// false if nothing is left.
+bool TrimSpace(const char** begin, const char** end) {
+  while (*begin != *end && IsSpace(**begin)) {
+    ++*begin;
+  }
+  while (*end != *begin && IsSpace(*(*end - 1))) {
+    --*end;
+  }
+  return *begin != *end;
+}
+
+template <typename T>
+bool ParseInteger(const char* text, size_t length, T* value) {
+  const char* p = text;
+  const char* end = text + length;
+  if (!TrimSpace(&p, &end)) {
+    return false;
+  }
+  const bool negative = *p == '-';
+  if (*p == '-' || *p == '+') {
+    ++p;
+  }
+  if (p == end) {
+    return false;
+  }
+  // Accumulate the magnitude, which for the most negative value is one more
+  // than the largest positive value.
+  const uint64 limit =
+      static_cast<uint64>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+  uint64 magnitude = 0;
+  for (; p != end; ++p) {
+    if (!IsDigit(*p)) {
+      return false;
+    }
+    const int digit = *p - '0';
+    if (magnitude > (limit - digit) / 10) {
+      return false;
+    }
+    magnitude = magnitude * 10 + digit;
+  }
+  if (negative) {
+    // Negate in the unsigned type to avoid overflow on the most negative value.
+    *value = static_cast<T>(0 - magnitude);
+  } else {
+    *value = static_cast<T>(magnitude);
+  }
+  return true;
+}
+
+// Parses a real that the fast path cannot, using the classic "C" locale.
+// The text has already been checked to be a valid real.
+double ParseRealSlowly(const char* begin, const char* end, int exponent) {
+  std::istringstream stream(string(begin, end));
+  stream.imbue(std::locale::classic());
+  double value;
+  stream >> value;
+  if (!stream.fail()) {
+    return value;
+  }
+  // The value is out of range.
+  const bool negative = *begin == '-';
+  if (exponent > 0) {
+    return negative ? -std::numeric_limits<double>::infinity()
+                    : std::numeric_limits<double>::infinity();
+  }
+  return negative ? -0.0 : 0.0;
+}
+
+}  // namespace
+
+bool ParseNumber(const char* text, size_t length, int* value) {
+  return ParseInteger(text, length, value);
+}
+
+bool ParseNumber(const char* text, size_t length, int64* value) {
+  return ParseInteger(text, length, value);
+}
+
+bool ParseNumber(const char* text, size_t length, double* value) {
+  const char* begin = text;
+  const char* end = text + length;
+  if (!TrimSpace(&begin, &end)) {
+    return false;
+  }
+  const char* p = begin;
+  const bool negative = *p == '-';
+  if (*p == '-' || *p == '+') {
+    ++p;
+  }
+
+  // Read up to kMaxSignificantDigits significant digits into significand,
+  // such that the value is significand * 10^exponent. Later digits only
+  // matter if they are not zero, which makes the value inexact.
+  uint64 significand = 0;
+  int significant_digits = 0;
+  int exponent = 0;
+  bool inexact = false;
+  bool has_digits = false;
+  for (; p != end && IsDigit(*p); ++p) {
+    has_digits = true;
+    if (significant_digits < kMaxSignificantDigits) {
+      significand = significand * 10 + (*p - '0');
+      significant_digits += significand != 0;
+    } else {
+      ++exponent;
+      inexact |= *p != '0';
+    }
+  }
+  if (p != end && *p == '.') {
+    for (++p; p != end && IsDigit(*p); ++p) {
+      has_digits = true;
+      if (significant_digits < kMaxSignificantDigits) {
+        significand = significand * 10 + (*p - '0');
+        significant_digits += significand != 0;
+        --exponent;
+      } else {
+        inexact |= *p != '0';
+      }
+    }
+  }
+  if (!has_digits) {
+    return false;
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    const bool negative_exponent = p != end && *p == '-';
+    if (p != end && (*p == '-' || *p == '+')) {
+      ++p;
+    }
+    if (p == end || !IsDigit(*p)) {
+      return false;
+    }
+    // Saturate, since any exponent this large overflows or underflows.
+    int explicit_exponent = 0;
+    for (; p != end && IsDigit(*p); ++p) {
+      if (explicit_exponent < 100000) {
+        explicit_exponent = explicit_exponent * 10 + (*p - '0');
+      }
+    }
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+  if (p != end) {
+    return false;
+  }
+
+  if (significand == 0) {
+    *value = negative ? -0.0 : 0.0;
+    return true;
+  }
+  // If both the significand and the power of ten are exact doubles, a single
+  // multiplication or division is correctly rounded.
+  if (!inexact && significand <= kMaxExactDoubleInteger &&
+      exponent >= -kMaxExactPowerOfTen && exponent <= kMaxExactPowerOfTen) {
+    double result = static_cast<double>(significand);
+    if (exponent < 0) {
+      result /= kExactPowersOfTen[-exponent];
+    } else {
+      result *= kExactPowersOfTen[exponent];
+    }
+    *value = negative ? -result : result;
+    return true;
+  }
+  *value = ParseRealSlowly(begin, end, exponent + significant_digits);
+  return true;
+}
+
+}  // namespace xmpmeta
@@ -0,0 +1,49 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_NUMBER_PARSER_H_
+#define XMPMETA_NUMBER_PARSER_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "base/integral_types.h"
+
+namespace xmpmeta {
+
+// Parsers for the decimal numbers in XMP property values. These work in place
+// on the given characters, which need not be null-terminated, do not depend
+// on the locale, and do not throw. Leading and trailing whitespace is
+// allowed. Returns false if the text, less the whitespace, is not entirely a
+// number, or if an integer is out of range.
+//
+// Integers are an optional sign followed by decimal digits.
+bool ParseNumber(const char* text, size_t length, int* value);
+bool ParseNumber(const char* text, size_t length, int64* value);
+
+// Reals are an optional sign, decimal digits with an optional decimal point,
+// and an optional exponent, e.g. "-1.5e-3". Values are correctly rounded, and
+// round to infinity or zero on overflow or underflow. Most values are parsed
+// without allocating.
+bool ParseNumber(const char* text, size_t length, double* value);
+
+// Same as above, for a null-terminated string.
+template <typename T>
+bool ParseNumber(const char* text, T* value) {
+  return ParseNumber(text, strlen(text), value);
+}
+
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_NUMBER_PARSER_H_
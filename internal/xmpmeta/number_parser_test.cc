@@ -0,0 +1,158 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/number_parser.h"
+
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace xmpmeta {
+namespace {
+
+TEST(NumberParser, ParseInt) {
+  int value;
+  ASSERT_TRUE(ParseNumber("42", &value));
+  EXPECT_EQ(42, value);
+  ASSERT_TRUE(ParseNumber(" \n-17\t", &value));
+  EXPECT_EQ(-17, value);
+  ASSERT_TRUE(ParseNumber("+0", &value));
+  EXPECT_EQ(0, value);
+  ASSERT_TRUE(ParseNumber("2147483647", &value));
+  EXPECT_EQ(std::numeric_limits<int>::max(), value);
+  ASSERT_TRUE(ParseNumber("-2147483648", &value));
+  EXPECT_EQ(std::numeric_limits<int>::min(), value);
+
+  // Only the given length is read.
+  ASSERT_TRUE(ParseNumber("123456", 3, &value));
+  EXPECT_EQ(123, value);
+}
+
+TEST(NumberParser, ParseIntRejectsInvalidText) {
+  int value;
+  EXPECT_FALSE(ParseNumber("", &value));
+  EXPECT_FALSE(ParseNumber("  ", &value));
+  EXPECT_FALSE(ParseNumber("-", &value));
+  EXPECT_FALSE(ParseNumber("12a", &value));
+  EXPECT_FALSE(ParseNumber("1 2", &value));
+  EXPECT_FALSE(ParseNumber("1.0", &value));
+  EXPECT_FALSE(ParseNumber("2147483648", &value));
+  EXPECT_FALSE(ParseNumber("-2147483649", &value));
+}
+
+TEST(NumberParser, ParseInt64) {
+  int64 value;
+  ASSERT_TRUE(ParseNumber("9223372036854775807", &value));
+  EXPECT_EQ(std::numeric_limits<int64>::max(), value);
+  ASSERT_TRUE(ParseNumber("-9223372036854775808", &value));
+  EXPECT_EQ(std::numeric_limits<int64>::min(), value);
+  ASSERT_TRUE(ParseNumber("1234567890123", &value));
+  EXPECT_EQ(1234567890123LL, value);
+  EXPECT_FALSE(ParseNumber("9223372036854775808", &value));
+  EXPECT_FALSE(ParseNumber("18446744073709551616", &value));
+}
+
+TEST(NumberParser, ParseDouble) {
+  double value;
+  ASSERT_TRUE(ParseNumber("1.5", &value));
+  EXPECT_EQ(1.5, value);
+  ASSERT_TRUE(ParseNumber(" -0.25 ", &value));
+  EXPECT_EQ(-0.25, value);
+  ASSERT_TRUE(ParseNumber("3", &value));
+  EXPECT_EQ(3.0, value);
+  ASSERT_TRUE(ParseNumber(".5", &value));
+  EXPECT_EQ(0.5, value);
+  ASSERT_TRUE(ParseNumber("5.", &value));
+  EXPECT_EQ(5.0, value);
+  ASSERT_TRUE(ParseNumber("+1e3", &value));
+  EXPECT_EQ(1000.0, value);
+  ASSERT_TRUE(ParseNumber("-1.5E-3", &value));
+  EXPECT_EQ(-1.5e-3, value);
+  ASSERT_TRUE(ParseNumber("-0", &value));
+  EXPECT_EQ(0.0, value);
+  EXPECT_TRUE(std::signbit(value));
+}
+
+TEST(NumberParser, ParseDoubleRoundsCorrectly) {
+  // These need more digits or larger exponents than the fast path handles.
+  const char* texts[] = {
+      "0.1",
+      "3.141592653589793",
+      "2.718281828459045235360287471352662497757",
+      "1.7976931348623157e308",
+      "4.9406564584124654e-324",
+      "123456789012345678901234567890",
+      "0.000000000000000000000000000001",
+      "9007199254740993",
+      "1e23",
+      "-6.02214076e23",
+  };
+  for (const char* text : texts) {
+    double value;
+    ASSERT_TRUE(ParseNumber(text, &value)) << text;
+    EXPECT_EQ(strtod(text, nullptr), value) << text;
+  }
+}
+
+TEST(NumberParser, ParseDoubleOutOfRange) {
+  double value;
+  ASSERT_TRUE(ParseNumber("1e400", &value));
+  EXPECT_EQ(std::numeric_limits<double>::infinity(), value);
+  ASSERT_TRUE(ParseNumber("-1e400", &value));
+  EXPECT_EQ(-std::numeric_limits<double>::infinity(), value);
+  ASSERT_TRUE(ParseNumber("1e-400", &value));
+  EXPECT_EQ(0.0, value);
+  ASSERT_TRUE(ParseNumber("1e99999999999", &value));
+  EXPECT_EQ(std::numeric_limits<double>::infinity(), value);
+}
+
+TEST(NumberParser, ParseDoubleRejectsInvalidText) {
+  double value;
+  EXPECT_FALSE(ParseNumber("", &value));
+  EXPECT_FALSE(ParseNumber(" ", &value));
+  EXPECT_FALSE(ParseNumber(".", &value));
+  EXPECT_FALSE(ParseNumber("-", &value));
+  EXPECT_FALSE(ParseNumber("1e", &value));
+  EXPECT_FALSE(ParseNumber("1e+", &value));
+  EXPECT_FALSE(ParseNumber("1.5x", &value));
+  EXPECT_FALSE(ParseNumber("1,5", &value));
+  EXPECT_FALSE(ParseNumber("1.2.3", &value));
+  EXPECT_FALSE(ParseNumber("nan", &value));
+}
+
+TEST(NumberParser, ParseDoubleIgnoresLocale) {
+  // Use a locale whose decimal separator is a comma, if the system has one.
+  const string old_locale = setlocale(LC_NUMERIC, nullptr);
+  if (setlocale(LC_NUMERIC, "de_DE.UTF-8") == nullptr) {
+    setlocale(LC_NUMERIC, "fr_FR.UTF-8");
+  }
+  double value;
+  double long_value;
+  const bool parsed = ParseNumber("1.25", &value);
+  const bool parsed_long =
+      ParseNumber("2.718281828459045235360287471352662497757", &long_value);
+  setlocale(LC_NUMERIC, old_locale.c_str());
+  ASSERT_TRUE(parsed);
+  EXPECT_EQ(1.25, value);
+  ASSERT_TRUE(parsed_long);
+  EXPECT_EQ(strtod("2.718281828459045235360287471352662497757", nullptr),
+            long_value);
+}
+
+}  // namespace
+}  // namespace xmpmeta
@@ -32,6 +32,14 @@ const char* kJPEGSectionStart = "\xff\xe1";
 const char* kJPEGRemainder =
     "\xff\xdaJpegPixelData\xff\xd9";  // SOS, data, EOI.
 
+// Appends a big-endian 4-byte integer.
+void AppendIntAs4Bytes(int value, string* data) {
+  data->push_back(static_cast<char>((value >> 24) & 0xff));
+  data->push_back(static_cast<char>((value >> 16) & 0xff));
+  data->push_back(static_cast<char>((value >> 8) & 0xff));
+  data->push_back(static_cast<char>(value & 0xff));
+}
+
 }  // namespace
 
 string TestXmpCreator::CreateStandardXmpString(string xmp_body) {
@@ -54,6 +62,8 @@ TestXmpCreator::CreateExtensionXmpStrings(const int num_sections,
     string xmp_string = kXmpExtensionHeaderPart1;
     xmp_string.push_back(0);
     xmp_string.append(extension_header_part_2);
+    AppendIntAs4Bytes(length, &xmp_string);
+    AppendIntAs4Bytes(start, &xmp_string);
     xmp_string.append(body.substr(start, end - start));
     sections.emplace_back(xmp_string);
   }
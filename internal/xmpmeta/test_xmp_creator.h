@@ -31,6 +31,7 @@ class TestXmpCreator {
   // Splits up the xmp extension body into multiple strings with headers, each
   // of which is to be used as a section in the jpeg.
   // extension_header_part_2 is the GUID of the extended section's contents.
+  // Each header also holds the total body length and the section's offset.
   static std::vector<string>
       CreateExtensionXmpStrings(const int num_sections,
                                 const char* extension_header_part_2,
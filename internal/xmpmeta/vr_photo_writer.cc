@@ -20,13 +20,17 @@
 
 #include "base/port.h"
 #include "glog/logging.h"
+#include "xmpmeta/md5.h"
+#include "xmpmeta/xmp_const.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/serializer_impl.h"
+#include "xmpmeta/xml/streaming_serializer.h"
 #include "xmpmeta/xml/utils.h"
 
 using xmpmeta::xml::GetFirstDescriptionElement;
 using xmpmeta::xml::Serializer;
 using xmpmeta::xml::SerializerImpl;
+using xmpmeta::xml::StreamingSerializer;
 using xmpmeta::xml::ToXmlChar;
 using xmpmeta::xml::XmlConst;
 
@@ -47,6 +51,19 @@ void PopulateNamespaceMap(
   }
 }
 
+// Copies the entries of a name, href mapping that have an href, and are not
+// already in dest_map, to dest_map. This selects the same namespaces as
+// PopulateNamespaceMap, in the same order.
+void FilterNamespaceMap(
+    const std::unordered_map<string, string>& ns_name_href_map,
+    std::unordered_map<string, string>* dest_map) {
+  for (const auto& entry : ns_name_href_map) {
+    if (dest_map->count(entry.first) == 0 && !entry.second.empty()) {
+      dest_map->emplace(entry.first, entry.second);
+    }
+  }
+}
+
 }  // namespace
 
 bool WriteVrPhotoMetaToXmp(const GImage& gimage, const GPano& gpano,
@@ -103,4 +120,61 @@ bool WriteVrPhotoMetaToXmp(const GImage& gimage, const GPano& gpano,
   return true;
 }
 
+bool WriteVrPhotoMetaToXmpPackets(const GImage& gimage, const GPano& gpano,
+                                  const GAudio* gaudio, string* standard_xmp,
+                                  string* extended_xmp) {
+  if (standard_xmp == nullptr || extended_xmp == nullptr) {
+    LOG(ERROR) << "XMP packet outputs cannot be null";
+    return false;
+  }
+  standard_xmp->clear();
+  extended_xmp->clear();
+
+  // The namespaces are chosen as in WriteVrPhotoMetaToXmp, so that the output
+  // is the same.
+  std::unordered_map<string, string> ns_name_href_map;
+  gimage.GetNamespaces(&ns_name_href_map);
+  if (gaudio != nullptr) {
+    gaudio->GetNamespaces(&ns_name_href_map);
+  }
+  std::unordered_map<string, string> ext_namespaces;
+  FilterNamespaceMap(ns_name_href_map, &ext_namespaces);
+  gpano.GetNamespaces(&ns_name_href_map);
+  std::unordered_map<string, string> main_namespaces;
+  FilterNamespaceMap(ns_name_href_map, &main_namespaces);
+
+  std::unique_ptr<StreamingSerializer> main_serializer =
+      StreamingSerializer::FromNamespaces(main_namespaces, standard_xmp);
+  std::unique_ptr<StreamingSerializer> ext_serializer =
+      StreamingSerializer::FromNamespaces(ext_namespaces, extended_xmp);
+
+  // The link to the extended section is written last, once the extended
+  // section is complete, but its namespace must be declared first.
+  main_serializer->AddNamespace(XmpConst::HasExtensionPrefix(),
+                                XmpConst::NoteNamespace());
+
+  if (!gpano.Serialize(main_serializer.get())) {
+    LOG(ERROR) << "Could not serialize GPano to XMP";
+    return false;
+  }
+  if (!gimage.Serialize(main_serializer.get(), ext_serializer.get())) {
+    LOG(ERROR) << "Could not serialize GImage to XMP";
+    return false;
+  }
+  if (gaudio != nullptr &&
+      !gaudio->Serialize(main_serializer.get(), ext_serializer.get())) {
+    LOG(ERROR) << "Could not serialize GAudio to XMP";
+    return false;
+  }
+
+  ext_serializer->Finish();
+  if (!main_serializer->WriteProperty(XmpConst::HasExtensionPrefix(),
+                                      XmpConst::HasExtension(),
+                                      MD5Hash(*extended_xmp))) {
+    return false;
+  }
+  main_serializer->Finish();
+  return true;
+}
+
 }  // namespace xmpmeta
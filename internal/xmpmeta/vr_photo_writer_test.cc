@@ -15,6 +15,7 @@
 #include "xmpmeta/vr_photo_writer.h"
 
 #include <memory>
+#include <sstream>
 #include <vector>
 
 #include "glog/logging.h"
@@ -22,6 +23,7 @@
 #include "xmpmeta/file.h"
 #include "xmpmeta/pano_meta_data.h"
 #include "xmpmeta/test_util.h"
+#include "xmpmeta/test_xmp_creator.h"
 #include "xmpmeta/xmp_writer.h"
 #include "xmpmeta/xml/utils.h"
 
@@ -38,6 +40,51 @@ const char kStandardSectionWithoutAudioData[] =
 const char kExtendedSectionWithoutAudioData[] =
     "vr_photo_no_audio_ext_section_data.txt";
 
+// Returns the XMP packet that is written to a JPEG file for the given XML
+// document text, which drops the XML declaration.
+string StripXmlDeclaration(const string& xml) {
+  return xml.substr(xml.find('\n'));
+}
+
+std::unique_ptr<GPano> CreateGPano() {
+  PanoMetaData meta;
+  meta.full_width = 10;
+  meta.full_height = 20;
+  meta.cropped_width = 5;
+  meta.cropped_height = 10;
+  meta.cropped_left = 0;
+  meta.cropped_top = 3;
+  return GPano::CreateFromData(meta);
+}
+
+// Checks that WriteVrPhotoMetaToXmpPackets writes the same JPEG file as
+// WriteVrPhotoMetaToXmp does through an XmpData.
+void ExpectPacketsMatchXmpData(const GImage& gimage, const GPano& gpano,
+                               const GAudio* gaudio,
+                               const char* ext_section_data_file) {
+  string standard_xmp;
+  string extended_xmp;
+  ASSERT_TRUE(WriteVrPhotoMetaToXmpPackets(gimage, gpano, gaudio,
+                                           &standard_xmp, &extended_xmp));
+  std::string expected_data;
+  ReadFileToStringOrDie(TestFileAbsolutePath(ext_section_data_file),
+                        &expected_data);
+  EXPECT_EQ(StripXmlDeclaration(expected_data), extended_xmp);
+
+  std::unique_ptr<XmpData> xmp_data = CreateXmpData(true);
+  ASSERT_TRUE(WriteVrPhotoMetaToXmp(gimage, gpano, gaudio, xmp_data.get()));
+  const string jpeg = TestXmpCreator::MakeJPEGFileContents({});
+  std::istringstream xmp_data_input(jpeg);
+  std::ostringstream xmp_data_output;
+  ASSERT_TRUE(AddXmpMetaToJpegStream(&xmp_data_input, *xmp_data,
+                                     &xmp_data_output));
+  std::istringstream packets_input(jpeg);
+  std::ostringstream packets_output;
+  ASSERT_TRUE(AddXmpPacketsToJpegStream(&packets_input, standard_xmp,
+                                        extended_xmp, &packets_output));
+  EXPECT_EQ(xmp_data_output.str(), packets_output.str());
+}
+
 TEST(VrPhotoWriter, WriteWithAudio) {
   const string imageData = "ImageData";
   const string imageMime = "image/jpeg";
@@ -111,5 +158,32 @@ TEST(VrPhotoWriter, WriteWithoutAudio) {
   EXPECT_EQ(expected_data, xml::XmlDocToString(xmp_data->ExtendedSection()));
 }
 
+TEST(VrPhotoWriter, WritePacketsWithAudio) {
+  std::unique_ptr<GImage> gimage =
+      GImage::CreateFromData("ImageData", "image/jpeg");
+  std::unique_ptr<GAudio> gaudio =
+      GAudio::CreateFromData("AudioData", "audio/mp4");
+  std::unique_ptr<GPano> gpano = CreateGPano();
+  ExpectPacketsMatchXmpData(*gimage, *gpano, gaudio.get(),
+                            kExtendedSectionWithAudioData);
+}
+
+TEST(VrPhotoWriter, WritePacketsWithoutAudio) {
+  std::unique_ptr<GImage> gimage =
+      GImage::CreateFromData("ImageData", "image/jpeg");
+  std::unique_ptr<GPano> gpano = CreateGPano();
+  ExpectPacketsMatchXmpData(*gimage, *gpano, nullptr,
+                            kExtendedSectionWithoutAudioData);
+}
+
+TEST(VrPhotoWriter, WritePacketsNullOutput) {
+  std::unique_ptr<GImage> gimage =
+      GImage::CreateFromData("ImageData", "image/jpeg");
+  std::unique_ptr<GPano> gpano = CreateGPano();
+  string standard_xmp;
+  EXPECT_FALSE(WriteVrPhotoMetaToXmpPackets(*gimage, *gpano, nullptr,
+                                            &standard_xmp, nullptr));
+}
+
 }  // namespace
 }  // namespace xmpmeta
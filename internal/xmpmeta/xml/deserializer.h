@@ -21,6 +21,7 @@
 
 #include "base/integral_types.h"
 #include "base/port.h"
+#include "xmpmeta/xml/property_value.h"
 
 namespace xmpmeta {
 namespace xml {
@@ -46,6 +47,14 @@ class Deserializer {
                                           const string& list_name,
                                           int index) const = 0;
 
+  // Returns a Deserializer for each element of a list, in order. Prefer this
+  // to calling CreateDeserializerFromListElementAt with increasing indices,
+  // which may take time linear in the index.
+  // Returns an empty vector if the list is not found or has no elements.
+  virtual std::vector<std::unique_ptr<Deserializer>>
+      CreateListElementDeserializers(const string& prefix,
+                                     const string& list_name) const = 0;
+
   // Parsers for properties with the given prefix.
   // Parses a node such as <NodeName Prefix:Name="Value" />
   virtual bool ParseBase64(const string& prefix, const string& name,
@@ -61,6 +70,11 @@ class Deserializer {
   virtual bool ParseString(const string& prefix, const string& name,
                            string* value) const = 0;
 
+  // Same as above, but borrows the text instead of copying it when possible.
+  // See PropertyValue for how long a borrowed value stays valid.
+  virtual bool ParseString(const string& prefix, const string& name,
+                           PropertyValue* value) const = 0;
+
   // Parsers for arrays.
   virtual bool ParseIntArray(const string& prefix, const string& list_name,
                              std::vector<int>* values) const = 0;
@@ -16,8 +16,8 @@
 
 #include "base/integral_types.h"
 #include "glog/logging.h"
-#include "strings/numbers.h"
 #include "xmpmeta/base64.h"
+#include "xmpmeta/number_parser.h"
 #include "xmpmeta/xmp_parser.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/search.h"
@@ -29,38 +29,21 @@ namespace {
 
 // Converts a string to a boolean value if bool_str is one of "false" or "true",
 // regardless of letter casing.
-bool BoolStringToBool(const string& bool_str, bool* value) {
-  string bool_str_lower = bool_str;
-  std::transform(bool_str_lower.begin(), bool_str_lower.end(),
-                 bool_str_lower.begin(), ::tolower);
-  if (bool_str_lower == "true") {
+bool BoolStringToBool(const PropertyValue& bool_str, bool* value) {
+  if (strcasecmp(bool_str.data(), "true") == 0) {
     *value = true;
     return true;
   }
-  if (bool_str_lower == "false") {
+  if (strcasecmp(bool_str.data(), "false") == 0) {
     *value = false;
     return true;
   }
   return false;
 }
 
-// Search for an rdf:Seq node, if it hasn't already been set.
-// parent_name is the name of the rdf:Seq node's parent.
-xmlNodePtr FindSeqNode(const xmlNodePtr node, const string& prefix,
-                       const string& parent_name) {
-  xmlNodePtr parent_node =
-      DepthFirstSearch(node, prefix.data(), parent_name.data());
-  if (parent_node == nullptr) {
-    LOG(WARNING) << "Node " << parent_name << " not found";
-    return nullptr;
-  }
-  return GetFirstSeqElement(parent_node);
-}
-
-// Extracts the specified string attribute.
-bool GetStringProperty(const xmlNodePtr node, const string& prefix,
-                       const string& property, string* value) {
-  const xmlDocPtr doc = node->doc;
+// Returns the attribute of node with the given name.
+const _xmlAttr* FindAttribute(const xmlNodePtr node, const string& prefix,
+                              const string& property) {
   for (const _xmlAttr* attribute = node->properties;
        attribute != nullptr; attribute = attribute->next) {
     // If prefix is not empty, then the attribute's namespace must not be null.
@@ -68,42 +51,116 @@ bool GetStringProperty(const xmlNodePtr node, const string& prefix,
          strcmp(FromXmlChar(attribute->ns->prefix), prefix.data()) == 0) ||
          prefix.empty()) &&
         strcmp(FromXmlChar(attribute->name), property.data()) == 0) {
-      xmlChar* attribute_string =
-          xmlNodeListGetString(doc, attribute->children, 1);
-      *value = FromXmlChar(attribute_string);
-      xmlFree(attribute_string);
-      return true;
+      return attribute;
     }
   }
   LOG(WARNING) << "Could not find string attribute: " << property;
+  return nullptr;
+}
+
+// Borrows the text of a list of nodes if the list is a single text node. This
+// is the usual case for attribute values and for the contents of elements
+// that hold a value. Returns false otherwise.
+bool BorrowSingleText(const xmlNode* nodes, PropertyValue* value) {
+  if (nodes != nullptr && nodes->next == nullptr &&
+      (nodes->type == XML_TEXT_NODE ||
+       nodes->type == XML_CDATA_SECTION_NODE) &&
+      nodes->content != nullptr) {
+    const char* text = FromXmlChar(nodes->content);
+    value->Borrow(text, strlen(text));
+    return true;
+  }
   return false;
 }
 
-// Reads the contents of a node.
-// E.g. <prefix:node_name>Contents Here</prefix:node_name>
-bool ReadNodeContent(const xmlNodePtr node, const string& prefix,
-                     const string& node_name, string* value) {
-  auto* element = DepthFirstSearch(node, prefix.data(), node_name.data());
-  if (element == nullptr) {
-    return false;
+// Moves a string allocated by libxml into value.
+void OwnXmlString(xmlChar* xml_string, PropertyValue* value) {
+  if (xml_string == nullptr) {
+    value->Own(string());
+  } else {
+    value->Own(FromXmlChar(xml_string));
+    xmlFree(xml_string);
   }
-  if (!prefix.empty() &&
-      (element->ns == nullptr ||
-       element->ns->prefix == nullptr ||
-       strcmp(FromXmlChar(element->ns->prefix),
-              prefix.data()) != 0)) {
-    return false;
+}
+
+// Parses the contents of the rdf:li nodes of an rdf:Seq node as numbers.
+// values is sized up front and filled in place. On failure, values holds the
+// numbers before the first that could not be parsed.
+template <typename T>
+bool ParseListElements(const xmlNodePtr seq_node, std::vector<T>* values) {
+  size_t count = 0;
+  for (xmlNodePtr li_node = GetFirstElement(seq_node); li_node != nullptr;
+       li_node = GetNextElement(li_node)) {
+    ++count;
+  }
+  values->resize(count);
+  size_t i = 0;
+  PropertyValue text;
+  for (xmlNodePtr li_node = GetFirstElement(seq_node); li_node != nullptr;
+       li_node = GetNextElement(li_node), ++i) {
+    if (!BorrowSingleText(li_node->children, &text)) {
+      text.Own(GetLiNodeContent(li_node));
+    }
+    if (!ParseNumber(text.data(), text.size(), &(*values)[i])) {
+      values->resize(i);
+      return false;
+    }
   }
-  xmlChar* node_content = xmlNodeGetContent(element);
-  *value = FromXmlChar(node_content);
-  free(node_content);
   return true;
 }
 
-// Reads the string value of a property from the given XML node.
-bool ReadStringProperty(const xmlNodePtr node, const string& prefix,
-                        const string& property, string* value) {
-  if (node == nullptr) {
+}  // namespace
+
+DeserializerImpl::DeserializerImpl(const xmlNodePtr node) : node_(node) {}
+
+DeserializerImpl::DeserializerImpl(const xmlNodePtr node,
+                                   const std::shared_ptr<const void>& source)
+    : node_(node), source_(source) {}
+
+DeserializerImpl::DeserializerImpl(
+    const xmlNodePtr node, const std::shared_ptr<const NodeIndex>& index,
+    const std::shared_ptr<const void>& source)
+    : node_(node), source_(source), index_(index) {}
+
+// Private methods.
+std::shared_ptr<const NodeIndex> DeserializerImpl::GetIndex() const {
+  std::shared_ptr<const NodeIndex> index = std::atomic_load(&index_);
+  if (index != nullptr) {
+    return index;
+  }
+  std::lock_guard<std::mutex> lock(index_mutex_);
+  index = std::atomic_load(&index_);
+  if (index == nullptr) {
+    index.reset(new NodeIndex(node_));
+    std::atomic_store(&index_, index);
+  }
+  return index;
+}
+
+xmlNodePtr DeserializerImpl::FindNode(const xmlNodePtr root,
+                                      const string& prefix,
+                                      const string& name) const {
+  if (root == nullptr) {
+    return nullptr;
+  }
+  return GetIndex()->Find(root, prefix, name);
+}
+
+xmlNodePtr DeserializerImpl::GetListElementAt(const xmlNodePtr seq_node,
+                                              int index) const {
+  const std::shared_ptr<const NodeIndex> node_index = GetIndex();
+  const std::vector<xmlNodePtr>& elements =
+      node_index->GetListElements(seq_node);
+  if (index < 0 || static_cast<size_t>(index) >= elements.size()) {
+    return nullptr;
+  }
+  return elements[index];
+}
+
+bool DeserializerImpl::ReadStringProperty(const string& prefix,
+                                          const string& property,
+                                          PropertyValue* value) const {
+  if (node_ == nullptr) {
     return false;
   }
   if (property.empty()) {
@@ -112,30 +169,52 @@ bool ReadStringProperty(const xmlNodePtr node, const string& prefix,
   }
 
   // Try parsing in the format <Node ... Prefix:Property="Value"/>
-  bool success = GetStringProperty(node, prefix, property, value);
-  if (!success) {
-    // Try parsing in the format <Prefix:Property>Value</Prefix:Property>
-    success = ReadNodeContent(node, prefix, property, value);
+  // The attributes of node_ are not indexed, since scanning them directly
+  // costs no more than a lookup.
+  const _xmlAttr* attribute = FindAttribute(node_, prefix, property);
+  if (attribute != nullptr) {
+    if (!BorrowSingleText(attribute->children, value)) {
+      OwnXmlString(xmlNodeListGetString(node_->doc, attribute->children, 1),
+                   value);
+    }
+    return true;
   }
-  return success;
-}
 
-// Same as ReadStringProperty, but applies base-64 decoding to the output.
-bool ReadBase64Property(const xmlNodePtr node, const string& prefix,
-                        const string& property, string* value) {
-  string base64_data;
-  if (!ReadStringProperty(node, prefix, property, &base64_data)) {
+  // Try parsing in the format <Prefix:Property>Value</Prefix:Property>
+  const xmlNodePtr element = FindNode(node_, prefix, property);
+  if (element == nullptr) {
+    return false;
+  }
+  if (!prefix.empty() &&
+      (element->ns == nullptr ||
+       element->ns->prefix == nullptr ||
+       strcmp(FromXmlChar(element->ns->prefix),
+              prefix.data()) != 0)) {
     return false;
   }
-  return DecodeBase64(base64_data, value);
+  if (!BorrowSingleText(element->children, value)) {
+    OwnXmlString(xmlNodeGetContent(element), value);
+  }
+  return true;
 }
 
-}  // namespace
-
-DeserializerImpl::DeserializerImpl(const xmlNodePtr node) : node_(node),
-  list_node_(nullptr) {}
+// Search for an rdf:Seq node.
+// list_name is the name of the rdf:Seq node's parent.
+xmlNodePtr DeserializerImpl::FindSeqNode(const string& prefix,
+                                         const string& list_name) const {
+  xmlNodePtr parent_node = FindNode(node_, prefix, list_name);
+  if (parent_node == nullptr) {
+    LOG(WARNING) << "Node " << list_name << " not found";
+    return nullptr;
+  }
+  return FindNode(parent_node, "", XmlConst::RdfSeq());
+}
 
 // Public methods.
+void DeserializerImpl::InvalidateIndex() {
+  std::atomic_store(&index_, std::shared_ptr<const NodeIndex>());
+}
+
 std::unique_ptr<Deserializer>
 DeserializerImpl::CreateDeserializer(const string& prefix,
                                      const string& child_name) const {
@@ -143,13 +222,13 @@ DeserializerImpl::CreateDeserializer(const string& prefix,
     LOG(ERROR) << "Child name is empty";
     return nullptr;
   }
-  xmlNodePtr child_node =
-      DepthFirstSearch(node_, prefix.data(), child_name.data());
+  xmlNodePtr child_node = FindNode(node_, prefix, child_name);
   if (child_node == nullptr) {
     LOG(ERROR) << "Could not find " << child_name << " node";
     return nullptr;
   }
-  return std::unique_ptr<Deserializer>(new DeserializerImpl(child_node));
+  return std::unique_ptr<Deserializer>(
+      new DeserializerImpl(child_node, GetIndex(), source_));
 }
 
 std::unique_ptr<Deserializer>
@@ -165,44 +244,61 @@ DeserializerImpl::CreateDeserializerFromListElementAt(const string& prefix,
     LOG(ERROR) << "Parent name cannot be empty";
     return nullptr;
   }
-  // Search for an rdf:Seq node, if the name of list_node_ doesn't match
-  // the given parent name.
-  // Ensures thread safety.
-  const xmlNodePtr list_node = [&] {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (list_node_ == nullptr ||
-        string(FromXmlChar(list_node_->name)) != list_name) {
-      list_node_ = DepthFirstSearch(node_, prefix.data(), list_name.data());
-    }
-    return list_node_;
-  }();
+  // The list and its elements are looked up in the shared index, so threads
+  // reading lists from the same deserializer do not contend.
+  const xmlNodePtr list_node = FindNode(node_, prefix, list_name);
   if (list_node == nullptr) {
     return nullptr;
   }
 
-  xmlNodePtr seq_node = GetFirstSeqElement(list_node);
+  xmlNodePtr seq_node = FindNode(list_node, "", XmlConst::RdfSeq());
   if (seq_node == nullptr) {
     LOG(ERROR) << "No rdf:Seq node found on " << list_name;
     return nullptr;
   }
-  xmlNodePtr li_node = GetElementAt(seq_node, index);
+  xmlNodePtr li_node = GetListElementAt(seq_node, index);
   if (li_node == nullptr) {
     return nullptr;
   }
   // Return a new Deserializer with the current rdf:li node and the current
   // node name.
-  return std::unique_ptr<Deserializer>(new DeserializerImpl(li_node));
+  return std::unique_ptr<Deserializer>(
+      new DeserializerImpl(li_node, GetIndex(), source_));
+}
+
+std::vector<std::unique_ptr<Deserializer>>
+DeserializerImpl::CreateListElementDeserializers(
+    const string& prefix, const string& list_name) const {
+  std::vector<std::unique_ptr<Deserializer>> deserializers;
+  if (list_name.empty()) {
+    LOG(ERROR) << "Parent name cannot be empty";
+    return deserializers;
+  }
+  xmlNodePtr seq_node = FindSeqNode(prefix, list_name);
+  if (seq_node == nullptr) {
+    return deserializers;
+  }
+  const std::shared_ptr<const NodeIndex> index = GetIndex();
+  for (xmlNodePtr li_node = GetFirstElement(seq_node); li_node != nullptr;
+       li_node = GetNextElement(li_node)) {
+    deserializers.emplace_back(new DeserializerImpl(li_node, index, source_));
+  }
+  return deserializers;
 }
 
 bool DeserializerImpl::ParseBase64(const string& prefix, const string& name,
                                    string* value) const {
-  return ReadBase64Property(node_, prefix, name, value);
+  PropertyValue base64_data;
+  if (!ReadStringProperty(prefix, name, &base64_data)) {
+    return false;
+  }
+  return DecodeBase64(base64_data.data(), base64_data.size(), value);
 }
 
 bool DeserializerImpl::ParseBoolean(const string& prefix, const string& name,
                                     bool* value) const {
-  string string_value;
-  if (!ReadStringProperty(node_, prefix, name, &string_value)) {
+  PropertyValue string_value;
+  if (!ReadStringProperty(prefix, name, &string_value)) {
     return false;
   }
   return BoolStringToBool(string_value, value);
@@ -210,83 +306,73 @@ bool DeserializerImpl::ParseBoolean(const string& prefix, const string& name,
 
 bool DeserializerImpl::ParseDouble(const string& prefix, const string& name,
                                    double* value) const {
-  string string_value;
-  if (!ReadStringProperty(node_, prefix, name, &string_value)) {
-    return false;
-  }
-  *value = std::stod(string_value);
-  return true;
+  PropertyValue string_value;
+  return ReadStringProperty(prefix, name, &string_value) &&
+         ParseNumber(string_value.data(), string_value.size(), value);
 }
 
 bool DeserializerImpl::ParseInt(const string& prefix, const string& name,
                                 int* value) const {
-  string string_value;
-  if (!ReadStringProperty(node_, prefix, name, &string_value)) {
-    return false;
-  }
-  return SimpleAtoi(string_value, value);
+  PropertyValue string_value;
+  return ReadStringProperty(prefix, name, &string_value) &&
+         ParseNumber(string_value.data(), string_value.size(), value);
 }
 
 bool DeserializerImpl::ParseLong(const string& prefix, const string& name,
                                  int64* value) const {
-  string string_value;
-  if (!ReadStringProperty(node_, prefix, name, &string_value)) {
+  PropertyValue string_value;
+  return ReadStringProperty(prefix, name, &string_value) &&
+         ParseNumber(string_value.data(), string_value.size(), value);
+}
+
+bool DeserializerImpl::ParseString(const string& prefix, const string& name,
+                                   string* value) const {
+  PropertyValue string_value;
+  if (!ReadStringProperty(prefix, name, &string_value)) {
     return false;
   }
-  *value = std::stol(string_value);
+  value->assign(string_value.data(), string_value.size());
   return true;
 }
 
 bool DeserializerImpl::ParseString(const string& prefix, const string& name,
-                                   string* value) const {
-  return ReadStringProperty(node_, prefix, name, value);
+                                   PropertyValue* value) const {
+  if (!ReadStringProperty(prefix, name, value)) {
+    return false;
+  }
+  if (value->borrowed()) {
+    value->ShareSource(source_);
+  }
+  return true;
 }
 
 bool DeserializerImpl::ParseIntArray(const string& prefix,
                                      const string& list_name,
                                      std::vector<int>* values) const {
-  xmlNodePtr seq_node = FindSeqNode(node_, prefix, list_name);
+  xmlNodePtr seq_node = FindSeqNode(prefix, list_name);
   if (seq_node == nullptr) {
     LOG(ERROR) << "No rdf:Seq node found";
     return false;
   }
-  values->clear();
-  int i = 0;
-  for (xmlNodePtr li_node = GetElementAt(seq_node, 0);
-       li_node != nullptr;
-       li_node = GetElementAt(seq_node, ++i)) {
-    int int_value;
-    if (!SimpleAtoi(GetLiNodeContent(li_node), &int_value)) {
-      LOG(ERROR) << "Could not parse rdf:li node value to an integer";
-      return false;
-    }
-    values->push_back(int_value);
+  if (!ParseListElements(seq_node, values)) {
+    LOG(ERROR) << "Could not parse rdf:li node value to an integer";
+    return false;
   }
-
   return true;
 }
 
 bool DeserializerImpl::ParseDoubleArray(const string& prefix,
                                         const string& list_name,
                                         std::vector<double>* values) const {
-  xmlNodePtr seq_node = FindSeqNode(node_, prefix, list_name);
+  xmlNodePtr seq_node = FindSeqNode(prefix, list_name);
   if (seq_node == nullptr) {
     LOG(ERROR) << "No rdf:Seq node found";
     return false;
   }
-  values->clear();
-  int i = 0;
-  for (xmlNodePtr li_node = GetElementAt(seq_node, 0);
-       li_node != nullptr;
-       li_node = GetElementAt(seq_node, ++i)) {
-    double double_value;
-    if (!safe_strtod(GetLiNodeContent(li_node), &double_value)) {
-      LOG(ERROR) << "Could not parse rdf:li node value to a double";
-      return false;
-    }
-    values->push_back(double_value);
+  if (!ParseListElements(seq_node, values)) {
+    LOG(ERROR) << "Could not parse rdf:li node value to a double";
+    return false;
   }
-
   return true;
 }
 
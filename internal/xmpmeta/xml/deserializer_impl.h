@@ -16,13 +16,16 @@
 #define XMPMETA_XML_DESERIALIZER_IMPL_H_
 
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <libxml/tree.h>
 
 #include "base/port.h"
 #include "xmpmeta/xml/deserializer.h"
+#include "xmpmeta/xml/node_index.h"
 
 namespace xmpmeta {
 namespace xml {
@@ -35,11 +38,26 @@ namespace xml {
 //   string revision;
 //   deserializer.ParseString("Device", "Revision", &revision);
 // TODO(miraleung): Add example for list node deserializer.
+// The first search for a child node indexes the subtree of node by name, and
+// the index is shared with the deserializers created from this one, so later
+// searches, whether or not they find a node, do not walk the tree. The index
+// is not updated when the tree changes: after adding or removing nodes under
+// node, call InvalidateIndex before the next search, or the search may miss
+// new nodes or return freed ones.
+// A deserializer may be used from several threads at once. Once the index is
+// built, searches only take a reference to it.
 class DeserializerImpl : public Deserializer {
  public:
   // Creates a deserializer with a null rdf:Seq node.
   DeserializerImpl(const xmlNodePtr node);
 
+  // Same as above, where source owns the document of node, e.g. the XmpData
+  // holding it. Values borrowed by this deserializer and the deserializers
+  // created from it share ownership of source, so they stay valid after the
+  // caller releases it.
+  DeserializerImpl(const xmlNodePtr node,
+                   const std::shared_ptr<const void>& source);
+
   // Returns a Deserializer.
   // If prefix is empty, the deserializer will be created on the first node
   // found with a name that matches child_name.
@@ -58,6 +76,12 @@ class DeserializerImpl : public Deserializer {
                                           const string& list_name,
                                           int index) const override;
 
+  // Returns a Deserializer for each rdf:li node of the first rdf:Seq node
+  // under the first node named list_name, in order.
+  std::vector<std::unique_ptr<Deserializer>>
+      CreateListElementDeserializers(const string& prefix,
+                                     const string& list_name) const override;
+
   // Parsers for XML properties.
   // If prefix is empty, the node's namespace may be null. Otherwise, it must
   // not be null.
@@ -74,6 +98,13 @@ class DeserializerImpl : public Deserializer {
   bool ParseString(const string& prefix, const string& name,
                    string* value) const override;
 
+  // Borrows the text from the XML document if the property's value is one
+  // text node, which is the usual case. A borrowed value is valid while the
+  // document is alive and unmodified, e.g. as long as the XmpData holding it,
+  // and shares ownership of the document if this deserializer has a source.
+  bool ParseString(const string& prefix, const string& name,
+                   PropertyValue* value) const override;
+
   // Parses the numbers in an rdf:Seq list into the values collection.
   // The given collection is cleared of any existing values, and the
   // parsed numbers are written to it.
@@ -82,18 +113,54 @@ class DeserializerImpl : public Deserializer {
   bool ParseDoubleArray(const string& prefix, const string& list_name,
                         std::vector<double>* values) const override;
 
+  // Discards the index, so that the next search indexes the tree again. Must
+  // be called after the subtree of node is modified. Deserializers created
+  // from this one keep the index they were created with, so they must be
+  // invalidated too, or created again.
+  void InvalidateIndex();
+
   // Disallow copying.
   DeserializerImpl(const DeserializerImpl&) = delete;
   void operator=(const DeserializerImpl&) = delete;
 
  private:
+  // Creates a deserializer that shares an index that contains node, and the
+  // source of its document.
+  DeserializerImpl(const xmlNodePtr node,
+                   const std::shared_ptr<const NodeIndex>& index,
+                   const std::shared_ptr<const void>& source);
+
+  // Returns the index of the subtree of node_, building it if needed. Does
+  // not take index_mutex_ unless the index is built.
+  std::shared_ptr<const NodeIndex> GetIndex() const;
+
+  // Returns the first node in the subtree of root, which must be node_ or a
+  // descendant of it, with the given name, as DepthFirstSearch does.
+  xmlNodePtr FindNode(const xmlNodePtr root, const string& prefix,
+                      const string& name) const;
+
+  // Reads the value of a property, either from an attribute of node_ or from
+  // the content of a descendant element. Borrows the text from the tree if it
+  // is held in a single text node. Returns false if the property is not found.
+  bool ReadStringProperty(const string& prefix, const string& property,
+                          PropertyValue* value) const;
+
+  // Returns the rdf:Seq node of the first list with the given name.
+  xmlNodePtr FindSeqNode(const string& prefix, const string& list_name) const;
+
+  // Returns the ith rdf:li node of an rdf:Seq node, as GetElementAt does.
+  xmlNodePtr GetListElementAt(const xmlNodePtr seq_node, int index) const;
+
   xmlNodePtr node_;
-  // Remembers the parent node of the last deserializer created on the rdf:Seq
-  // node. For performance reasons only, to avoid unnessarily traversing
-  // the XML document tree.
-  mutable xmlNodePtr list_node_;
-  // Lock modifications of list_node_ in const functions to make it thread-safe.
-  mutable std::mutex mtx_;
+  // Owns the document of node_, or null if the caller keeps it alive.
+  std::shared_ptr<const void> source_;
+  // The current index, or null until it is first needed or after it is
+  // invalidated. Always read and written with std::atomic_load and
+  // std::atomic_store. A reader holds its own reference, so a replaced index
+  // is freed once the last search using it returns.
+  mutable std::shared_ptr<const NodeIndex> index_;
+  // Serializes the building of indices.
+  mutable std::mutex index_mutex_;
 };
 
 }  // namespace xml
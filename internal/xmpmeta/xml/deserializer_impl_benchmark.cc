@@ -0,0 +1,138 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/deserializer_impl.h"
+
+#include <libxml/parser.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "xmpmeta/benchmark.h"
+#include "xmpmeta/file.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+// Returns testdata/xdm/device_testdata.txt with its list of three cameras
+// repeated to hold camera_count cameras.
+string CreateDeviceXml(int camera_count) {
+  string xml;
+  ReadFileToStringOrDie(BenchmarkDataPath("xdm/device_testdata.txt"), &xml);
+  const size_t cameras_start =
+      xml.find("<rdf:li>", xml.find("<Device:Cameras>"));
+  const size_t cameras_end = xml.find("</rdf:Seq>", cameras_start);
+  CHECK_NE(string::npos, cameras_start);
+  CHECK_NE(string::npos, cameras_end);
+  const string cameras = xml.substr(cameras_start, cameras_end - cameras_start);
+  string repeated_cameras;
+  for (int i = 0; i < camera_count / 3; ++i) {
+    repeated_cameras += cameras;
+  }
+  xml.replace(cameras_start, cameras_end - cameras_start, repeated_cameras);
+  return xml;
+}
+
+// Reads the Device revision, pose and every camera's audio properties, the
+// way Device::FromXmp walks the tree.
+void ReadDevice(const xmlDocPtr doc, int camera_count) {
+  DeserializerImpl description(GetFirstDescriptionElement(doc));
+  std::unique_ptr<Deserializer> device =
+      description.CreateDeserializer("", "Device");
+  CHECK(device != nullptr);
+  string revision;
+  CHECK(device->ParseString("Device", "Revision", &revision));
+  std::unique_ptr<Deserializer> pose =
+      device->CreateDeserializer("Device", "DevicePose");
+  double latitude;
+  CHECK(pose->ParseDouble("DevicePose", "Latitude", &latitude));
+  for (int i = 0; i < camera_count; ++i) {
+    std::unique_ptr<Deserializer> camera =
+        device->CreateDeserializerFromListElementAt("Device", "Cameras", i);
+    CHECK(camera != nullptr);
+    std::unique_ptr<Deserializer> audio =
+        camera->CreateDeserializer("Camera", "Audio");
+    string mime;
+    CHECK(audio->ParseString("Audio", "Mime", &mime));
+    string data;
+    CHECK(audio->ParseBase64("Audio", "Data", &data));
+  }
+}
+
+// Measures property lookups over the XDM device fixture with 3 to 300
+// cameras. Each call creates the deserializers anew, so any index is built
+// once per call.
+void BM_ReadDevice() {
+  for (int camera_count : {3, 30, 300}) {
+    const string xml = CreateDeviceXml(camera_count);
+    xmlDocPtr doc =
+        xmlReadMemory(xml.data(), xml.size(), nullptr, nullptr, 0);
+    CHECK(doc != nullptr);
+    RunBenchmarkCase("ReadDevice/" + std::to_string(camera_count) + "cameras",
+                     0, camera_count,
+                     [&]() { ReadDevice(doc, camera_count); });
+    xmlFreeDoc(doc);
+  }
+}
+XMPMETA_BENCHMARK(BM_ReadDevice);
+
+// Measures list element lookups from several threads sharing one Device
+// deserializer, each reading every camera of a 300-camera device. Each call
+// starts and joins its threads.
+void BM_ReadCamerasConcurrently() {
+  const int kCameraCount = 300;
+  const string xml = CreateDeviceXml(kCameraCount);
+  xmlDocPtr doc = xmlReadMemory(xml.data(), xml.size(), nullptr, nullptr, 0);
+  CHECK(doc != nullptr);
+  DeserializerImpl description(GetFirstDescriptionElement(doc));
+  std::unique_ptr<Deserializer> device =
+      description.CreateDeserializer("", "Device");
+  CHECK(device != nullptr);
+  for (int thread_count : {1, 2, 4, 8}) {
+    RunBenchmarkCase(
+        "ReadCamerasConcurrently/" + std::to_string(thread_count) + "threads",
+        0, thread_count * kCameraCount, [&]() {
+          std::vector<std::thread> threads;
+          for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&device, kCameraCount]() {
+              for (int i = 0; i < kCameraCount; ++i) {
+                std::unique_ptr<Deserializer> camera =
+                    device->CreateDeserializerFromListElementAt(
+                        "Device", "Cameras", i);
+                CHECK(camera != nullptr);
+                std::unique_ptr<Deserializer> audio =
+                    camera->CreateDeserializer("Camera", "Audio");
+                string mime;
+                CHECK(audio->ParseString("Audio", "Mime", &mime));
+              }
+            });
+          }
+          for (std::thread& thread : threads) {
+            thread.join();
+          }
+        });
+  }
+  device.reset();
+  xmlFreeDoc(doc);
+}
+XMPMETA_BENCHMARK(BM_ReadCamerasConcurrently);
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
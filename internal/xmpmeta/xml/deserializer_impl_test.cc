@@ -16,6 +16,7 @@
 
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <libxml/tree.h>
@@ -26,6 +27,7 @@
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/utils.h"
 
+using xmpmeta::xml::FromXmlChar;
 using xmpmeta::xml::ToXmlChar;
 using xmpmeta::xml::XmlConst;
 
@@ -135,6 +137,7 @@ TEST(DeserializerImpl, CreateDeserializerWithPrefixOnPrefixedNode) {
   xmlSetNsProp(another_child_node, another_child_ns, ToXmlChar("PropertyTwo"),
                ToXmlChar("PropertyTwoValue"));
   xmlAddChild(node, another_child_node);
+  deserializer.InvalidateIndex();
   created_deserializer =
       deserializer.CreateDeserializer("AnotherChildNodePrefix", child_name);
   ASSERT_NE(nullptr, created_deserializer.get());
@@ -274,6 +277,158 @@ TEST(DeserializerImpl, CreateDeserializerFromListElement) {
   xmlFreeNode(node);
 }
 
+TEST(DeserializerImpl, CreateListElementDeserializers) {
+  const char* parent_name = "Parent";
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  xmlNsPtr parent_ns = NewNamespace("http://somehref.com", "Prefix");
+  xmlNodePtr seq_parent_node = NewNode(parent_ns, parent_name);
+  xmlNodePtr seq_node = NewNode(nullptr, XmlConst::RdfSeq());
+  for (int i = 0; i < 3; i++) {
+    xmlNodePtr li_node = NewNode(nullptr, XmlConst::RdfLi());
+    xmlSetProp(li_node, ToXmlChar("Index"),
+               ToXmlChar(std::to_string(i).data()));
+    xmlAddChild(seq_node, li_node);
+    // Non-element children are skipped.
+    xmlAddChild(seq_node, xmlNewText(ToXmlChar("\n")));
+  }
+  xmlAddChild(seq_parent_node, seq_node);
+  xmlAddChild(node, seq_parent_node);
+
+  DeserializerImpl deserializer(node);
+  std::vector<std::unique_ptr<Deserializer>> deserializers =
+      deserializer.CreateListElementDeserializers("Prefix", parent_name);
+  ASSERT_EQ(3, deserializers.size());
+  for (int i = 0; i < deserializers.size(); i++) {
+    int index;
+    ASSERT_TRUE(deserializers[i]->ParseInt("", "Index", &index));
+    EXPECT_EQ(i, index);
+  }
+  EXPECT_EQ(3, deserializer.CreateListElementDeserializers("", parent_name)
+                   .size());
+  EXPECT_TRUE(
+      deserializer.CreateListElementDeserializers("Other", parent_name)
+          .empty());
+  EXPECT_TRUE(deserializer.CreateListElementDeserializers("", "").empty());
+
+  xmlFreeNs(parent_ns);
+  xmlFreeNode(node);
+}
+
+TEST(DeserializerImpl, CreateListElementDeserializersNoElements) {
+  const char* parent_name = "Parent";
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  xmlNodePtr seq_parent_node = NewNode(nullptr, parent_name);
+  xmlAddChild(seq_parent_node, NewNode(nullptr, XmlConst::RdfSeq()));
+  xmlAddChild(node, seq_parent_node);
+
+  DeserializerImpl deserializer(node);
+  EXPECT_TRUE(
+      deserializer.CreateListElementDeserializers("", parent_name).empty());
+  EXPECT_TRUE(deserializer.CreateListElementDeserializers("", "Missing")
+                  .empty());
+
+  xmlFreeNode(node);
+}
+
+TEST(DeserializerImpl, CreateDeserializersFromListsOnManyThreads) {
+  const int kNumElements = 200;
+  const int kNumThreads = 8;
+  const char* list_names[] = {"ListA", "ListB"};
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  xmlNsPtr list_ns = NewNamespace("http://somehref.com", "Prefix");
+  for (const char* list_name : list_names) {
+    xmlNodePtr seq_parent_node = NewNode(list_ns, list_name);
+    xmlNodePtr seq_node = NewNode(nullptr, XmlConst::RdfSeq());
+    for (int i = 0; i < kNumElements; i++) {
+      xmlNodePtr li_node = NewNode(nullptr, XmlConst::RdfLi());
+      xmlSetProp(li_node, ToXmlChar("Index"),
+                 ToXmlChar(std::to_string(i).data()));
+      xmlAddChild(seq_node, li_node);
+    }
+    xmlAddChild(seq_parent_node, seq_node);
+    xmlAddChild(node, seq_parent_node);
+  }
+  std::vector<int> numbers;
+  for (int i = 0; i < kNumElements; i++) {
+    numbers.push_back(i);
+  }
+  xmlNodePtr numbers_node = NewNode(list_ns, "Numbers");
+  xmlAddChild(numbers_node, RdfSeqNodeFromArray(numbers));
+  xmlAddChild(node, numbers_node);
+
+  // Each thread alternates between the two lists, which used to thrash the
+  // cached list node, and parses an array in between. One thread also drops
+  // the index now and then, so that indices are freed while other threads
+  // may still be searching them.
+  DeserializerImpl deserializer(node);
+  std::vector<int> failures(kNumThreads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kNumElements; i++) {
+        for (const char* list_name : list_names) {
+          std::unique_ptr<Deserializer> element =
+              deserializer.CreateDeserializerFromListElementAt(
+                  "Prefix", list_name, (i + t) % kNumElements);
+          int index;
+          if (element == nullptr || !element->ParseInt("", "Index", &index) ||
+              index != (i + t) % kNumElements) {
+            failures[t]++;
+          }
+        }
+        if (t == 0 && i % 20 == 0) {
+          deserializer.InvalidateIndex();
+        }
+        if (i % 50 == 0) {
+          std::vector<int> values;
+          if (!deserializer.ParseIntArray("Prefix", "Numbers", &values) ||
+              values != numbers) {
+            failures[t]++;
+          }
+        }
+      }
+      if (deserializer.CreateDeserializerFromListElementAt(
+              "Prefix", list_names[t % 2], kNumElements) != nullptr) {
+        failures[t]++;
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < kNumThreads; t++) {
+    EXPECT_EQ(0, failures[t]) << "Thread " << t;
+  }
+
+  xmlFreeNs(list_ns);
+  xmlFreeNode(node);
+}
+
+TEST(DeserializerImpl, CreateDeserializerFromListElementAfterInvalidateIndex) {
+  const char* parent_name = "Parent";
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  xmlNodePtr seq_parent_node = NewNode(nullptr, parent_name);
+  xmlNodePtr seq_node = NewNode(nullptr, XmlConst::RdfSeq());
+  xmlAddChild(seq_node, NewNode(nullptr, XmlConst::RdfLi()));
+  xmlAddChild(seq_parent_node, seq_node);
+  xmlAddChild(node, seq_parent_node);
+
+  DeserializerImpl deserializer(node);
+  ASSERT_NE(nullptr,
+            deserializer.CreateDeserializerFromListElementAt("", parent_name,
+                                                             0));
+  ASSERT_EQ(nullptr,
+            deserializer.CreateDeserializerFromListElementAt("", parent_name,
+                                                             1));
+  xmlAddChild(seq_node, NewNode(nullptr, XmlConst::RdfLi()));
+  deserializer.InvalidateIndex();
+  EXPECT_NE(nullptr,
+            deserializer.CreateDeserializerFromListElementAt("", parent_name,
+                                                             1));
+
+  xmlFreeNode(node);
+}
+
 TEST(DeserializerImpl, ParseDoubleArrayNoSeqParentNodeElement) {
   const char* node_name = "NodeName";
   xmlNsPtr node_ns = NewNamespace("http://somehref.com", "NodePrefix");
@@ -569,6 +724,45 @@ TEST(DeserializerImpl, ParseDouble) {
 }
 
 // String.
+TEST(DeserializerImpl, ParseNumbersRejectsInvalidText) {
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  xmlSetProp(node, ToXmlChar("Double"), ToXmlChar("1.5abc"));
+  xmlSetProp(node, ToXmlChar("Long"), ToXmlChar("not a number"));
+  xmlSetProp(node, ToXmlChar("Int"), ToXmlChar("99999999999"));
+  DeserializerImpl deserializer(node);
+
+  double double_value;
+  EXPECT_FALSE(deserializer.ParseDouble("", "Double", &double_value));
+  int64 long_value;
+  EXPECT_FALSE(deserializer.ParseLong("", "Long", &long_value));
+  int int_value;
+  EXPECT_FALSE(deserializer.ParseInt("", "Int", &int_value));
+
+  xmlFreeNode(node);
+}
+
+TEST(DeserializerImpl, ParseNumbersFromElementContent) {
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  xmlNodePtr double_node = NewNode(nullptr, "Double");
+  xmlNodeSetContent(double_node, ToXmlChar(" -2.5e2 "));
+  xmlAddChild(node, double_node);
+  // Content split over several nodes is read as a whole.
+  xmlNodePtr long_node = NewNode(nullptr, "Long");
+  xmlAddChild(long_node, xmlNewText(ToXmlChar("12345")));
+  xmlAddChild(long_node, xmlNewCDataBlock(nullptr, ToXmlChar("67890"), 5));
+  xmlAddChild(node, long_node);
+  DeserializerImpl deserializer(node);
+
+  double double_value;
+  ASSERT_TRUE(deserializer.ParseDouble("", "Double", &double_value));
+  EXPECT_EQ(-250.0, double_value);
+  int64 long_value;
+  ASSERT_TRUE(deserializer.ParseLong("", "Long", &long_value));
+  EXPECT_EQ(1234567890LL, long_value);
+
+  xmlFreeNode(node);
+}
+
 TEST(DeserializerImpl, ParseStringEmptyName) {
   const char* node_name = "NodeName";
   xmlNodePtr node = NewNode(nullptr, node_name);
@@ -623,6 +817,58 @@ TEST(DeserializerImpl, ParseString) {
   xmlFreeNode(node);
 }
 
+TEST(DeserializerImpl, ParseStringBorrowsSingleTextNode) {
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  xmlSetProp(node, ToXmlChar("Attribute"), ToXmlChar("Value"));
+  xmlNodePtr element = NewNode(nullptr, "Element");
+  xmlNodeSetContent(element, ToXmlChar("Content"));
+  xmlAddChild(node, element);
+  xmlNodePtr empty = NewNode(nullptr, "Empty");
+  xmlAddChild(node, empty);
+  DeserializerImpl deserializer(node);
+
+  PropertyValue value;
+  ASSERT_TRUE(deserializer.ParseString("", "Attribute", &value));
+  EXPECT_TRUE(value.borrowed());
+  EXPECT_EQ("Value", value.ToString());
+  EXPECT_EQ(FromXmlChar(node->properties->children->content), value.data());
+
+  ASSERT_TRUE(deserializer.ParseString("", "Element", &value));
+  EXPECT_TRUE(value.borrowed());
+  EXPECT_TRUE(value == "Content");
+  EXPECT_EQ(FromXmlChar(element->children->content), value.data());
+
+  ASSERT_TRUE(deserializer.ParseString("", "Empty", &value));
+  EXPECT_TRUE(value.empty());
+  EXPECT_EQ('\0', value.data()[0]);
+
+  EXPECT_FALSE(deserializer.ParseString("", "Missing", &value));
+
+  xmlFreeNode(node);
+}
+
+TEST(DeserializerImpl, ParseStringOwnsSplitText) {
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  xmlNodePtr element = NewNode(nullptr, "Element");
+  xmlAddChild(element, xmlNewText(ToXmlChar("Split")));
+  xmlAddChild(element, xmlNewCDataBlock(nullptr, ToXmlChar("Text"), 4));
+  xmlAddChild(node, element);
+  DeserializerImpl deserializer(node);
+
+  PropertyValue value;
+  ASSERT_TRUE(deserializer.ParseString("", "Element", &value));
+  EXPECT_FALSE(value.borrowed());
+  EXPECT_TRUE(value == "SplitText");
+  EXPECT_TRUE(value != "Split");
+  EXPECT_EQ('\0', value.data()[value.size()]);
+
+  string copy;
+  ASSERT_TRUE(deserializer.ParseString("", "Element", &copy));
+  EXPECT_EQ("SplitText", copy);
+
+  xmlFreeNode(node);
+}
+
 // Base64.
 TEST(DeserializerImpl, ParseBase64EmptyName) {
   const char* node_name = "NodeName";
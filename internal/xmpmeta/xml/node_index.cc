@@ -0,0 +1,127 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/node_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "glog/logging.h"
+#include "xmpmeta/xml/const.h"
+#include "xmpmeta/xml/search.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+// Returns "prefix:name".
+string PrefixedName(const char* prefix, const char* name) {
+  string prefixed_name(prefix);
+  prefixed_name += ':';
+  prefixed_name += name;
+  return prefixed_name;
+}
+
+}  // namespace
+
+NodeIndex::NodeIndex(const xmlNodePtr root) {
+  CHECK(root != nullptr) << "Cannot index a null node";
+  // Walk the subtree in preorder using the parent and sibling links, recording
+  // where each node's subtree begins and ends. The children of entity
+  // references belong to the entity declaration, so they are not followed;
+  // Find walks the subtrees that hold them instead.
+  xmlNodePtr node = root;
+  while (node != nullptr) {
+    const size_t position = nodes_.size();
+    nodes_.push_back(node);
+    subtrees_[node].first = position;
+    if (node->name != nullptr) {
+      const char* name = FromXmlChar(node->name);
+      by_name_[name].push_back(position);
+      if (node->ns != nullptr && node->ns->prefix != nullptr) {
+        by_prefixed_name_[PrefixedName(FromXmlChar(node->ns->prefix), name)]
+            .push_back(position);
+      }
+      if (node != root && node->parent->name != nullptr &&
+          strcmp(name, XmlConst::RdfLi()) == 0 &&
+          strcmp(FromXmlChar(node->parent->name), XmlConst::RdfSeq()) == 0) {
+        list_elements_[node->parent].push_back(node);
+      }
+    }
+    if (node->type == XML_ENTITY_REF_NODE) {
+      entity_references_.push_back(position);
+    } else if (node->children != nullptr) {
+      node = node->children;
+      continue;
+    }
+    // Close finished subtrees until one has a next sibling.
+    while (node != nullptr) {
+      subtrees_[node].second = nodes_.size();
+      if (node == root) {
+        node = nullptr;
+      } else if (node->next != nullptr) {
+        node = node->next;
+        break;
+      } else {
+        node = node->parent;
+      }
+    }
+  }
+}
+
+xmlNodePtr NodeIndex::Find(const xmlNodePtr node, const string& prefix,
+                           const string& name) const {
+  const auto subtree = subtrees_.find(node);
+  if (subtree == subtrees_.end()) {
+    return nullptr;
+  }
+  const auto reference =
+      std::lower_bound(entity_references_.begin(), entity_references_.end(),
+                       subtree->second.first);
+  if (reference != entity_references_.end() &&
+      *reference < subtree->second.second) {
+    return DepthFirstSearch(node, prefix.c_str(), name.c_str());
+  }
+  const auto& positions_by_name = prefix.empty() ? by_name_ : by_prefixed_name_;
+  const auto positions = positions_by_name.find(
+      prefix.empty() ? name : PrefixedName(prefix.c_str(), name.c_str()));
+  if (positions == positions_by_name.end()) {
+    return nullptr;
+  }
+  // The first position at or after the start of the subtree, if it is in the
+  // subtree, is the first match in preorder.
+  const std::vector<size_t>& matches = positions->second;
+  const auto match = std::lower_bound(matches.begin(), matches.end(),
+                                      subtree->second.first);
+  if (match == matches.end() || *match >= subtree->second.second) {
+    return nullptr;
+  }
+  return nodes_[*match];
+}
+
+bool NodeIndex::Contains(const xmlNodePtr node) const {
+  return subtrees_.count(node) > 0;
+}
+
+const std::vector<xmlNodePtr>& NodeIndex::GetListElements(
+    const xmlNodePtr seq_node) const {
+  static const std::vector<xmlNodePtr>* const kNoElements =
+      new std::vector<xmlNodePtr>();
+  const auto elements = list_elements_.find(seq_node);
+  return elements == list_elements_.end() ? *kNoElements : elements->second;
+}
+
+}  // namespace xml
+}  // namespace xmpmeta
@@ -0,0 +1,82 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_NODE_INDEX_H_
+#define XMPMETA_XML_NODE_INDEX_H_
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <libxml/tree.h>
+
+#include "base/port.h"
+
+namespace xmpmeta {
+namespace xml {
+
+// Indexes the nodes of an XML subtree by name in a single preorder walk, so
+// that repeated searches need not re-walk the tree. The index is a snapshot:
+// it must not be used after the subtree is modified, since it may then return
+// nodes that have been freed. It is immutable once built, and so safe to share
+// between threads.
+// The content of an entity may be reached through any number of references,
+// so it is not indexed. Searches of a subtree that holds an entity reference
+// walk the subtree with DepthFirstSearch instead.
+class NodeIndex {
+ public:
+  // Indexes the subtree rooted at root, which must not be null.
+  explicit NodeIndex(const xmlNodePtr root);
+
+  // Returns the first node, in preorder, in the subtree rooted at node
+  // (including node itself) with the given name. This matches
+  // DepthFirstSearch(node, prefix, name): if prefix is empty, the node may be
+  // in any namespace, or none. Returns null if there is no such node, or if
+  // node is not in the indexed subtree.
+  xmlNodePtr Find(const xmlNodePtr node, const string& prefix,
+                  const string& name) const;
+
+  // Returns true if node is in the indexed subtree.
+  bool Contains(const xmlNodePtr node) const;
+
+  // Returns the rdf:li children of an rdf:Seq node in the indexed subtree, in
+  // order, as GetFirstElement and GetNextElement would visit them. Returns an
+  // empty list if there are none, or if seq_node is not indexed.
+  const std::vector<xmlNodePtr>& GetListElements(
+      const xmlNodePtr seq_node) const;
+
+  // Disallow copying.
+  NodeIndex(const NodeIndex&) = delete;
+  void operator=(const NodeIndex&) = delete;
+
+ private:
+  // The nodes in preorder.
+  std::vector<xmlNodePtr> nodes_;
+  // The [begin, end) range of positions in nodes_ of each node's subtree.
+  std::unordered_map<xmlNodePtr, std::pair<size_t, size_t>> subtrees_;
+  // Positions in nodes_, in increasing order, by local name and by
+  // "prefix:name".
+  std::unordered_map<string, std::vector<size_t>> by_name_;
+  std::unordered_map<string, std::vector<size_t>> by_prefixed_name_;
+  // Positions in nodes_ of the entity references, in increasing order.
+  std::vector<size_t> entity_references_;
+  // The rdf:li children of each rdf:Seq node that has any.
+  std::unordered_map<xmlNodePtr, std::vector<xmlNodePtr>> list_elements_;
+};
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_NODE_INDEX_H_
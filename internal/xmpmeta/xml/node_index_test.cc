@@ -0,0 +1,168 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/node_index.h"
+
+#include <vector>
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/xml/search.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+const char kXml[] =
+    "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+    "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\""
+    " xmlns:A=\"http://a/\" xmlns:B=\"http://b/\">"
+    "<rdf:Description A:Attribute=\"1\">"
+    "<A:Name>first</A:Name>"
+    "<B:Name>second</B:Name>"
+    "<A:List><rdf:Seq>"
+    "<rdf:li><A:Name>third</A:Name><Unqualified/></rdf:li>"
+    "<rdf:li><B:Other/></rdf:li>"
+    "</rdf:Seq></A:List>"
+    "<Name>fourth</Name>"
+    "</rdf:Description>"
+    "</rdf:RDF>"
+    "</x:xmpmeta>";
+
+// Collects the nodes of a subtree in preorder.
+void CollectNodes(const xmlNodePtr node, std::vector<xmlNodePtr>* nodes) {
+  nodes->push_back(node);
+  for (xmlNodePtr child = node->children; child != nullptr;
+       child = child->next) {
+    CollectNodes(child, nodes);
+  }
+}
+
+class NodeIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    doc_ = xmlReadMemory(kXml, sizeof(kXml) - 1, nullptr, nullptr, 0);
+    ASSERT_NE(nullptr, doc_);
+  }
+
+  void TearDown() override { xmlFreeDoc(doc_); }
+
+  xmlDocPtr doc_;
+};
+
+TEST_F(NodeIndexTest, FindMatchesDepthFirstSearchFromEveryNode) {
+  const xmlNodePtr root = xmlDocGetRootElement(doc_);
+  NodeIndex index(root);
+  std::vector<xmlNodePtr> nodes;
+  CollectNodes(root, &nodes);
+
+  const char* const kPrefixes[] = {"", "A", "B", "rdf", "C"};
+  const char* const kNames[] = {"Name", "List", "Seq", "li", "Other",
+                                "Unqualified", "Description", "text",
+                                "Missing", "Attribute"};
+  for (const xmlNodePtr node : nodes) {
+    EXPECT_TRUE(index.Contains(node));
+    for (const char* prefix : kPrefixes) {
+      for (const char* name : kNames) {
+        EXPECT_EQ(DepthFirstSearch(node, prefix, name),
+                  index.Find(node, prefix, name))
+            << "prefix " << prefix << ", name " << name;
+      }
+    }
+  }
+}
+
+TEST_F(NodeIndexTest, FindFirstMatchInPreorder) {
+  NodeIndex index(xmlDocGetRootElement(doc_));
+  const xmlNodePtr description = GetFirstDescriptionElement(doc_);
+  ASSERT_NE(nullptr, description);
+
+  xmlNodePtr node = index.Find(description, "", "Name");
+  ASSERT_NE(nullptr, node);
+  xmlChar* content = xmlNodeGetContent(node);
+  EXPECT_STREQ("first", FromXmlChar(content));
+  xmlFree(content);
+
+  node = index.Find(description, "B", "Name");
+  ASSERT_NE(nullptr, node);
+  content = xmlNodeGetContent(node);
+  EXPECT_STREQ("second", FromXmlChar(content));
+  xmlFree(content);
+}
+
+TEST_F(NodeIndexTest, FindOutsideIndexedSubtree) {
+  const xmlNodePtr description = GetFirstDescriptionElement(doc_);
+  ASSERT_NE(nullptr, description);
+  NodeIndex index(description->children);
+
+  // The first child is indexed, but neither its siblings nor its ancestors.
+  EXPECT_NE(nullptr, index.Find(description->children, "A", "Name"));
+  EXPECT_EQ(nullptr, index.Find(description->children, "B", "Name"));
+  EXPECT_FALSE(index.Contains(description));
+  EXPECT_FALSE(index.Contains(description->children->next));
+  EXPECT_EQ(nullptr, index.Find(description, "A", "Name"));
+}
+
+TEST_F(NodeIndexTest, GetListElements) {
+  NodeIndex index(xmlDocGetRootElement(doc_));
+  const xmlNodePtr seq_node = DepthFirstSearch(doc_, "rdf", "Seq");
+  ASSERT_NE(nullptr, seq_node);
+  const std::vector<xmlNodePtr>& elements = index.GetListElements(seq_node);
+  ASSERT_EQ(2, elements.size());
+  EXPECT_EQ(GetElementAt(seq_node, 0), elements[0]);
+  EXPECT_EQ(GetElementAt(seq_node, 1), elements[1]);
+
+  EXPECT_TRUE(index.GetListElements(seq_node->parent).empty());
+  EXPECT_TRUE(index.GetListElements(nullptr).empty());
+}
+
+TEST_F(NodeIndexTest, IndexLeafNode) {
+  const xmlNodePtr leaf = DepthFirstSearch(doc_, "B", "Other");
+  ASSERT_NE(nullptr, leaf);
+  NodeIndex index(leaf);
+  EXPECT_EQ(leaf, index.Find(leaf, "B", "Other"));
+  EXPECT_EQ(leaf, index.Find(leaf, "", "Other"));
+  EXPECT_EQ(nullptr, index.Find(leaf, "A", "Other"));
+}
+
+TEST(NodeIndex, FindInEntityContent) {
+  const char xml[] =
+      "<!DOCTYPE x:xmpmeta [<!ENTITY item \"<Name>entity</Name>\">]>"
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" xmlns:A=\"http://a/\">"
+      "<A:Outer>&item;</A:Outer><A:Other/>"
+      "</x:xmpmeta>";
+  xmlDocPtr doc = xmlReadMemory(xml, sizeof(xml) - 1, nullptr, nullptr, 0);
+  ASSERT_NE(nullptr, doc);
+  const xmlNodePtr root = xmlDocGetRootElement(doc);
+  NodeIndex index(root);
+
+  // The entity's content is found through the reference, as by
+  // DepthFirstSearch, from the subtrees that hold the reference.
+  const xmlNodePtr outer = DepthFirstSearch(root, "A", "Outer");
+  ASSERT_NE(nullptr, outer);
+  const xmlNodePtr node = index.Find(root, "", "Name");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ(DepthFirstSearch(root, "", "Name"), node);
+  EXPECT_EQ(node, index.Find(outer, "", "Name"));
+  EXPECT_EQ(nullptr, index.Find(outer->next, "", "Name"));
+  EXPECT_EQ(outer->next, index.Find(root, "A", "Other"));
+  xmlFreeDoc(doc);
+}
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
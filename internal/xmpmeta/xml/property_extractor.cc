@@ -0,0 +1,339 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/property_extractor.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include <libxml/parser.h>
+#include <libxml/xmlreader.h>
+
+#include "glog/logging.h"
+#include "strings/case.h"
+#include "xmpmeta/base64.h"
+#include "xmpmeta/number_parser.h"
+#include "xmpmeta/xml/const.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+// Returns true if the node's prefix and name match those of the property.
+// An empty property prefix matches any node prefix.
+bool Matches(const string& property_prefix, const string& property_name,
+             const char* prefix, const char* name) {
+  if (name == nullptr || property_name != name) {
+    return false;
+  }
+  return property_prefix.empty() ||
+      (prefix != nullptr && property_prefix == prefix);
+}
+
+// Returns true if the reader is on an rdf:Description element.
+bool IsRdfDescription(xmlTextReaderPtr reader) {
+  const xmlChar* local_name = xmlTextReaderConstLocalName(reader);
+  const xmlChar* namespace_uri = xmlTextReaderConstNamespaceUri(reader);
+  return local_name != nullptr && namespace_uri != nullptr &&
+         strcmp(FromXmlChar(local_name), XmlConst::RdfDescription()) == 0 &&
+         strcmp(FromXmlChar(namespace_uri), XmlConst::RdfNodeNs()) == 0;
+}
+
+// Reads the text of the element the reader is on, up to its end tag, like
+// xmlNodeGetContent. Returns the status of the last xmlTextReaderRead call.
+int ReadElementContent(xmlTextReaderPtr reader, string* content) {
+  const int depth = xmlTextReaderDepth(reader);
+  int status;
+  while ((status = xmlTextReaderRead(reader)) == 1) {
+    const int type = xmlTextReaderNodeType(reader);
+    if (type == XML_READER_TYPE_END_ELEMENT &&
+        xmlTextReaderDepth(reader) == depth) {
+      break;
+    }
+    if (type == XML_READER_TYPE_TEXT || type == XML_READER_TYPE_CDATA ||
+        type == XML_READER_TYPE_WHITESPACE ||
+        type == XML_READER_TYPE_SIGNIFICANT_WHITESPACE) {
+      const char* value = FromXmlChar(xmlTextReaderConstValue(reader));
+      if (value != nullptr) {
+        content->append(value);
+      }
+    }
+  }
+  return status;
+}
+
+// The position of an xmlReaderForIO callback in a list of pieces.
+struct PieceReader {
+  const std::vector<std::pair<const char*, size_t>>* pieces;
+  size_t index;
+  size_t offset;
+};
+
+// Copies up to length bytes of the remaining pieces into buffer. Returns the
+// number of bytes copied, or 0 at the end of the last piece.
+int ReadPieces(void* context, char* buffer, int length) {
+  PieceReader* reader = static_cast<PieceReader*>(context);
+  size_t copied = 0;
+  while (copied < static_cast<size_t>(length) &&
+         reader->index < reader->pieces->size()) {
+    const std::pair<const char*, size_t>& piece =
+        (*reader->pieces)[reader->index];
+    const size_t count = std::min(piece.second - reader->offset,
+                                  static_cast<size_t>(length) - copied);
+    std::memcpy(buffer + copied, piece.first + reader->offset, count);
+    copied += count;
+    reader->offset += count;
+    if (reader->offset == piece.second) {
+      ++reader->index;
+      reader->offset = 0;
+    }
+  }
+  return static_cast<int>(copied);
+}
+
+}  // namespace
+
+PropertyExtractor::PropertyExtractor(
+    const std::vector<std::pair<string, string>>& properties)
+    : num_found_(0) {
+  for (const auto& property : properties) {
+    properties_.push_back({property.first, property.second, "", false});
+  }
+}
+
+bool PropertyExtractor::Extract(const char* data, size_t size) {
+  Clear();
+  if (AllFound()) {
+    return true;
+  }
+  // xmlReaderForMemory requires an int.
+  if (size > INT_MAX) {
+    LOG(ERROR) << "XML data too large, size: " << size;
+    return false;
+  }
+  return ExtractFrom(xmlReaderForMemory(data, static_cast<int>(size), nullptr,
+                                        nullptr, XML_PARSE_HUGE));
+}
+
+bool PropertyExtractor::Extract(
+    const std::vector<std::pair<const char*, size_t>>& pieces) {
+  Clear();
+  if (AllFound()) {
+    return true;
+  }
+  PieceReader piece_reader = {&pieces, 0, 0};
+  return ExtractFrom(xmlReaderForIO(ReadPieces, nullptr, &piece_reader,
+                                    nullptr, nullptr, XML_PARSE_HUGE));
+}
+
+bool PropertyExtractor::AllFound() const {
+  return num_found_ == properties_.size();
+}
+
+std::unique_ptr<Deserializer> PropertyExtractor::CreateDeserializer(
+    const string& /* prefix */, const string& /* child_name */) const {
+  LOG(ERROR) << "PropertyExtractor does not support child deserializers";
+  return nullptr;
+}
+
+std::unique_ptr<Deserializer>
+PropertyExtractor::CreateDeserializerFromListElementAt(
+    const string& /* prefix */, const string& /* list_name */,
+    int /* index */) const {
+  LOG(ERROR) << "PropertyExtractor does not support list deserializers";
+  return nullptr;
+}
+
+std::vector<std::unique_ptr<Deserializer>>
+PropertyExtractor::CreateListElementDeserializers(
+    const string& /* prefix */, const string& /* list_name */) const {
+  LOG(ERROR) << "PropertyExtractor does not support list deserializers";
+  return std::vector<std::unique_ptr<Deserializer>>();
+}
+
+bool PropertyExtractor::ParseBase64(const string& prefix, const string& name,
+                                    string* value) const {
+  const Property* property = Find(prefix, name);
+  if (property == nullptr) {
+    return false;
+  }
+  return DecodeBase64(property->value, value);
+}
+
+bool PropertyExtractor::ParseBoolean(const string& prefix, const string& name,
+                                     bool* value) const {
+  const Property* property = Find(prefix, name);
+  if (property == nullptr) {
+    return false;
+  }
+  if (StringCaseEqual(property->value, "true")) {
+    *value = true;
+    return true;
+  }
+  if (StringCaseEqual(property->value, "false")) {
+    *value = false;
+    return true;
+  }
+  return false;
+}
+
+bool PropertyExtractor::ParseDouble(const string& prefix, const string& name,
+                                    double* value) const {
+  const Property* property = Find(prefix, name);
+  return property != nullptr &&
+         ParseNumber(property->value.data(), property->value.size(), value);
+}
+
+bool PropertyExtractor::ParseInt(const string& prefix, const string& name,
+                                 int* value) const {
+  const Property* property = Find(prefix, name);
+  return property != nullptr &&
+         ParseNumber(property->value.data(), property->value.size(), value);
+}
+
+bool PropertyExtractor::ParseLong(const string& prefix, const string& name,
+                                  int64* value) const {
+  const Property* property = Find(prefix, name);
+  return property != nullptr &&
+         ParseNumber(property->value.data(), property->value.size(), value);
+}
+
+bool PropertyExtractor::ParseString(const string& prefix, const string& name,
+                                    string* value) const {
+  const Property* property = Find(prefix, name);
+  if (property == nullptr) {
+    return false;
+  }
+  *value = property->value;
+  return true;
+}
+
+bool PropertyExtractor::ParseString(const string& prefix, const string& name,
+                                    PropertyValue* value) const {
+  const Property* property = Find(prefix, name);
+  if (property == nullptr) {
+    return false;
+  }
+  value->Borrow(property->value.c_str(), property->value.size());
+  return true;
+}
+
+bool PropertyExtractor::ParseIntArray(const string& /* prefix */,
+                                      const string& /* list_name */,
+                                      std::vector<int>* /* values */) const {
+  LOG(ERROR) << "PropertyExtractor does not support arrays";
+  return false;
+}
+
+bool PropertyExtractor::ParseDoubleArray(
+    const string& /* prefix */, const string& /* list_name */,
+    std::vector<double>* /* values */) const {
+  LOG(ERROR) << "PropertyExtractor does not support arrays";
+  return false;
+}
+
+// Private methods.
+void PropertyExtractor::Clear() {
+  for (Property& property : properties_) {
+    property.value.clear();
+    property.found = false;
+  }
+  num_found_ = 0;
+}
+
+bool PropertyExtractor::ExtractFrom(xmlTextReaderPtr reader) {
+  if (reader == nullptr) {
+    LOG(WARNING) << "Could not create XML reader";
+    return false;
+  }
+
+  int status = 1;
+  while (!AllFound() && (status = xmlTextReaderRead(reader)) == 1) {
+    if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
+      continue;
+    }
+    const char* element_prefix = FromXmlChar(xmlTextReaderConstPrefix(reader));
+    const char* element_name = FromXmlChar(xmlTextReaderConstLocalName(reader));
+    bool element_wanted = false;
+    for (const Property& property : properties_) {
+      if (!property.found && Matches(property.prefix, property.name,
+                                     element_prefix, element_name)) {
+        element_wanted = true;
+        break;
+      }
+    }
+
+    // Attributes come before the element's content in document order. As
+    // with DeserializerImpl, attribute properties are only read from
+    // rdf:Description elements.
+    const bool is_description = IsRdfDescription(reader);
+    while (is_description && xmlTextReaderMoveToNextAttribute(reader) == 1) {
+      if (xmlTextReaderIsNamespaceDecl(reader) == 1) {
+        continue;
+      }
+      Record(FromXmlChar(xmlTextReaderConstPrefix(reader)),
+             FromXmlChar(xmlTextReaderConstLocalName(reader)),
+             FromXmlChar(xmlTextReaderConstValue(reader)));
+    }
+    xmlTextReaderMoveToElement(reader);
+
+    if (element_wanted) {
+      // Copy the name, since the reader moves on while reading the content.
+      const string prefix = element_prefix == nullptr ? "" : element_prefix;
+      const string name = element_name;
+      string content;
+      if (xmlTextReaderIsEmptyElement(reader) != 1) {
+        status = ReadElementContent(reader, &content);
+        if (status != 1) {
+          break;
+        }
+      }
+      Record(prefix.c_str(), name.c_str(), content.c_str());
+    }
+  }
+  xmlFreeTextReader(reader);
+
+  if (status == -1) {
+    LOG(WARNING) << "Malformed XML before all properties were found";
+    return false;
+  }
+  return true;
+}
+
+void PropertyExtractor::Record(const char* prefix, const char* name,
+                               const char* value) {
+  for (Property& property : properties_) {
+    if (!property.found &&
+        Matches(property.prefix, property.name, prefix, name)) {
+      property.value = value;
+      property.found = true;
+      ++num_found_;
+    }
+  }
+}
+
+const PropertyExtractor::Property* PropertyExtractor::Find(
+    const string& prefix, const string& name) const {
+  for (const Property& property : properties_) {
+    if (property.found && property.prefix == prefix && property.name == name) {
+      return &property;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace xml
+}  // namespace xmpmeta
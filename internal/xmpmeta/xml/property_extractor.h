@@ -0,0 +1,132 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_PROPERTY_EXTRACTOR_H_
+#define XMPMETA_XML_PROPERTY_EXTRACTOR_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <libxml/xmlreader.h>
+
+#include "base/integral_types.h"
+#include "base/port.h"
+#include "xmpmeta/xml/deserializer.h"
+
+namespace xmpmeta {
+namespace xml {
+
+// Extracts a fixed set of scalar properties from serialized XML by streaming
+// over it with libxml2's xmlTextReader, without building a DOM. Reading stops
+// as soon as every requested property has been found.
+// Properties may be written either as attributes of rdf:Description,
+// <rdf:Description Prefix:Name="Value"/>, or as elements,
+// <Prefix:Name>Value</Prefix:Name>. Attributes of other elements are ignored. The first occurrence in
+// document order wins. As with DeserializerImpl, an empty prefix matches any
+// prefix.
+// Example:
+//   PropertyExtractor extractor({{"GPano", "ProjectionType"}});
+//   if (extractor.Extract(data, size)) {
+//     string projection_type;
+//     extractor.ParseString("GPano", "ProjectionType", &projection_type);
+//   }
+class PropertyExtractor : public Deserializer {
+ public:
+  // Creates an extractor for the given (prefix, name) pairs.
+  explicit PropertyExtractor(
+      const std::vector<std::pair<string, string>>& properties);
+
+  // Scans the XML in data for the requested properties, discarding the values
+  // found by any previous call. Returns false if the data could not be read,
+  // or if it is malformed before all properties were found.
+  bool Extract(const char* data, size_t size);
+
+  // Same as above, for XML split into consecutive pieces, such as the chunks
+  // of an extended XMP section. The pieces are read in order without being
+  // joined.
+  bool Extract(const std::vector<std::pair<const char*, size_t>>& pieces);
+
+  // Returns true if every requested property was found by the last Extract.
+  bool AllFound() const;
+
+  // Not supported, since no tree is kept. These always return null or an
+  // empty vector.
+  std::unique_ptr<Deserializer>
+      CreateDeserializer(const string& prefix,
+                         const string& child_name) const override;
+  std::unique_ptr<Deserializer>
+      CreateDeserializerFromListElementAt(const string& prefix,
+                                          const string& list_name,
+                                          int index) const override;
+  std::vector<std::unique_ptr<Deserializer>>
+      CreateListElementDeserializers(const string& prefix,
+                                     const string& list_name) const override;
+
+  // Parsers for the properties found by the last Extract call. Return false
+  // if the property was not requested, not found, or cannot be converted.
+  bool ParseBase64(const string& prefix, const string& name,
+                   string* value) const override;
+  bool ParseBoolean(const string& prefix, const string& name,
+                    bool* value) const override;
+  bool ParseDouble(const string& prefix, const string& name,
+                   double* value) const override;
+  bool ParseInt(const string& prefix, const string& name,
+                int* value) const override;
+  bool ParseLong(const string& prefix, const string& name,
+                 int64* value) const override;
+  bool ParseString(const string& prefix, const string& name,
+                   string* value) const override;
+
+  // Borrows the text held by the extractor, which is valid until the next
+  // call to Extract.
+  bool ParseString(const string& prefix, const string& name,
+                   PropertyValue* value) const override;
+
+  // Not supported, since rdf:Seq lists are not scalar. These return false.
+  bool ParseIntArray(const string& prefix, const string& list_name,
+                     std::vector<int>* values) const override;
+  bool ParseDoubleArray(const string& prefix, const string& list_name,
+                        std::vector<double>* values) const override;
+
+ private:
+  struct Property {
+    string prefix;
+    string name;
+    string value;
+    bool found;
+  };
+
+  // Discards the values found by the last Extract call.
+  void Clear();
+
+  // Reads properties from reader until all are found, then frees it. Returns
+  // false if reader is null or the XML is malformed before all were found.
+  bool ExtractFrom(xmlTextReaderPtr reader);
+
+  // Records value for every unfound property matching prefix:name.
+  void Record(const char* prefix, const char* name, const char* value);
+
+  // Returns the requested property with exactly this prefix and name, or null.
+  const Property* Find(const string& prefix, const string& name) const;
+
+  std::vector<Property> properties_;
+  size_t num_found_;
+};
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_PROPERTY_EXTRACTOR_H_
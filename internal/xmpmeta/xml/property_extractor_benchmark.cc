@@ -0,0 +1,105 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/property_extractor.h"
+
+#include <libxml/parser.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "xmpmeta/base64.h"
+#include "xmpmeta/benchmark.h"
+#include "xmpmeta/file.h"
+#include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+// Reads the properties from a DOM of xml, as the FromXmp readers do.
+void ReadWithDom(const string& xml,
+                 const std::vector<std::pair<string, string>>& properties) {
+  xmlDocPtr doc = xmlReadMemory(xml.data(), xml.size(), nullptr, nullptr, 0);
+  CHECK(doc != nullptr);
+  {
+    DeserializerImpl deserializer(GetFirstDescriptionElement(doc));
+    for (const auto& property : properties) {
+      string value;
+      CHECK(deserializer.ParseString(property.first, property.second, &value));
+      DoNotOptimize(value);
+    }
+  }
+  xmlFreeDoc(doc);
+}
+
+void ReadWithExtractor(
+    const string& xml,
+    const std::vector<std::pair<string, string>>& properties) {
+  PropertyExtractor extractor(properties);
+  CHECK(extractor.Extract(xml.data(), xml.size()));
+  for (const auto& property : properties) {
+    string value;
+    CHECK(extractor.ParseString(property.first, property.second, &value));
+    DoNotOptimize(value);
+  }
+}
+
+// Measures reading a few scalar properties through a DOM and through
+// PropertyExtractor, from a photo sphere standard section and from a VR photo
+// extended section whose GImage:Data holds right_embedded.jpg.
+void BM_ExtractProperties() {
+  string standard_xmp;
+  ReadFileToStringOrDie(
+      BenchmarkDataPath("photo_sphere_std_section_data.txt"), &standard_xmp);
+  const std::vector<std::pair<string, string>> gpano_properties = {
+      {"GPano", "CroppedAreaLeftPixels"},
+      {"GPano", "CroppedAreaTopPixels"},
+      {"GPano", "FullPanoWidthPixels"},
+      {"GPano", "ProjectionType"}};
+  RunBenchmarkCase("GPano/Dom", standard_xmp.size(), 0,
+                   [&]() { ReadWithDom(standard_xmp, gpano_properties); });
+  RunBenchmarkCase("GPano/PropertyExtractor", standard_xmp.size(), 0, [&]() {
+    ReadWithExtractor(standard_xmp, gpano_properties);
+  });
+
+  string extended_xmp;
+  ReadFileToStringOrDie(
+      BenchmarkDataPath("vr_photo_with_audio_ext_section_data.txt"),
+      &extended_xmp);
+  string image;
+  ReadFileToStringOrDie(BenchmarkDataPath("right_embedded.jpg"), &image);
+  string image_base64;
+  CHECK(EncodeBase64(image, &image_base64));
+  const string placeholder = "SW1hZ2VEYXRh";
+  const size_t placeholder_position = extended_xmp.find(placeholder);
+  CHECK_NE(string::npos, placeholder_position);
+  extended_xmp.replace(placeholder_position, placeholder.size(), image_base64);
+  const std::vector<std::pair<string, string>> gaudio_properties = {
+      {"GAudio", "Data"}};
+  RunBenchmarkCase("GAudioData/Dom", extended_xmp.size(), 0,
+                   [&]() { ReadWithDom(extended_xmp, gaudio_properties); });
+  RunBenchmarkCase("GAudioData/PropertyExtractor", extended_xmp.size(), 0,
+                   [&]() {
+    ReadWithExtractor(extended_xmp, gaudio_properties);
+  });
+}
+XMPMETA_BENCHMARK(BM_ExtractProperties);
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
@@ -0,0 +1,218 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/property_extractor.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+const char kXml[] =
+    "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+    "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+    "<rdf:Description rdf:about=\"\""
+    " xmlns:GPano=\"http://ns.google.com/photos/1.0/panorama/\""
+    " xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+    " GPano:CroppedAreaLeftPixels=\"12\""
+    " GPano:UsePanoramaViewer=\"True\""
+    " GPano:PoseHeadingDegrees=\"1.5\""
+    " GImage:Data=\"ZGF0YQ==\">"
+    "<GPano:ProjectionType>equirectangular</GPano:ProjectionType>"
+    "<GPano:LargeValue>9876543210</GPano:LargeValue>"
+    "<GPano:Empty/>"
+    "</rdf:Description>"
+    "</rdf:RDF>"
+    "</x:xmpmeta>";
+
+bool Extract(PropertyExtractor* extractor, const string& xml) {
+  return extractor->Extract(xml.data(), xml.size());
+}
+
+TEST(PropertyExtractor, ParsesAttributes) {
+  PropertyExtractor extractor({{"GPano", "CroppedAreaLeftPixels"},
+                               {"GPano", "UsePanoramaViewer"},
+                               {"GPano", "PoseHeadingDegrees"},
+                               {"GImage", "Data"}});
+  ASSERT_TRUE(Extract(&extractor, kXml));
+  EXPECT_TRUE(extractor.AllFound());
+
+  int left = 0;
+  EXPECT_TRUE(extractor.ParseInt("GPano", "CroppedAreaLeftPixels", &left));
+  EXPECT_EQ(12, left);
+  bool use_viewer = false;
+  EXPECT_TRUE(extractor.ParseBoolean("GPano", "UsePanoramaViewer",
+                                     &use_viewer));
+  EXPECT_TRUE(use_viewer);
+  double heading = 0;
+  EXPECT_TRUE(extractor.ParseDouble("GPano", "PoseHeadingDegrees", &heading));
+  EXPECT_EQ(1.5, heading);
+  string data;
+  EXPECT_TRUE(extractor.ParseBase64("GImage", "Data", &data));
+  EXPECT_EQ("data", data);
+}
+
+TEST(PropertyExtractor, ParsesElements) {
+  PropertyExtractor extractor({{"GPano", "ProjectionType"},
+                               {"GPano", "LargeValue"},
+                               {"GPano", "Empty"}});
+  ASSERT_TRUE(Extract(&extractor, kXml));
+  EXPECT_TRUE(extractor.AllFound());
+
+  string projection_type;
+  EXPECT_TRUE(extractor.ParseString("GPano", "ProjectionType",
+                                    &projection_type));
+  EXPECT_EQ("equirectangular", projection_type);
+  int64 large_value = 0;
+  EXPECT_TRUE(extractor.ParseLong("GPano", "LargeValue", &large_value));
+  EXPECT_EQ(9876543210LL, large_value);
+  string empty = "not empty";
+  EXPECT_TRUE(extractor.ParseString("GPano", "Empty", &empty));
+  EXPECT_TRUE(empty.empty());
+}
+
+TEST(PropertyExtractor, ParseStringBorrowsValue) {
+  PropertyExtractor extractor({{"GPano", "ProjectionType"},
+                               {"GPano", "Empty"}});
+  ASSERT_TRUE(Extract(&extractor, kXml));
+
+  PropertyValue value;
+  ASSERT_TRUE(extractor.ParseString("GPano", "ProjectionType", &value));
+  EXPECT_TRUE(value.borrowed());
+  EXPECT_EQ("equirectangular", value.ToString());
+  ASSERT_TRUE(extractor.ParseString("GPano", "Empty", &value));
+  EXPECT_TRUE(value.empty());
+  EXPECT_FALSE(extractor.ParseString("GPano", "Missing", &value));
+}
+
+TEST(PropertyExtractor, MissingProperty) {
+  PropertyExtractor extractor({{"GPano", "CroppedAreaLeftPixels"},
+                               {"GPano", "Missing"},
+                               {"GImage", "CroppedAreaLeftPixels"}});
+  ASSERT_TRUE(Extract(&extractor, kXml));
+  EXPECT_FALSE(extractor.AllFound());
+
+  string value;
+  EXPECT_FALSE(extractor.ParseString("GPano", "Missing", &value));
+  EXPECT_FALSE(extractor.ParseString("GImage", "CroppedAreaLeftPixels",
+                                     &value));
+  // Properties that were not requested are never reported.
+  EXPECT_FALSE(extractor.ParseString("GPano", "ProjectionType", &value));
+}
+
+TEST(PropertyExtractor, EmptyPrefixMatchesAnyPrefix) {
+  PropertyExtractor extractor(
+      std::vector<std::pair<string, string>>{{"", "Data"}});
+  ASSERT_TRUE(Extract(&extractor, kXml));
+  string data;
+  EXPECT_TRUE(extractor.ParseString("", "Data", &data));
+  EXPECT_EQ("ZGF0YQ==", data);
+}
+
+TEST(PropertyExtractor, ReadsAttributesOnlyFromDescription) {
+  const string xml =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\""
+      " xmlns:GPano=\"http://ns.google.com/photos/1.0/panorama/\">"
+      "<GPano:Other GPano:CroppedAreaLeftPixels=\"1\"/>"
+      "<rdf:Description rdf:about=\"\" GPano:CroppedAreaLeftPixels=\"2\"/>"
+      "</rdf:RDF>"
+      "</x:xmpmeta>";
+  PropertyExtractor extractor(std::vector<std::pair<string, string>>{
+      {"GPano", "CroppedAreaLeftPixels"}});
+  ASSERT_TRUE(Extract(&extractor, xml));
+  int left = 0;
+  EXPECT_TRUE(extractor.ParseInt("GPano", "CroppedAreaLeftPixels", &left));
+  EXPECT_EQ(2, left);
+
+  // A Description element outside the RDF namespace is not rdf:Description.
+  PropertyExtractor other_extractor(std::vector<std::pair<string, string>>{
+      {"GPano", "CroppedAreaLeftPixels"}});
+  ASSERT_TRUE(Extract(&other_extractor,
+                      "<GPano:Description"
+                      " xmlns:GPano=\"http://ns.google.com/photos/1.0/panorama/\""
+                      " GPano:CroppedAreaLeftPixels=\"3\"/>"));
+  EXPECT_FALSE(other_extractor.AllFound());
+}
+
+TEST(PropertyExtractor, StopsOnceAllPropertiesAreFound) {
+  // Everything after the requested property is malformed, which would fail
+  // extraction if the reader got that far. The padding keeps the malformed
+  // data out of the chunks that libxml2 parses ahead of the reader.
+  const string xml(kXml);
+  const string truncated = xml.substr(0, xml.find("<GPano:LargeValue>")) +
+                           "<!--" + string(64 * 1024, ' ') + "--><<<";
+
+  PropertyExtractor found(std::vector<std::pair<string, string>>{
+      {"GPano", "ProjectionType"}});
+  ASSERT_TRUE(Extract(&found, truncated));
+  string projection_type;
+  EXPECT_TRUE(found.ParseString("GPano", "ProjectionType", &projection_type));
+  EXPECT_EQ("equirectangular", projection_type);
+
+  PropertyExtractor not_found(std::vector<std::pair<string, string>>{
+      {"GPano", "LargeValue"}});
+  EXPECT_FALSE(Extract(&not_found, truncated));
+}
+
+TEST(PropertyExtractor, ExtractDiscardsPreviousValues) {
+  PropertyExtractor extractor(std::vector<std::pair<string, string>>{
+      {"GPano", "CroppedAreaLeftPixels"}});
+  ASSERT_TRUE(Extract(&extractor, kXml));
+  ASSERT_TRUE(extractor.AllFound());
+
+  ASSERT_TRUE(Extract(&extractor, "<root/>"));
+  EXPECT_FALSE(extractor.AllFound());
+  int left = 0;
+  EXPECT_FALSE(extractor.ParseInt("GPano", "CroppedAreaLeftPixels", &left));
+}
+
+TEST(PropertyExtractor, ExtractsFromPieces) {
+  const string xml(kXml);
+  // Split the document in the middle of names and values.
+  std::vector<std::pair<const char*, size_t>> pieces;
+  for (size_t i = 0; i < xml.size(); i += 7) {
+    pieces.push_back({xml.data() + i, std::min<size_t>(7, xml.size() - i)});
+  }
+  PropertyExtractor extractor({{"GImage", "Data"},
+                               {"GPano", "ProjectionType"}});
+  ASSERT_TRUE(extractor.Extract(pieces));
+  EXPECT_TRUE(extractor.AllFound());
+  string value;
+  EXPECT_TRUE(extractor.ParseBase64("GImage", "Data", &value));
+  EXPECT_EQ("data", value);
+  EXPECT_TRUE(extractor.ParseString("GPano", "ProjectionType", &value));
+  EXPECT_EQ("equirectangular", value);
+}
+
+TEST(PropertyExtractor, UnsupportedOperations) {
+  PropertyExtractor extractor(std::vector<std::pair<string, string>>{
+      {"GPano", "CroppedAreaLeftPixels"}});
+  ASSERT_TRUE(Extract(&extractor, kXml));
+  EXPECT_EQ(nullptr, extractor.CreateDeserializer("GPano", "Child"));
+  EXPECT_EQ(nullptr,
+            extractor.CreateDeserializerFromListElementAt("GPano", "List", 0));
+  std::vector<int> values;
+  EXPECT_FALSE(extractor.ParseIntArray("GPano", "List", &values));
+}
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
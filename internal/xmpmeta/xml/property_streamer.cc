@@ -0,0 +1,440 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/property_streamer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "xmpmeta/xml/const.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+// Longer names are treated as malformed, which bounds the memory used for the
+// names of the open elements.
+const size_t kMaxNameLength = 1024;
+
+// The longest reference, such as &#x10FFFF;, that is decoded.
+const size_t kMaxReferenceLength = 16;
+
+// How much of a CDATA section is buffered before it is passed on.
+const size_t kCdataBufferSize = 4096;
+
+// The result of reading a piece of markup.
+enum Status { kContinue, kFound, kFailed };
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Splits a qualified name into its prefix, which is empty if there is none,
+// and its local name.
+void SplitName(const string& qualified_name, string* prefix, string* name) {
+  const size_t colon = qualified_name.find(':');
+  if (colon == string::npos) {
+    prefix->clear();
+    *name = qualified_name;
+  } else {
+    *prefix = qualified_name.substr(0, colon);
+    *name = qualified_name.substr(colon + 1);
+  }
+}
+
+// Appends the UTF-8 encoding of code_point to output.
+void AppendUtf8(uint32_t code_point, string* output) {
+  if (code_point < 0x80) {
+    output->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    output->push_back(static_cast<char>(0xc0 | (code_point >> 6)));
+    output->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else if (code_point < 0x10000) {
+    output->push_back(static_cast<char>(0xe0 | (code_point >> 12)));
+    output->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    output->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else {
+    output->push_back(static_cast<char>(0xf0 | (code_point >> 18)));
+    output->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3f)));
+    output->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    output->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  }
+}
+
+// Decodes the reference &reference; into text. Returns false if it is neither
+// a character reference nor one of the predefined entities.
+bool DecodeReference(const string& reference, string* text) {
+  text->clear();
+  if (reference.size() > 1 && reference[0] == '#') {
+    const bool hex = reference[1] == 'x';
+    const char* digits = reference.c_str() + (hex ? 2 : 1);
+    char* end = nullptr;
+    const unsigned long code_point = strtoul(digits, &end, hex ? 16 : 10);
+    if (*digits == '\0' || *end != '\0' || code_point == 0 ||
+        code_point > 0x10ffff) {
+      return false;
+    }
+    AppendUtf8(static_cast<uint32_t>(code_point), text);
+  } else if (reference == "amp") {
+    *text = "&";
+  } else if (reference == "lt") {
+    *text = "<";
+  } else if (reference == "gt") {
+    *text = ">";
+  } else if (reference == "quot") {
+    *text = "\"";
+  } else if (reference == "apos") {
+    *text = "'";
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Scans XML split into pieces for the first value of one property.
+class PropertyStreamer {
+ public:
+  PropertyStreamer(const std::vector<std::pair<const char*, size_t>>& pieces,
+                   const string& prefix, const string& name,
+                   const DataSink& sink)
+      : pieces_(pieces),
+        prefix_(prefix),
+        name_(name),
+        sink_(sink),
+        piece_(0),
+        position_(0),
+        value_depth_(0) {}
+
+  // Reads until the value has been passed to the sink. Returns false if it
+  // was not found, the XML is malformed or the sink failed.
+  bool Stream() {
+    char stop;
+    while (ReadUntil(InValue() ? "<&" : "<", InValue(), &stop)) {
+      const Status status =
+          stop == '&' ? (ReadReference(true) ? kContinue : kFailed)
+                      : ReadMarkup();
+      if (status != kContinue) {
+        return status == kFound;
+      }
+    }
+    return false;
+  }
+
+ private:
+  // Returns true while reading the content of the property's element.
+  bool InValue() const { return value_depth_ > 0; }
+
+  // Returns true if the qualified name is that of the property.
+  bool Matches(const string& qualified_name) const {
+    string prefix;
+    string name;
+    SplitName(qualified_name, &prefix, &name);
+    return name == name_ && prefix != "xmlns" &&
+           (prefix_.empty() || prefix == prefix_);
+  }
+
+  // Moves past exhausted pieces. Returns false at the end of the input.
+  bool Fill() {
+    while (piece_ < pieces_.size() && position_ == pieces_[piece_].second) {
+      ++piece_;
+      position_ = 0;
+    }
+    return piece_ < pieces_.size();
+  }
+
+  bool Peek(char* c) {
+    if (!Fill()) {
+      return false;
+    }
+    *c = pieces_[piece_].first[position_];
+    return true;
+  }
+
+  bool Next(char* c) {
+    if (!Peek(c)) {
+      return false;
+    }
+    ++position_;
+    return true;
+  }
+
+  // Returns true if the next characters are literal, consuming them.
+  bool Expect(const char* literal) {
+    char c;
+    for (; *literal != '\0'; ++literal) {
+      if (!Next(&c) || c != *literal) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void SkipSpace() {
+    char c;
+    while (Peek(&c) && IsSpace(c)) {
+      ++position_;
+    }
+  }
+
+  bool Emit(const char* data, size_t size) {
+    return size == 0 || sink_(data, size);
+  }
+
+  // Reads past the first of the characters in stops, which is stored in
+  // stop. If emit is true, passes the characters before it to the sink
+  // without copying them. Returns false at the end of the input or if the
+  // sink fails.
+  bool ReadUntil(const char* stops, bool emit, char* stop) {
+    const char* stops_end = stops + strlen(stops);
+    while (Fill()) {
+      const char* begin = pieces_[piece_].first + position_;
+      const char* end = pieces_[piece_].first + pieces_[piece_].second;
+      const char* found = std::find_first_of(begin, end, stops, stops_end);
+      if (emit && !Emit(begin, found - begin)) {
+        return false;
+      }
+      position_ += found - begin;
+      if (found != end) {
+        *stop = *found;
+        ++position_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Reads past terminator, such as "-->". If emit is true, passes the
+  // characters before it to the sink.
+  bool ReadPast(const string& terminator, bool emit) {
+    // Holds the characters read that are not yet passed on, which always
+    // include the last terminator.size() - 1 of them.
+    string pending;
+    char c;
+    while (Next(&c)) {
+      pending.push_back(c);
+      if (pending.size() >= terminator.size() &&
+          pending.compare(pending.size() - terminator.size(),
+                          terminator.size(), terminator) == 0) {
+        return !emit ||
+               Emit(pending.data(), pending.size() - terminator.size());
+      }
+      if (pending.size() == kCdataBufferSize) {
+        const size_t kept = terminator.size() - 1;
+        if (emit && !Emit(pending.data(), pending.size() - kept)) {
+          return false;
+        }
+        pending.erase(0, pending.size() - kept);
+      }
+    }
+    return false;
+  }
+
+  // Reads a name that starts with first.
+  bool ReadName(char first, string* name) {
+    if (IsSpace(first) || strchr("=/>'\"<", first) != nullptr) {
+      return false;
+    }
+    name->assign(1, first);
+    char c;
+    while (Peek(&c) && !IsSpace(c) && strchr("=/>'\"<", c) == nullptr) {
+      if (name->size() == kMaxNameLength) {
+        return false;
+      }
+      name->push_back(c);
+      ++position_;
+    }
+    return true;
+  }
+
+  // Reads a reference after its '&', passing the decoded text to the sink if
+  // emit is true.
+  bool ReadReference(bool emit) {
+    string reference;
+    char c = '\0';
+    while (Next(&c) && c != ';') {
+      if (reference.size() == kMaxReferenceLength) {
+        return false;
+      }
+      reference.push_back(c);
+    }
+    string text;
+    if (c != ';' || !DecodeReference(reference, &text)) {
+      return false;
+    }
+    return !emit || Emit(text.data(), text.size());
+  }
+
+  // Reads an attribute value after its opening quote, passing it to the sink
+  // if emit is true.
+  bool ReadAttributeValue(char quote, bool emit) {
+    const char stops[] = {quote, '&', '\0'};
+    char stop;
+    while (ReadUntil(stops, emit, &stop)) {
+      if (stop == quote) {
+        return true;
+      }
+      if (!ReadReference(emit)) {
+        return false;
+      }
+    }
+    return false;
+  }
+
+  // Reads the markup after a '<'.
+  Status ReadMarkup() {
+    char c;
+    if (!Next(&c)) {
+      return kFailed;
+    }
+    switch (c) {
+      case '!':
+        return ReadDeclaration();
+      case '?':
+        return ReadPast("?>", false) ? kContinue : kFailed;
+      case '/':
+        return ReadEndTag();
+      default:
+        return ReadStartTag(c);
+    }
+  }
+
+  // Reads a comment, CDATA section or document type declaration after its
+  // "<!".
+  Status ReadDeclaration() {
+    char c;
+    if (!Peek(&c)) {
+      return kFailed;
+    }
+    if (c == '-') {
+      return Expect("--") && ReadPast("-->", false) ? kContinue : kFailed;
+    }
+    if (c == '[') {
+      return Expect("[CDATA[") && ReadPast("]]>", InValue()) ? kContinue
+                                                             : kFailed;
+    }
+    // The internal subset of a document type declaration may contain '>'.
+    int brackets = 0;
+    while (Next(&c)) {
+      if (c == '[') {
+        ++brackets;
+      } else if (c == ']') {
+        --brackets;
+      } else if (c == '>' && brackets == 0) {
+        return kContinue;
+      }
+    }
+    return kFailed;
+  }
+
+  // Reads an end tag after its "</".
+  Status ReadEndTag() {
+    string element;
+    char c;
+    if (!Next(&c) || !ReadName(c, &element)) {
+      return kFailed;
+    }
+    SkipSpace();
+    if (!Next(&c) || c != '>' || open_elements_.empty() ||
+        open_elements_.back() != element) {
+      return kFailed;
+    }
+    open_elements_.pop_back();
+    return InValue() && open_elements_.size() < value_depth_ ? kFound
+                                                              : kContinue;
+  }
+
+  // Reads a start tag whose name starts with first, after its '<'.
+  Status ReadStartTag(char first) {
+    string element;
+    if (!ReadName(first, &element)) {
+      return kFailed;
+    }
+    string element_prefix;
+    string element_name;
+    SplitName(element, &element_prefix, &element_name);
+    const bool is_description = element_name == XmlConst::RdfDescription();
+
+    char c;
+    while (true) {
+      SkipSpace();
+      if (!Next(&c)) {
+        return kFailed;
+      }
+      if (c == '>' || c == '/') {
+        break;
+      }
+      string attribute;
+      if (!ReadName(c, &attribute)) {
+        return kFailed;
+      }
+      SkipSpace();
+      if (!Next(&c) || c != '=') {
+        return kFailed;
+      }
+      SkipSpace();
+      char quote;
+      if (!Next(&quote) || (quote != '"' && quote != '\'')) {
+        return kFailed;
+      }
+      const bool wanted = !InValue() && is_description && Matches(attribute);
+      if (!ReadAttributeValue(quote, wanted)) {
+        return kFailed;
+      }
+      if (wanted) {
+        return kFound;
+      }
+    }
+
+    const bool empty = c == '/';
+    if (empty && (!Next(&c) || c != '>')) {
+      return kFailed;
+    }
+    const bool wanted = !InValue() && Matches(element);
+    if (empty) {
+      return wanted ? kFound : kContinue;
+    }
+    open_elements_.push_back(element);
+    if (wanted) {
+      value_depth_ = open_elements_.size();
+    }
+    return kContinue;
+  }
+
+  const std::vector<std::pair<const char*, size_t>>& pieces_;
+  const string prefix_;
+  const string name_;
+  const DataSink& sink_;
+  // The read position.
+  size_t piece_;
+  size_t position_;
+  // The qualified names of the elements enclosing the read position.
+  std::vector<string> open_elements_;
+  // The number of open elements up to and including the property's element
+  // while reading its content, and zero otherwise.
+  size_t value_depth_;
+};
+
+}  // namespace
+
+bool StreamPropertyValue(
+    const std::vector<std::pair<const char*, size_t>>& pieces,
+    const string& prefix, const string& name, const DataSink& sink) {
+  PropertyStreamer streamer(pieces, prefix, name, sink);
+  return streamer.Stream();
+}
+
+}  // namespace xml
+}  // namespace xmpmeta
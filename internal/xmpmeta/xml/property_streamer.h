@@ -0,0 +1,54 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_PROPERTY_STREAMER_H_
+#define XMPMETA_XML_PROPERTY_STREAMER_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/port.h"
+#include "xmpmeta/base64.h"
+
+namespace xmpmeta {
+namespace xml {
+
+// Passes the value of the first property prefix:name in serialized XML to sink
+// in pieces, as it is read, without building a DOM or holding the value in
+// memory. Unlike PropertyExtractor, whose xmlTextReader materializes every
+// attribute value, this scans the XML itself, so it suits multi-megabyte
+// values such as GImage:Data.
+// The XML is given as consecutive pieces, such as the chunks of an extended
+// XMP section, which are read in order without being joined. Spans of the
+// value that lie within one piece are passed to sink without being copied.
+// The property may be an attribute of an rdf:Description element or an
+// element, whose text content is passed on with any CDATA sections. As with
+// GetFirstDescriptionElement, rdf:Description is matched by its local name,
+// and as with PropertyExtractor, an empty prefix matches any prefix.
+// This is a minimal scanner, not a validating parser: it skips comments,
+// processing instructions and document type declarations, checks that tags
+// nest, decodes character references and the predefined entities, and stops
+// reading as soon as the value has been passed on.
+// Returns false if the property is not found, if the XML is malformed before
+// its value ends, or if sink fails. Some data may have been passed to sink by
+// then.
+bool StreamPropertyValue(
+    const std::vector<std::pair<const char*, size_t>>& pieces,
+    const string& prefix, const string& name, const DataSink& sink);
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_PROPERTY_STREAMER_H_
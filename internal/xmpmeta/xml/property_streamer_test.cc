@@ -0,0 +1,161 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/property_streamer.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+const char kXml[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+    "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+    "<!-- <GAudio:Data>comment</GAudio:Data> GImage:Data=\"comment\" -->"
+    "<rdf:Description rdf:about=\"\""
+    " xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+    " xmlns:GAudio=\"http://ns.google.com/photos/1.0/audio/\""
+    " GImage:Mime='a/> GImage:Data=\"mime\"'"
+    " GImage:Data = \"image&#10;data&amp;\">"
+    "<GAudio:Mime GAudio:Data=\"not a description\">audio/mp4</GAudio:Mime>"
+    "<GAudio:Data>audio <![CDATA[<data>]]> &lt;&#x41;&gt;</GAudio:Data>"
+    "</rdf:Description>"
+    "</rdf:RDF>"
+    "</x:xmpmeta>";
+
+// Streams the property from pieces of xml of at most piece_size bytes.
+bool Stream(const string& xml, size_t piece_size, const string& prefix,
+            const string& name, string* value,
+            std::vector<size_t>* sink_sizes = nullptr) {
+  std::vector<std::pair<const char*, size_t>> pieces;
+  for (size_t start = 0; start < xml.size(); start += piece_size) {
+    pieces.push_back(
+        {xml.data() + start, std::min(piece_size, xml.size() - start)});
+  }
+  value->clear();
+  return StreamPropertyValue(
+      pieces, prefix, name, [value, sink_sizes](const char* data, size_t size) {
+        value->append(data, size);
+        if (sink_sizes != nullptr) {
+          sink_sizes->push_back(size);
+        }
+        return true;
+      });
+}
+
+TEST(PropertyStreamer, StreamsAttribute) {
+  string value;
+  ASSERT_TRUE(Stream(kXml, sizeof(kXml), "GImage", "Data", &value));
+  EXPECT_EQ("image\ndata&", value);
+  ASSERT_TRUE(Stream(kXml, sizeof(kXml), "GImage", "Mime", &value));
+  EXPECT_EQ("a/> GImage:Data=\"mime\"", value);
+}
+
+TEST(PropertyStreamer, StreamsElement) {
+  string value;
+  ASSERT_TRUE(Stream(kXml, sizeof(kXml), "GAudio", "Data", &value));
+  EXPECT_EQ("audio <data> <A>", value);
+  ASSERT_TRUE(Stream(kXml, sizeof(kXml), "GAudio", "Mime", &value));
+  EXPECT_EQ("audio/mp4", value);
+}
+
+TEST(PropertyStreamer, StreamsFromPiecesOfAnySize) {
+  for (size_t piece_size = 1; piece_size <= 16; ++piece_size) {
+    string value;
+    ASSERT_TRUE(Stream(kXml, piece_size, "GImage", "Data", &value));
+    EXPECT_EQ("image\ndata&", value);
+    ASSERT_TRUE(Stream(kXml, piece_size, "GAudio", "Data", &value));
+    EXPECT_EQ("audio <data> <A>", value);
+  }
+}
+
+TEST(PropertyStreamer, PassesValueInPieces) {
+  const string data(100000, 'x');
+  const string xml = "<rdf:Description GImage:Data=\"" + data + "\"/>";
+  string value;
+  std::vector<size_t> sink_sizes;
+  ASSERT_TRUE(Stream(xml, 4096, "GImage", "Data", &value, &sink_sizes));
+  EXPECT_EQ(data, value);
+  // The value is passed on as it is read, one piece at a time.
+  for (size_t size : sink_sizes) {
+    EXPECT_LE(size, 4096);
+  }
+}
+
+TEST(PropertyStreamer, EmptyPrefixMatchesAnyPrefix) {
+  string value;
+  ASSERT_TRUE(Stream(kXml, sizeof(kXml), "", "Data", &value));
+  EXPECT_EQ("image\ndata&", value);
+}
+
+TEST(PropertyStreamer, ReadsAttributesOnlyFromDescription) {
+  string value;
+  EXPECT_FALSE(Stream("<a><b GImage:Data=\"x\"/></a>", 64, "GImage", "Data",
+                      &value));
+  EXPECT_TRUE(value.empty());
+}
+
+TEST(PropertyStreamer, EmptyElement) {
+  string value = "unchanged";
+  EXPECT_TRUE(Stream("<a><GImage:Data/></a>", 64, "GImage", "Data", &value));
+  EXPECT_TRUE(value.empty());
+}
+
+TEST(PropertyStreamer, MissingProperty) {
+  string value;
+  EXPECT_FALSE(Stream(kXml, sizeof(kXml), "GImage", "Other", &value));
+  EXPECT_TRUE(value.empty());
+  EXPECT_FALSE(Stream(kXml, sizeof(kXml), "GDepth", "Data", &value));
+}
+
+TEST(PropertyStreamer, MalformedXml) {
+  string value;
+  // Mismatched tags.
+  EXPECT_FALSE(Stream("<a><b></a><GImage:Data>x</GImage:Data>", 64, "GImage",
+                      "Data", &value));
+  // Unknown entity.
+  EXPECT_FALSE(Stream("<GImage:Data>&unknown;</GImage:Data>", 64, "GImage",
+                      "Data", &value));
+  // Unterminated attribute value and element.
+  EXPECT_FALSE(Stream("<rdf:Description GImage:Data=\"x", 64, "GImage",
+                      "Data", &value));
+  EXPECT_FALSE(Stream("<a><GImage:Data>x", 64, "GImage", "Data", &value));
+  // Unquoted attribute value.
+  EXPECT_FALSE(Stream("<rdf:Description GImage:Data=x/>", 64, "GImage",
+                      "Data", &value));
+}
+
+TEST(PropertyStreamer, StopsWhenSinkFails) {
+  const string xml =
+      "<rdf:Description GImage:Data=\"" + string(100, 'x') + "\"/>";
+  const std::vector<std::pair<const char*, size_t>> pieces = {
+      {xml.data(), 40}, {xml.data() + 40, xml.size() - 40}};
+  int calls = 0;
+  EXPECT_FALSE(StreamPropertyValue(pieces, "GImage", "Data",
+                                   [&calls](const char* data, size_t size) {
+                                     ++calls;
+                                     return false;
+                                   }));
+  EXPECT_EQ(1, calls);
+}
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
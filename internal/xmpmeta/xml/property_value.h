@@ -0,0 +1,94 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_PROPERTY_VALUE_H_
+#define XMPMETA_XML_PROPERTY_VALUE_H_
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/port.h"
+
+namespace xmpmeta {
+namespace xml {
+
+// The text of a property, as read by a Deserializer. The text is borrowed
+// from wherever the deserializer holds it when that is possible, e.g. from the
+// XML document of an XmpData when the value is one text node. A borrowed value
+// is only valid while its source is alive and unmodified, unless the value
+// shares ownership of the source. Otherwise, the value owns a copy of the
+// text. Either way, the text is followed by a null
+// character, which is not included in size().
+class PropertyValue {
+ public:
+  PropertyValue() : borrowed_(nullptr), size_(0) {}
+
+  // Borrows the null-terminated text of the given size.
+  void Borrow(const char* data, size_t size) {
+    owned_.clear();
+    borrowed_ = data;
+    size_ = size;
+    source_.reset();
+  }
+
+  // Shares ownership of the source of borrowed text, which keeps the text
+  // valid as long as this value, as long as the source is not modified.
+  void ShareSource(const std::shared_ptr<const void>& source) {
+    source_ = source;
+  }
+
+  // Takes a copy of the text.
+  void Own(string text) {
+    owned_ = std::move(text);
+    borrowed_ = nullptr;
+    size_ = owned_.size();
+    source_.reset();
+  }
+
+  // Returns true if the text is borrowed.
+  bool borrowed() const { return borrowed_ != nullptr; }
+
+  // Returns true if the text stays valid as long as this value, i.e. it is
+  // owned, or borrowed from a source that this value shares.
+  bool self_contained() const {
+    return borrowed_ == nullptr || source_ != nullptr;
+  }
+
+  const char* data() const {
+    return borrowed_ != nullptr ? borrowed_ : owned_.c_str();
+  }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Returns a copy of the text.
+  string ToString() const { return string(data(), size_); }
+
+  bool operator==(const char* text) const {
+    return strlen(text) == size_ && memcmp(data(), text, size_) == 0;
+  }
+  bool operator!=(const char* text) const { return !(*this == text); }
+
+ private:
+  const char* borrowed_;
+  size_t size_;
+  string owned_;
+  std::shared_ptr<const void> source_;
+};
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_PROPERTY_VALUE_H_
@@ -0,0 +1,449 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/streaming_serializer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "glog/logging.h"
+#include "strings/numbers.h"
+#include "xmpmeta/xmp_const.h"
+#include "xmpmeta/xml/const.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+// libxml indents each level of a formatted document by two spaces, up to 30
+// levels.
+const size_t kIndentSize = 2;
+const size_t kMaxIndentLevel = 30;
+
+void AppendIndent(size_t level, string* output) {
+  output->append(kIndentSize * std::min(level, kMaxIndentLevel), ' ');
+}
+
+void AppendQualifiedName(const string& prefix, const string& name,
+                         string* output) {
+  if (!prefix.empty()) {
+    output->append(prefix);
+    output->push_back(':');
+  }
+  output->append(name);
+}
+
+// Appends value as an attribute value, escaped as libxml escapes it in a UTF-8
+// document.
+void AppendEscapedAttribute(const string& value, string* output) {
+  size_t start = 0;
+  for (size_t i = 0; i < value.size(); ++i) {
+    const char* escaped;
+    switch (value[i]) {
+      case '<': escaped = "&lt;"; break;
+      case '>': escaped = "&gt;"; break;
+      case '&': escaped = "&amp;"; break;
+      case '"': escaped = "&quot;"; break;
+      case '\n': escaped = "&#10;"; break;
+      case '\r': escaped = "&#13;"; break;
+      case '\t': escaped = "&#9;"; break;
+      default: continue;
+    }
+    output->append(value, start, i - start);
+    output->append(escaped);
+    start = i + 1;
+  }
+  output->append(value, start, string::npos);
+}
+
+}  // namespace
+
+// The state shared by a serializer and all the serializers created from it:
+// the output, and the stack of nodes that have been started but not ended.
+// The first three nodes are x:xmpmeta, rdf:RDF and rdf:Description, so a
+// node's depth in the stack is also its level in the document.
+class StreamingSerializer::Writer {
+ public:
+  Writer(const std::unordered_map<string, string>& namespaces, string* output)
+      : namespaces_(namespaces), output_(output), next_id_(0),
+        about_written_(false), finished_(false) {}
+
+  bool HasNamespace(const string& prefix) const {
+    return namespaces_.count(prefix) > 0;
+  }
+
+  bool finished() const { return finished_; }
+
+  // Returns true if the node at depth is open and has the given id.
+  bool IsOpen(size_t depth, int id) const {
+    return depth < nodes_.size() && nodes_[depth].id == id;
+  }
+
+  bool IsSeq(size_t depth) const { return nodes_[depth].is_seq; }
+  bool HasChildren(size_t depth) const { return nodes_[depth].has_children; }
+
+  // Writes the start of a node, whose attributes may follow. Returns the id
+  // of the node.
+  int StartNode(const string& prefix, const string& name, bool is_seq) {
+    StartChild();
+    AppendIndent(nodes_.size(), output_);
+    output_->push_back('<');
+    const size_t name_start = output_->size();
+    AppendQualifiedName(prefix, name, output_);
+    nodes_.push_back(Node());
+    Node* node = &nodes_.back();
+    node->name.assign(*output_, name_start, string::npos);
+    node->is_seq = is_seq;
+    node->has_children = false;
+    node->id = next_id_++;
+    return node->id;
+  }
+
+  // Ends the node at depth and the nodes deeper than it.
+  void EndNodesFrom(size_t depth) {
+    while (nodes_.size() > depth) {
+      const Node& node = nodes_.back();
+      if (node.has_children) {
+        AppendIndent(nodes_.size() - 1, output_);
+        output_->append("</");
+        output_->append(node.name);
+        output_->append(">\n");
+      } else {
+        output_->append("/>\n");
+      }
+      nodes_.pop_back();
+    }
+  }
+
+  // Declares a namespace after those given to the constructor.
+  void AddNamespace(const string& prefix, const string& href) {
+    namespaces_.emplace(prefix, href);
+    WriteNamespace(prefix, href);
+  }
+
+  void WriteNamespace(const string& prefix, const string& href) {
+    output_->append(" xmlns:");
+    output_->append(prefix);
+    output_->append("=\"");
+    output_->append(href);
+    output_->push_back('"');
+  }
+
+  // Writes the rdf:about attribute of rdf:Description, which follows the
+  // namespace declarations, unless it has already been written.
+  void WriteAbout() {
+    if (about_written_) {
+      return;
+    }
+    WriteAttribute(XmlConst::RdfPrefix(), XmlConst::RdfAbout(), "");
+    about_written_ = true;
+  }
+
+  bool about_written() const { return about_written_; }
+
+  void WriteAttribute(const string& prefix, const string& name,
+                      const string& value) {
+    output_->push_back(' ');
+    AppendQualifiedName(prefix, name, output_);
+    output_->append("=\"");
+    AppendEscapedAttribute(value, output_);
+    output_->push_back('"');
+  }
+
+  // Writes <prefix:array_name><rdf:Seq> with one rdf:li node for each value.
+  template <typename T, typename Formatter>
+  void WriteArray(const string& prefix, const string& array_name,
+                  const std::vector<T>& values, Formatter format) {
+    const size_t depth = nodes_.size();
+    StartNode(prefix, array_name, false);
+    StartNode(XmlConst::RdfPrefix(), XmlConst::RdfSeq(), true);
+    StartChild();
+    string li_name;
+    AppendQualifiedName(XmlConst::RdfPrefix(), XmlConst::RdfLi(), &li_name);
+    for (const T& value : values) {
+      AppendIndent(depth + 2, output_);
+      output_->push_back('<');
+      output_->append(li_name);
+      output_->push_back('>');
+      output_->append(format(value));
+      output_->append("</");
+      output_->append(li_name);
+      output_->append(">\n");
+    }
+    EndNodesFrom(depth);
+  }
+
+  // Ends all the open nodes.
+  void Finish() {
+    WriteAbout();
+    EndNodesFrom(0);
+    finished_ = true;
+  }
+
+  // Writes the start of the root nodes, up to the namespaces of
+  // rdf:Description.
+  void Start() {
+    // x:xmpmeta.
+    output_->append("\n");
+    StartNode(XmpConst::NamespacePrefix(), XmpConst::NodeName(), false);
+    WriteNamespace(XmpConst::NamespacePrefix(), XmpConst::Namespace());
+    WriteAttribute(XmpConst::NamespacePrefix(), XmpConst::AdobePropName(),
+                   XmpConst::AdobePropValue());
+
+    // rdf:RDF.
+    StartNode(XmlConst::RdfPrefix(), XmlConst::RdfNodeName(), false);
+    WriteNamespace(XmlConst::RdfPrefix(), XmlConst::RdfNodeNs());
+
+    // rdf:Description.
+    StartNode(XmlConst::RdfPrefix(), XmlConst::RdfDescription(), false);
+    for (const auto& entry : namespaces_) {
+      if (!entry.second.empty()) {
+        WriteNamespace(entry.first, entry.second);
+      }
+    }
+  }
+
+ private:
+  struct Node {
+    string name;
+    bool is_seq;
+    bool has_children;
+    int id;
+  };
+
+  // Ends the start tag of the deepest open node, if it is not already ended,
+  // so that a child node can follow.
+  void StartChild() {
+    if (nodes_.empty() || nodes_.back().has_children) {
+      return;
+    }
+    output_->append(">\n");
+    nodes_.back().has_children = true;
+  }
+
+  std::unordered_map<string, string> namespaces_;
+  string* output_;
+  std::vector<Node> nodes_;
+  int next_id_;
+  bool about_written_;
+  bool finished_;
+};
+
+StreamingSerializer::StreamingSerializer(const std::shared_ptr<Writer>& writer,
+                                         size_t depth, int id)
+    : writer_(writer), depth_(depth), id_(id) {}
+
+std::unique_ptr<StreamingSerializer> StreamingSerializer::FromNamespaces(
+    const std::unordered_map<string, string>& namespaces, string* output) {
+  CHECK(output != nullptr) << "Output cannot be null";
+  std::shared_ptr<Writer> writer(new Writer(namespaces, output));
+  writer->Start();
+  // The rdf:Description node is the third node started.
+  const size_t kDescriptionDepth = 2;
+  return std::unique_ptr<StreamingSerializer>(
+      new StreamingSerializer(writer, kDescriptionDepth, kDescriptionDepth));
+}
+
+bool StreamingSerializer::Resume() const {
+  if (writer_->finished()) {
+    LOG(ERROR) << "The XMP packet is already finished";
+    return false;
+  }
+  if (!writer_->IsOpen(depth_, id_)) {
+    LOG(ERROR) << "Cannot write to a node after a node that follows it";
+    return false;
+  }
+  writer_->WriteAbout();
+  writer_->EndNodesFrom(depth_ + 1);
+  return true;
+}
+
+bool StreamingSerializer::HasPrefix(const string& prefix) const {
+  if (!prefix.empty() && !writer_->HasNamespace(prefix)) {
+    LOG(ERROR) << "No namespace found for " << prefix;
+    return false;
+  }
+  return true;
+}
+
+bool StreamingSerializer::AddNamespace(const string& prefix,
+                                       const string& href) {
+  if (writer_->finished() || writer_->about_written() ||
+      !writer_->IsOpen(depth_, id_)) {
+    LOG(ERROR) << "Namespaces can only be added before anything is written";
+    return false;
+  }
+  writer_->AddNamespace(prefix, href);
+  return true;
+}
+
+bool StreamingSerializer::Finish() {
+  if (writer_->finished()) {
+    LOG(ERROR) << "The XMP packet is already finished";
+    return false;
+  }
+  writer_->Finish();
+  return true;
+}
+
+// Implemented methods.
+std::unique_ptr<Serializer>
+StreamingSerializer::CreateSerializer(const string& node_ns_name,
+                                      const string& node_name) const {
+  if (node_name.empty()) {
+    LOG(ERROR) << "Node name is empty";
+    return nullptr;
+  }
+  if (!node_ns_name.empty() && !writer_->HasNamespace(node_ns_name)) {
+    LOG(ERROR) << "Prefix " << node_ns_name << " not found in prefix list";
+    return nullptr;
+  }
+  if (!Resume()) {
+    return nullptr;
+  }
+
+  const int id = writer_->StartNode(node_ns_name, node_name, false);
+  return std::unique_ptr<Serializer>(
+      new StreamingSerializer(writer_, depth_ + 1, id));
+}
+
+std::unique_ptr<Serializer>
+StreamingSerializer::CreateItemSerializer(const string& prefix,
+                                          const string& item_name) const {
+  if (!writer_->HasNamespace(XmlConst::RdfPrefix())) {
+    LOG(ERROR) << "No RDF prefix namespace found";
+    return nullptr;
+  }
+  if (!HasPrefix(prefix) || !Resume()) {
+    return nullptr;
+  }
+  if (!writer_->IsSeq(depth_)) {
+    LOG(ERROR) << "No rdf:Seq node for serializing this item";
+    return nullptr;
+  }
+
+  writer_->StartNode(XmlConst::RdfPrefix(), XmlConst::RdfLi(), false);
+  const int id = writer_->StartNode(prefix, item_name, false);
+  return std::unique_ptr<Serializer>(
+      new StreamingSerializer(writer_, depth_ + 2, id));
+}
+
+std::unique_ptr<Serializer>
+StreamingSerializer::CreateListSerializer(const string& prefix,
+                                          const string& list_name) const {
+  if (!writer_->HasNamespace(XmlConst::RdfPrefix())) {
+    LOG(ERROR) << "No RDF prefix namespace found";
+    return nullptr;
+  }
+  if (!HasPrefix(prefix) || !Resume()) {
+    return nullptr;
+  }
+
+  writer_->StartNode(prefix, list_name, false);
+  const int id =
+      writer_->StartNode(XmlConst::RdfPrefix(), XmlConst::RdfSeq(), true);
+  return std::unique_ptr<Serializer>(
+      new StreamingSerializer(writer_, depth_ + 2, id));
+}
+
+bool StreamingSerializer::WriteBoolProperty(const string& prefix,
+                                            const string& name,
+                                            bool value) const {
+  const string& bool_str = (value ? "true" : "false");
+  return WriteProperty(prefix, name, bool_str);
+}
+
+bool StreamingSerializer::WriteProperty(const string& prefix,
+                                        const string& name,
+                                        const string& value) const {
+  if (!Resume()) {
+    return false;
+  }
+  if (writer_->IsSeq(depth_)) {
+    LOG(ERROR) << "Cannot write a property on an rdf:Seq node";
+    return false;
+  }
+  if (name.empty()) {
+    LOG(ERROR) << "Property name is empty";
+    return false;
+  }
+  if (!prefix.empty() && !writer_->HasNamespace(prefix)) {
+    LOG(ERROR) << "No namespace found for prefix " << prefix;
+    return false;
+  }
+  if (writer_->HasChildren(depth_)) {
+    LOG(ERROR) << "Cannot write property " << name << " after child nodes";
+    return false;
+  }
+
+  // Serialize the property in the format Prefix:Name="Value".
+  writer_->WriteAttribute(prefix, name, value);
+  return true;
+}
+
+bool StreamingSerializer::CanWriteArray(const string& prefix,
+                                        const string& array_name,
+                                        bool empty) const {
+  if (!Resume()) {
+    return false;
+  }
+  if (writer_->IsSeq(depth_)) {
+    LOG(ERROR) << "Cannot write a property on an rdf:Seq node";
+    return false;
+  }
+  if (empty) {
+    LOG(WARNING) << "No values to write";
+    return false;
+  }
+  if (!writer_->HasNamespace(XmlConst::RdfPrefix())) {
+    LOG(ERROR) << "No RDF prefix found";
+    return false;
+  }
+  if (!HasPrefix(prefix)) {
+    return false;
+  }
+  if (array_name.empty()) {
+    LOG(ERROR) << "Parent name cannot be empty";
+    return false;
+  }
+  return true;
+}
+
+bool StreamingSerializer::WriteIntArray(const string& prefix,
+                                        const string& array_name,
+                                        const std::vector<int>& values) const {
+  if (!CanWriteArray(prefix, array_name, values.empty())) {
+    return false;
+  }
+  writer_->WriteArray(prefix, array_name, values,
+                      [](int value) { return std::to_string(value); });
+  return true;
+}
+
+bool StreamingSerializer::WriteDoubleArray(
+    const string& prefix, const string& array_name,
+    const std::vector<double>& values) const {
+  if (!CanWriteArray(prefix, array_name, values.empty())) {
+    return false;
+  }
+  // Written as floats, like SerializerImpl does.
+  writer_->WriteArray(prefix, array_name, values,
+                      [](double value) {
+                        return SimpleFtoa(static_cast<float>(value));
+                      });
+  return true;
+}
+
+}  // namespace xml
+}  // namespace xmpmeta
@@ -0,0 +1,133 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_STREAMING_SERIALIZER_H_
+#define XMPMETA_XML_STREAMING_SERIALIZER_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/port.h"
+#include "xmpmeta/xml/serializer.h"
+
+namespace xmpmeta {
+namespace xml {
+
+// Writes properties, lists, and child nodes as XMP text, without building an
+// XML document. The text is appended to an output string as it is produced,
+// and is the same as what SerializerImpl writes to the document of an XmpData
+// once that document is serialized for an XMP section.
+//
+// Since nothing is buffered, the calls must come in document order:
+//  - The properties of a node must be written before its child nodes.
+//  - Creating a node, or writing to its parent, ends every node created before
+//    it under that parent. Ended nodes cannot be written to.
+// Every Serializer implementation in this library already writes its objects
+// in this order. Calls that break it fail and log an error.
+//
+// Usage example:
+//  string xmp;
+//  std::unique_ptr<StreamingSerializer> serializer =
+//      StreamingSerializer::FromNamespaces(namespaces, &xmp);
+//  gpano.Serialize(serializer.get());
+//  serializer->Finish();
+//  // xmp now holds the XMP packet, ready to be written to an XMP section.
+class StreamingSerializer : public Serializer {
+ public:
+  // Starts an XMP packet in output. The returned serializer writes into the
+  // packet's rdf:Description node, which declares the given namespaces.
+  // The namespaces parameter is a map of prefixes to namespace hrefs, and is
+  // used the same way as in SerializerImpl. Namespaces with an empty href are
+  // not declared.
+  static std::unique_ptr<StreamingSerializer> FromNamespaces(
+      const std::unordered_map<string, string>& namespaces, string* output);
+
+  // Returns a new Serializer for an object that is part of an rdf:Seq list
+  // of objects. The parent serializer must be created with
+  // CreateListSerializer.
+  std::unique_ptr<Serializer>
+      CreateItemSerializer(const string& prefix,
+                           const string& item_name) const override;
+
+  // Returns a new Serializer for a list of objects that correspond to an
+  // rdf:Seq XML node, which is the child of a new node named list_name.
+  std::unique_ptr<Serializer>
+      CreateListSerializer(const string& prefix,
+                           const string& list_name) const override;
+
+  // Returns a new Serializer for a child node of the current node.
+  std::unique_ptr<Serializer>
+      CreateSerializer(const string& node_ns_name,
+                       const string& node_name) const override;
+
+  // Writes the property into the current node, which must not have any child
+  // nodes yet. The rules for prefix, name and value are those of
+  // SerializerImpl.
+  bool WriteBoolProperty(const string& prefix, const string& name,
+                         bool value) const override;
+  bool WriteProperty(const string& prefix, const string& name,
+                     const string& value) const override;
+
+  // Writes the collection of numbers into a child rdf:Seq node.
+  bool WriteIntArray(const string& prefix, const string& array_name,
+                     const std::vector<int>& values) const override;
+  bool WriteDoubleArray(const string& prefix, const string& array_name,
+                        const std::vector<double>& values) const override;
+
+  // Class-specific methods.
+  // Declares one more namespace on the rdf:Description node, after those
+  // given to FromNamespaces. This must be called on the serializer returned
+  // by FromNamespaces, before anything is written with it.
+  bool AddNamespace(const string& prefix, const string& href);
+
+  // Ends all open nodes and the XMP packet. Nothing can be written with this
+  // serializer, or any serializer created from it, afterwards.
+  // Returns false if the packet was already finished.
+  bool Finish();
+
+  // Disallow copying.
+  StreamingSerializer(const StreamingSerializer&) = delete;
+  void operator=(const StreamingSerializer&) = delete;
+
+ private:
+  class Writer;
+
+  // Creates a serializer for the node at the given depth of the writer's
+  // stack of open nodes. id identifies that node.
+  StreamingSerializer(const std::shared_ptr<Writer>& writer, size_t depth,
+                      int id);
+
+  // Ends the open nodes below this serializer's node. Returns false if this
+  // serializer's node has already been ended.
+  bool Resume() const;
+
+  // Returns true if prefix is empty or has a namespace.
+  bool HasPrefix(const string& prefix) const;
+
+  // Returns true if an array can be written into the current node, as
+  // SerializerImpl checks it.
+  bool CanWriteArray(const string& prefix, const string& array_name,
+                     bool empty) const;
+
+  std::shared_ptr<Writer> writer_;
+  const size_t depth_;
+  const int id_;
+};
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_STREAMING_SERIALIZER_H_
@@ -0,0 +1,212 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/streaming_serializer.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <libxml/tree.h>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/xmp_writer.h"
+#include "xmpmeta/xml/const.h"
+#include "xmpmeta/xml/serializer_impl.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+const char kXmlDeclaration[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+
+// Prefixes and hrefs of the namespaces used in these tests.
+const char* const kNamespaces[][2] = {
+  {"rdf", "http://www.w3.org/1999/02/22-rdf-syntax-ns#"},
+  {"Device", "http://ns.xdm.org/photos/1.0/device/"},
+  {"Camera", "http://ns.xdm.org/photos/1.0/camera/"},
+  {"Profile", "http://ns.xdm.org/photos/1.0/profile/"},
+  {"Empty", ""},
+};
+
+std::unordered_map<string, string> CreateNamespaces() {
+  std::unordered_map<string, string> namespaces;
+  for (const auto& entry : kNamespaces) {
+    namespaces.emplace(entry[0], entry[1]);
+  }
+  return namespaces;
+}
+
+// Creates the same namespaces as CreateNamespaces, in the same order, as
+// SerializerImpl takes them.
+std::unordered_map<string, xmlNsPtr> CreateXmlNamespaces() {
+  std::unordered_map<string, xmlNsPtr> namespaces;
+  for (const auto& entry : kNamespaces) {
+    if (*entry[1] != '\0') {
+      namespaces.emplace(entry[0], xmlNewNs(nullptr, ToXmlChar(entry[1]),
+                                            ToXmlChar(entry[0])));
+    }
+  }
+  return namespaces;
+}
+
+// Writes a structure that uses every kind of Serializer call.
+void Serialize(Serializer* serializer) {
+  ASSERT_TRUE(serializer->WriteProperty("Device", "Revision", "1.0"));
+  ASSERT_TRUE(serializer->WriteProperty("", "Note", "<a & \"b\">\n\tc\r"));
+  ASSERT_TRUE(serializer->WriteBoolProperty("Device", "Metric", true));
+
+  std::unique_ptr<Serializer> device_serializer =
+      serializer->CreateSerializer("", "Device");
+  ASSERT_NE(nullptr, device_serializer);
+  ASSERT_TRUE(device_serializer->WriteProperty("Device", "Name", "caf\xc3\xa9"));
+
+  std::unique_ptr<Serializer> pose_serializer =
+      device_serializer->CreateSerializer("Device", "DevicePose");
+  ASSERT_NE(nullptr, pose_serializer);
+  ASSERT_TRUE(pose_serializer->WriteDoubleArray("Device", "Position",
+                                                {1.5, -2.25, 1e-3}));
+
+  std::unique_ptr<Serializer> profiles_serializer =
+      device_serializer->CreateListSerializer("Device", "Profiles");
+  ASSERT_NE(nullptr, profiles_serializer);
+  for (int i = 0; i < 2; ++i) {
+    std::unique_ptr<Serializer> profile_serializer =
+        profiles_serializer->CreateItemSerializer("Device", "Profile");
+    ASSERT_NE(nullptr, profile_serializer);
+    ASSERT_TRUE(profile_serializer->WriteProperty("Profile", "Type",
+                                                  "VRPhoto"));
+    ASSERT_TRUE(profile_serializer->WriteIntArray("Profile", "CameraIndices",
+                                                  {i, i + 1, -7}));
+  }
+
+  std::unique_ptr<Serializer> empty_list_serializer =
+      device_serializer->CreateListSerializer("Device", "Cameras");
+  ASSERT_NE(nullptr, empty_list_serializer);
+
+  std::unique_ptr<Serializer> empty_serializer =
+      device_serializer->CreateSerializer("Camera", "Image");
+  ASSERT_NE(nullptr, empty_serializer);
+}
+
+TEST(StreamingSerializer, MatchesSerializerImpl) {
+  std::unique_ptr<XmpData> xmp_data = CreateXmpData(false);
+  std::unique_ptr<SerializerImpl> serializer_impl =
+      SerializerImpl::FromDataAndSerializeNamespaces(
+          CreateXmlNamespaces(),
+          GetFirstDescriptionElement(*xmp_data->MutableStandardSection()));
+  ASSERT_NE(nullptr, serializer_impl);
+  Serialize(serializer_impl.get());
+
+  string xmp;
+  std::unique_ptr<StreamingSerializer> serializer =
+      StreamingSerializer::FromNamespaces(CreateNamespaces(), &xmp);
+  Serialize(serializer.get());
+  ASSERT_TRUE(serializer->Finish());
+
+  EXPECT_EQ(XmlDocToString(xmp_data->StandardSection()),
+            kXmlDeclaration + xmp);
+}
+
+TEST(StreamingSerializer, EmptyDescription) {
+  std::unique_ptr<XmpData> xmp_data = CreateXmpData(false);
+  string xmp;
+  std::unique_ptr<StreamingSerializer> serializer =
+      StreamingSerializer::FromNamespaces({}, &xmp);
+  ASSERT_TRUE(serializer->Finish());
+  EXPECT_EQ(XmlDocToString(xmp_data->StandardSection()),
+            kXmlDeclaration + xmp);
+  EXPECT_FALSE(serializer->Finish());
+  EXPECT_FALSE(serializer->WriteProperty("", "Name", "Value"));
+}
+
+TEST(StreamingSerializer, AddNamespace) {
+  string xmp;
+  std::unique_ptr<StreamingSerializer> serializer =
+      StreamingSerializer::FromNamespaces({}, &xmp);
+  EXPECT_FALSE(serializer->WriteProperty("Device", "Revision", "1.0"));
+  EXPECT_FALSE(serializer->AddNamespace("Camera", kNamespaces[2][1]));
+
+  xmp.clear();
+  serializer = StreamingSerializer::FromNamespaces({}, &xmp);
+  ASSERT_TRUE(serializer->AddNamespace("Device", kNamespaces[1][1]));
+  ASSERT_TRUE(serializer->WriteProperty("Device", "Revision", "1.0"));
+  ASSERT_TRUE(serializer->Finish());
+  EXPECT_NE(string::npos,
+            xmp.find("<rdf:Description xmlns:Device=\"" +
+                     string(kNamespaces[1][1]) +
+                     "\" rdf:about=\"\" Device:Revision=\"1.0\"/>"));
+}
+
+TEST(StreamingSerializer, PropertyAfterChildNode) {
+  string xmp;
+  std::unique_ptr<StreamingSerializer> serializer =
+      StreamingSerializer::FromNamespaces(CreateNamespaces(), &xmp);
+  std::unique_ptr<Serializer> child_serializer =
+      serializer->CreateSerializer("Device", "Child");
+  ASSERT_NE(nullptr, child_serializer);
+  EXPECT_TRUE(child_serializer->WriteProperty("Device", "Revision", "1.0"));
+  EXPECT_FALSE(serializer->WriteProperty("Device", "Revision", "1.0"));
+  // The failed write still ended the child node.
+  EXPECT_FALSE(child_serializer->WriteProperty("Device", "Name", "Value"));
+}
+
+TEST(StreamingSerializer, WriteToEndedNode) {
+  string xmp;
+  std::unique_ptr<StreamingSerializer> serializer =
+      StreamingSerializer::FromNamespaces(CreateNamespaces(), &xmp);
+  std::unique_ptr<Serializer> first_serializer =
+      serializer->CreateSerializer("Device", "First");
+  ASSERT_NE(nullptr, first_serializer);
+  std::unique_ptr<Serializer> second_serializer =
+      serializer->CreateSerializer("Device", "Second");
+  ASSERT_NE(nullptr, second_serializer);
+
+  EXPECT_FALSE(first_serializer->WriteProperty("Device", "Name", "Value"));
+  EXPECT_EQ(nullptr, first_serializer->CreateSerializer("Device", "Child"));
+  EXPECT_TRUE(second_serializer->WriteProperty("Device", "Name", "Value"));
+
+  ASSERT_TRUE(serializer->Finish());
+  EXPECT_FALSE(second_serializer->WriteProperty("Device", "Other", "Value"));
+}
+
+TEST(StreamingSerializer, InvalidCalls) {
+  string xmp;
+  std::unique_ptr<StreamingSerializer> serializer =
+      StreamingSerializer::FromNamespaces(CreateNamespaces(), &xmp);
+  EXPECT_EQ(nullptr, serializer->CreateSerializer("Device", ""));
+  EXPECT_EQ(nullptr, serializer->CreateSerializer("Missing", "Node"));
+  EXPECT_EQ(nullptr, serializer->CreateItemSerializer("Device", "Item"));
+  EXPECT_FALSE(serializer->WriteProperty("Missing", "Name", "Value"));
+  EXPECT_FALSE(serializer->WriteProperty("Device", "", "Value"));
+  EXPECT_FALSE(serializer->WriteIntArray("Device", "Values", {}));
+  EXPECT_FALSE(serializer->WriteIntArray("Device", "", {1}));
+
+  std::unique_ptr<Serializer> list_serializer =
+      serializer->CreateListSerializer("Device", "List");
+  ASSERT_NE(nullptr, list_serializer);
+  EXPECT_FALSE(list_serializer->WriteProperty("Device", "Name", "Value"));
+  EXPECT_FALSE(list_serializer->WriteDoubleArray("Device", "Values", {1.0}));
+
+  xmp.clear();
+  serializer = StreamingSerializer::FromNamespaces({{"Device", "href"}}, &xmp);
+  EXPECT_EQ(nullptr, serializer->CreateListSerializer("Device", "List"));
+  EXPECT_FALSE(serializer->WriteIntArray("Device", "Values", {1}));
+}
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
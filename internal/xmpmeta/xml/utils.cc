@@ -21,6 +21,34 @@
 
 namespace xmpmeta {
 namespace xml {
+namespace {
+
+// Returns the given node or its first following sibling that is an rdf:li
+// node. Other children of an rdf:Seq node, such as the text nodes holding the
+// whitespace between elements, are skipped.
+xmlNodePtr SkipToElement(xmlNodePtr node) {
+  while (node != nullptr &&
+         strcmp(FromXmlChar(node->name), XmlConst::RdfLi()) != 0) {
+    node = node->next;
+  }
+  return node;
+}
+
+// Returns true if the node is an rdf:Seq node, and logs an error otherwise.
+bool IsSeqNode(xmlNodePtr node) {
+  if (node == nullptr) {
+    LOG(ERROR) << "Node was null";
+    return false;
+  }
+  if (strcmp(FromXmlChar(node->name), XmlConst::RdfSeq())) {
+    LOG(ERROR) << "Node is not an rdf:Seq node, was "
+               << FromXmlChar(node->name);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
 
 xmlNodePtr GetFirstDescriptionElement(const xmlDocPtr parent) {
   return DepthFirstSearch(parent, XmlConst::RdfDescription());
@@ -40,29 +68,29 @@ xmlNodePtr GetFirstSeqElement(xmlNodePtr parent) {
 // Returns the ith (zero-indexed) element in the given node.
 // {@code parent} is an rdf:Seq node.
 xmlNodePtr GetElementAt(xmlNodePtr node, int index) {
-  if (node == nullptr || index < 0) {
-    LOG(ERROR) << "Node was null or index was negative";
+  if (index < 0) {
+    LOG(ERROR) << "Index was negative";
     return nullptr;
   }
-  const string node_name = FromXmlChar(node->name);
-  if (strcmp(node_name.c_str(), XmlConst::RdfSeq())) {
-    LOG(ERROR) << "Node is not an rdf:Seq node, was " << node_name;
+  xmlNodePtr li_node = GetFirstElement(node);
+  for (int i = 0; i < index && li_node != nullptr; ++i) {
+    li_node = GetNextElement(li_node);
+  }
+  return li_node;
+}
+
+xmlNodePtr GetFirstElement(xmlNodePtr node) {
+  if (!IsSeqNode(node)) {
     return nullptr;
   }
-  int i = 0;
-  for (xmlNodePtr child = node->children; child != nullptr && i <= index;
-       child = child->next) {
-    if (strcmp(FromXmlChar(child->name), XmlConst::RdfLi())) {
-      // This is not an rdf:li node. This can occur because the node's content
-      // is also treated as a node, and these should be ignored.
-      continue;
-    }
-    if (i == index) {
-      return child;
-    }
-    i++;
+  return SkipToElement(node->children);
+}
+
+xmlNodePtr GetNextElement(xmlNodePtr li_node) {
+  if (li_node == nullptr) {
+    return nullptr;
   }
-  return nullptr;
+  return SkipToElement(li_node->next);
 }
 
 const string GetLiNodeContent(xmlNodePtr node) {
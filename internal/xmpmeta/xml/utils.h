@@ -49,6 +49,19 @@ xmlNodePtr GetFirstSeqElement(xmlNodePtr parent);
 // not an rdf:Seq node.
 xmlNodePtr GetElementAt(xmlNodePtr node, int index);
 
+// Returns the first rdf:li node in the given rdf:Seq node. Returns null if
+// {@code node} is null, is not an rdf:Seq node, or has no rdf:li nodes.
+// Together with GetNextElement, this visits each element of a list in
+// constant time, unlike GetElementAt.
+// Example:
+//   for (xmlNodePtr li_node = GetFirstElement(seq_node); li_node != nullptr;
+//        li_node = GetNextElement(li_node)) { ... }
+xmlNodePtr GetFirstElement(xmlNodePtr node);
+
+// Returns the rdf:li node that follows the given rdf:li node in its rdf:Seq
+// node, or null if there is none.
+xmlNodePtr GetNextElement(xmlNodePtr li_node);
+
 // Returns the value in an rdf:li node. This is for a node whose value
 // does not have a name, e.g. <rdf:li>value</rdf:li>.
 // If the given rdf:li node has a nested node, it returns the string
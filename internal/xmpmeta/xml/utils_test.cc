@@ -161,6 +161,36 @@ TEST(XmlUtils, GetListElementAndContents) {
   ASSERT_TRUE(string("") != GetLiNodeContent(li_node));
 }
 
+TEST(XmlUtils, IterateOverListElements) {
+  const string in_filename = TempFileAbsolutePath(kInFile);
+  CreateMetadataFile(in_filename);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(in_filename, true, &xmp_data));
+  xmlNodePtr seq_node = GetFirstSeqElement(xmp_data.StandardSection());
+  ASSERT_NE(nullptr, seq_node);
+
+  // The whitespace between the rdf:li nodes is skipped.
+  int count = 0;
+  for (xmlNodePtr li_node = GetFirstElement(seq_node); li_node != nullptr;
+       li_node = GetNextElement(li_node)) {
+    EXPECT_EQ(GetElementAt(seq_node, count), li_node);
+    count++;
+  }
+  EXPECT_EQ(3, count);
+}
+
+TEST(XmlUtils, GetFirstElementFromNonSeqOrNullNode) {
+  const string in_filename = TempFileAbsolutePath(kInFile);
+  CreateMetadataFile(in_filename);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(in_filename, true, &xmp_data));
+  xmlNodePtr description_node =
+      GetFirstDescriptionElement(xmp_data.StandardSection());
+  EXPECT_EQ(nullptr, GetFirstElement(description_node));
+  EXPECT_EQ(nullptr, GetFirstElement(nullptr));
+  EXPECT_EQ(nullptr, GetNextElement(nullptr));
+}
+
 TEST(XmlUtils, GetContentsFromNonListNode) {
   // Create the metadata.
   const string in_filename = TempFileAbsolutePath(kInFile);
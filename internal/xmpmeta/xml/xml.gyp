@@ -43,8 +43,12 @@
       'sources': [
         '<(xml_dir)/const.cc',
         '<(xml_dir)/deserializer_impl.cc',
+        '<(xml_dir)/node_index.cc',
+        '<(xml_dir)/property_extractor.cc',
+        '<(xml_dir)/property_streamer.cc',
         '<(xml_dir)/search.cc',
         '<(xml_dir)/serializer_impl.cc',
+        '<(xml_dir)/streaming_serializer.cc',
         '<(xml_dir)/utils.cc',
       ],
     },
@@ -21,6 +21,7 @@ XmpData::XmpData() : xmp_(nullptr), xmp_extended_(nullptr) {}
 XmpData::~XmpData() { Reset(); }
 
 void XmpData::Reset() {
+  extended_parser_ = nullptr;
   if (xmp_) {
     xmlFreeDoc(xmp_);
     xmp_ = nullptr;
@@ -35,8 +36,37 @@ const xmlDocPtr XmpData::StandardSection() const { return xmp_; }
 
 xmlDocPtr* XmpData::MutableStandardSection() { return &xmp_; }
 
-const xmlDocPtr XmpData::ExtendedSection() const { return xmp_extended_; }
+const xmlDocPtr XmpData::ExtendedSection() const {
+  ParseExtendedSection();
+  return xmp_extended_;
+}
+
+xmlDocPtr* XmpData::MutableExtendedSection() {
+  ParseExtendedSection();
+  return &xmp_extended_;
+}
 
-xmlDocPtr* XmpData::MutableExtendedSection() { return &xmp_extended_; }
+void XmpData::SetLazyExtendedSection(
+    const std::function<xmlDocPtr()>& parser) {
+  std::lock_guard<std::mutex> lock(extended_mutex_);
+  if (xmp_extended_) {
+    xmlFreeDoc(xmp_extended_);
+    xmp_extended_ = nullptr;
+  }
+  extended_parser_ = parser;
+}
+
+bool XmpData::HasExtendedSection() const {
+  std::lock_guard<std::mutex> lock(extended_mutex_);
+  return xmp_extended_ != nullptr || extended_parser_ != nullptr;
+}
+
+void XmpData::ParseExtendedSection() const {
+  std::lock_guard<std::mutex> lock(extended_mutex_);
+  if (extended_parser_ != nullptr) {
+    xmp_extended_ = extended_parser_();
+    extended_parser_ = nullptr;
+  }
+}
 
 }  // namespace xmpmeta
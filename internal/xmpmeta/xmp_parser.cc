@@ -15,18 +15,23 @@
 #include "xmpmeta/xmp_parser.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <functional>
+#include <memory>
 #include <stack>
 
 #include "glog/logging.h"
 #include "strings/case.h"
-#include "strings/numbers.h"
 #include "strings/util.h"
 #include "xmpmeta/base64.h"
 #include "xmpmeta/jpeg_io.h"
+#include "xmpmeta/number_parser.h"
 #include "xmpmeta/xmp_const.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/property_extractor.h"
+#include "xmpmeta/xml/property_streamer.h"
 #include "xmpmeta/xml/search.h"
 #include "xmpmeta/xml/utils.h"
 
@@ -61,13 +66,13 @@ template <typename T>
 bool ConvertStringPropertyToType(const string& string_property, T* value);
 
 // Gets the end of the XMP meta content. If there is no packet wrapper, returns
-// data.length, otherwise returns 1 + the position of last '>' without '?'
+// size, otherwise returns 1 + the position of last '>' without '?'
 // before it. Usually the packet wrapper end is "<?xpacket end="w"?>.
-size_t GetXmpContentEnd(const string& data) {
-  if (data.empty()) {
+size_t GetXmpContentEnd(const char* data, size_t size) {
+  if (size == 0) {
     return 0;
   }
-  for (size_t i = data.size() - 1; i >= 1; --i) {
+  for (size_t i = size - 1; i >= 1; --i) {
     if (data[i] == '>') {
       if (data[i - 1] != '?') {
         return i + 1;
@@ -76,16 +81,26 @@ size_t GetXmpContentEnd(const string& data) {
   }
   // It should not reach here for a valid XMP meta.
   LOG(WARNING) << "Failed to find the end of the XMP meta content.";
-  return data.size();
+  return size;
 }
 
-// Parses the first valid XMP section. Any other valid XMP section will be
-// ignored.
-bool ParseFirstValidXMPSection(const std::vector<Section>& sections,
-                               XmpData* xmp) {
-  for (const Section& section : sections) {
-    if (HasPrefixString(section.data, XmpConst::Header())) {
-      const size_t end = GetXmpContentEnd(section.data);
+// Parses an XML document from memory, reusing the context if there is one.
+xmlDocPtr ReadXmlMemory(const char* data, int size, int options,
+                        XmpParserContext* context) {
+  if (context != nullptr) {
+    return context->ReadMemory(data, size, options);
+  }
+  return xmlReadMemory(data, size, nullptr, nullptr, options);
+}
+
+// Finds the XML content of the first valid XMP section. Any other valid XMP
+// section will be ignored.
+bool FindFirstValidXMPSection(const std::vector<SectionView>& sections,
+                              const char** content_start,
+                              size_t* content_length) {
+  for (const SectionView& section : sections) {
+    if (section.HasPrefix(XmpConst::Header())) {
+      const size_t end = GetXmpContentEnd(section.data, section.length);
       // Increment header length by 1 for the null termination.
       const size_t header_length = strlen(XmpConst::Header()) + 1;
       // Check for integer underflow before subtracting.
@@ -94,119 +109,198 @@ bool ParseFirstValidXMPSection(const std::vector<Section>& sections,
                    << static_cast<int>(end - header_length);
         return false;
       }
-      const size_t content_length = end - header_length;
+      *content_length = end - header_length;
       // header_length is guaranteed to be <= data.size due to the if condition
       // above. If this contract changes we must add an additonal check.
-      const char* content_start = &section.data[header_length];
-      // xmlReadMemory requires an int. Before casting size_t to int we must
-      // check for integer overflow.
-      if (content_length > INT_MAX) {
-        LOG(ERROR) << "First XMP section too large, size: " << content_length;
-        return false;
-      }
-      *xmp->MutableStandardSection() = xmlReadMemory(
-          content_start, static_cast<int>(content_length), nullptr, nullptr,
-          0);
-      if (xmp->StandardSection() == nullptr) {
-        LOG(WARNING) << "Failed to parse standard section.";
-        return false;
-      }
+      *content_start = section.data + header_length;
       return true;
     }
   }
   return false;
 }
 
-// Collects the extended XMP sections with the given name into a string. Other
-// sections will be ignored.
-string GetExtendedXmpSections(const std::vector<Section>& sections,
-                              const string& section_name) {
+// Parses the first valid XMP section. Any other valid XMP section will be
+// ignored.
+bool ParseFirstValidXMPSection(const std::vector<SectionView>& sections,
+                               XmpParserContext* context, XmpData* xmp) {
+  const char* content_start;
+  size_t content_length;
+  if (!FindFirstValidXMPSection(sections, &content_start, &content_length)) {
+    return false;
+  }
+  // xmlReadMemory requires an int. Before casting size_t to int we must
+  // check for integer overflow.
+  if (content_length > INT_MAX) {
+    LOG(ERROR) << "First XMP section too large, size: " << content_length;
+    return false;
+  }
+  *xmp->MutableStandardSection() = ReadXmlMemory(
+      content_start, static_cast<int>(content_length), 0, context);
+  if (xmp->StandardSection() == nullptr) {
+    LOG(WARNING) << "Failed to parse standard section.";
+    return false;
+  }
+  return true;
+}
+
+// Reads a big-endian 4-byte integer.
+uint32_t Read4ByteInt(const char* data) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  return static_cast<uint32_t>(bytes[0]) << 24 |
+      static_cast<uint32_t>(bytes[1]) << 16 |
+      static_cast<uint32_t>(bytes[2]) << 8 | static_cast<uint32_t>(bytes[3]);
+}
+
+// A piece of the extended XMP content, at the offset declared in its section.
+struct ExtendedXmpChunk {
+  size_t offset;
+  const char* data;
+  size_t length;
+
+  bool operator<(const ExtendedXmpChunk& other) const {
+    return offset < other.offset;
+  }
+};
+
+// Collects the extended XMP sections with the given name, sorted by their
+// declared offsets, and sets total_length to the length declared in their
+// headers. Sections may appear in any order. Returns false if the sections
+// disagree on the total length, overlap, leave gaps, or do not fit.
+bool GetExtendedXmpChunks(const std::vector<SectionView>& sections,
+                          const string& section_name,
+                          std::vector<ExtendedXmpChunk>* chunks,
+                          size_t* total_length) {
   string extended_header = XmpConst::ExtensionHeader();
   extended_header += '\0' + section_name;
   // section_name is dynamically extracted from the xml file and can have an
   // arbitrary size. Check for integer overflow before addition.
   if (extended_header.size() > SIZE_MAX - XmpConst::ExtensionHeaderOffset()) {
-    return "";
+    return false;
   }
   const size_t section_start_offset =
       extended_header.size() + XmpConst::ExtensionHeaderOffset();
 
-  // Compute the size of the buffer to parse the extended sections.
-  std::vector<const Section*> xmp_sections;
-  std::vector<size_t> xmp_end_offsets;
-  size_t buffer_size = 0;
-  for (const Section& section : sections) {
-    if (extended_header.empty() ||
-        HasPrefixString(section.data, extended_header)) {
-      const size_t end_offset = section.data.size();
-      const size_t section_size = end_offset - section_start_offset;
-      if (end_offset < section_start_offset ||
-          section_size > SIZE_MAX - buffer_size) {
-        return "";
+  chunks->clear();
+  for (const SectionView& section : sections) {
+    if (!section.HasPrefix(extended_header)) {
+      continue;
+    }
+    if (section.length < section_start_offset) {
+      LOG(WARNING) << "Extended section too short: " << section.length;
+      return false;
+    }
+    const char* fields = section.data + extended_header.size();
+    const size_t declared_length = Read4ByteInt(fields);
+    const size_t offset = Read4ByteInt(fields + 4);
+    const size_t length = section.length - section_start_offset;
+    if (chunks->empty()) {
+      // Every section is at most 64 KiB, which bounds the total length of
+      // the sections present and so any allocation for them.
+      if (declared_length > sections.size() * 0xffff) {
+        LOG(WARNING) << "Invalid extended section length: " << declared_length;
+        return false;
       }
-      buffer_size += section_size;
-      xmp_sections.push_back(&section);
-      xmp_end_offsets.push_back(end_offset);
+      *total_length = declared_length;
+    } else if (declared_length != *total_length) {
+      LOG(WARNING) << "Extended sections disagree on the total length: "
+                   << declared_length << " vs " << *total_length;
+      return false;
+    }
+    if (offset > *total_length || length > *total_length - offset) {
+      LOG(WARNING) << "Extended section at offset " << offset << " of length "
+                   << length << " exceeds total length " << *total_length;
+      return false;
     }
+    chunks->push_back({offset, section.data + section_start_offset, length});
+  }
+  if (chunks->empty()) {
+    LOG(WARNING) << "No extended sections found for " << section_name;
+    return false;
   }
 
-  // Copy all the relevant sections' data into a buffer.
-  string buffer(buffer_size, '\0');
-  if (buffer.size() != buffer_size) {
-    return "";
+  // Check that the sections cover the content exactly once.
+  std::sort(chunks->begin(), chunks->end());
+  size_t covered = 0;
+  for (const ExtendedXmpChunk& chunk : *chunks) {
+    if (chunk.offset != covered) {
+      LOG(WARNING) << (chunk.offset < covered ? "Overlapping" : "Missing")
+                   << " extended section data at offset "
+                   << std::min(chunk.offset, covered);
+      return false;
+    }
+    covered = chunk.offset + chunk.length;
+  }
+  if (covered != *total_length) {
+    LOG(WARNING) << "Missing extended section data at offset " << covered;
+    return false;
   }
-  size_t offset = 0;
-  for (int i = 0; i < xmp_sections.size(); ++i) {
-    const Section* section = xmp_sections[i];
-    const size_t length = xmp_end_offsets[i] - section_start_offset;
-    std::copy_n(&section->data[section_start_offset], length, &buffer[offset]);
-    offset += length;
+  return true;
+}
+
+// Joins the chunks returned by GetExtendedXmpChunks into one buffer.
+std::unique_ptr<char[]> AssembleExtendedXmpChunks(
+    const std::vector<ExtendedXmpChunk>& chunks, size_t total_length) {
+  std::unique_ptr<char[]> buffer(new char[total_length]);
+  for (const ExtendedXmpChunk& chunk : chunks) {
+    std::copy_n(chunk.data, chunk.length, buffer.get() + chunk.offset);
   }
   return buffer;
 }
 
-// Parses the extended XMP sections with the given name. All other sections
-// will be ignored.
-bool ParseExtendedXmpSections(const std::vector<Section>& sections,
-                              const string& section_name, XmpData* xmp_data) {
-  const string extended_sections =
-      GetExtendedXmpSections(sections, section_name);
+// Parses the extended XMP content held by the given chunks.
+xmlDocPtr ParseExtendedXmpChunks(const std::vector<ExtendedXmpChunk>& chunks,
+                                 size_t total_length,
+                                 XmpParserContext* context) {
   // xmlReadMemory requires an int. Before casting size_t to int we must check
   // for integer overflow.
-  if (extended_sections.size() > INT_MAX) {
-    LOG(WARNING) << "Extended sections too large, size: "
-                 << extended_sections.size();
-    return false;
+  if (total_length > INT_MAX) {
+    LOG(WARNING) << "Extended sections too large, size: " << total_length;
+    return nullptr;
   }
-  *xmp_data->MutableExtendedSection() =
-      xmlReadMemory(extended_sections.data(),
-                    static_cast<int>(extended_sections.size()), nullptr,
-                    nullptr, XML_PARSE_HUGE);
-  if (xmp_data->ExtendedSection() == nullptr) {
+  const std::unique_ptr<char[]> buffer =
+      AssembleExtendedXmpChunks(chunks, total_length);
+  xmlDocPtr doc = ReadXmlMemory(buffer.get(), static_cast<int>(total_length),
+                                XML_PARSE_HUGE, context);
+  if (doc == nullptr) {
     LOG(WARNING) << "Failed to parse extended sections.";
+  }
+  return doc;
+}
+
+// Parses the extended XMP sections with the given name. All other sections
+// will be ignored.
+bool ParseExtendedXmpSections(const std::vector<SectionView>& sections,
+                              const string& section_name,
+                              XmpParserContext* context, XmpData* xmp_data) {
+  std::vector<ExtendedXmpChunk> chunks;
+  size_t total_length = 0;
+  if (!GetExtendedXmpChunks(sections, section_name, &chunks, &total_length)) {
     return false;
   }
-  return true;
+  *xmp_data->MutableExtendedSection() =
+      ParseExtendedXmpChunks(chunks, total_length, context);
+  return xmp_data->ExtendedSection() != nullptr;
 }
 
-// Extracts a XmpData from a JPEG image stream.
-bool ExtractXmpMeta(const bool skip_extended, std::istream* file,
-                    XmpData* xmp_data) {
-  CHECK_NOTNULL(xmp_data)->Reset();
+// Gets the name of the extended section from the standard section. Returns
+// false if there is no extended section.
+bool GetExtendedSectionName(const XmpData& xmp_data, string* name) {
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(xmp_data.StandardSection()));
+  return deserializer.ParseString(XmpConst::HasExtensionPrefix(),
+                                  XmpConst::HasExtension(), name);
+}
 
-  ParseOptions parse_options;
-  parse_options.read_meta_only = true;
-  if (skip_extended) {
-    parse_options.section_header = XmpConst::Header();
-    parse_options.section_header_return_first = true;
-  }
-  const std::vector<Section> sections = Parse(parse_options, file);
+// Extracts a XmpData from the APP1 sections of a JPEG image.
+bool ExtractXmpMeta(const std::vector<SectionView>& sections,
+                    const bool skip_extended, XmpParserContext* context,
+                    XmpData* xmp_data) {
   if (sections.empty()) {
     LOG(WARNING) << "No sections found.";
     return false;
   }
 
-  if (!ParseFirstValidXMPSection(sections, xmp_data)) {
+  if (!ParseFirstValidXMPSection(sections, context, xmp_data)) {
     LOG(WARNING) << "Could not parse first section.";
     return false;
   }
@@ -214,20 +308,60 @@ bool ExtractXmpMeta(const bool skip_extended, std::istream* file,
     return true;
   }
   string extension_name;
-  DeserializerImpl deserializer(
-      GetFirstDescriptionElement(xmp_data->StandardSection()));
-  if (!deserializer.ParseString(XmpConst::HasExtensionPrefix(),
-                                XmpConst::HasExtension(), &extension_name)) {
+  if (!GetExtendedSectionName(*xmp_data, &extension_name)) {
     // No extended sections present, so nothing to parse.
     return true;
   }
-  if (!ParseExtendedXmpSections(sections, extension_name, xmp_data)) {
+  if (!ParseExtendedXmpSections(sections, extension_name, context,
+                                xmp_data)) {
     LOG(WARNING) << "Extended sections present, but could not be parsed.";
     return false;
   }
   return true;
 }
 
+// Extracts a XmpData from a JPEG image stream.
+bool ExtractXmpMeta(const bool skip_extended, std::istream* file,
+                    XmpData* xmp_data) {
+  CHECK_NOTNULL(xmp_data)->Reset();
+
+  ParseOptions parse_options;
+  parse_options.read_meta_only = true;
+  if (skip_extended) {
+    parse_options.section_header = XmpConst::Header();
+    parse_options.section_header_return_first = true;
+  }
+  const std::vector<Section> sections = Parse(parse_options, file);
+  return ExtractXmpMeta(ToSectionViews(sections), skip_extended, nullptr,
+                        xmp_data);
+}
+
+// Extracts a XmpData from an indexed JPEG image. No section data is copied
+// except for the extended sections, which must be joined before parsing.
+bool ExtractXmpMeta(const bool skip_extended, const SectionIndex& index,
+                    XmpParserContext* context, XmpData* xmp_data) {
+  CHECK_NOTNULL(xmp_data)->Reset();
+  return ExtractXmpMeta(index.FindApp1Sections(""), skip_extended, context,
+                        xmp_data);
+}
+
+// Indexes the sections of a JPEG file. Returns null if the file does not have
+// a JPEG extension or cannot be read.
+std::unique_ptr<SectionIndex> IndexJpegFile(const string& filename) {
+  const string& lower_filename = strings::ToLower(filename);
+  if (!HasSuffixString(lower_filename, kJpgExtension) &&
+      !HasSuffixString(lower_filename, kJpegExtension)) {
+    LOG(WARNING) << "XMP parse: only JPEG file is supported";
+    return nullptr;
+  }
+
+  std::unique_ptr<SectionIndex> index = SectionIndex::FromFile(filename);
+  if (index == nullptr) {
+    LOG(WARNING) << " Could not read file: " << filename;
+  }
+  return index;
+}
+
 // Extracts the specified string attribute.
 bool GetStringProperty(const xmlNodePtr node, const char* prefix,
                        const char* property, string* value) {
@@ -285,46 +419,144 @@ bool ConvertStringPropertyToType<bool>(const string& string_property,
 template <>
 bool ConvertStringPropertyToType<double>(const string& string_property,
                                          double* value) {
-  *value = std::stod(string_property);
-  return true;
+  return ParseNumber(string_property.data(), string_property.size(), value);
 }
 
 template <>
 bool ConvertStringPropertyToType<int>(const string& string_property,
                                       int* value) {
-  return SimpleAtoi(string_property, value);
+  return ParseNumber(string_property.data(), string_property.size(), value);
 }
 
 template <>
 bool ConvertStringPropertyToType<int64>(const string& string_property,
                                        int64* value) {
-  *value = std::stol(string_property);
-  return true;
+  return ParseNumber(string_property.data(), string_property.size(), value);
 }
 
 }  // namespace
 
 bool ReadXmpHeader(const string& filename, const bool skip_extended,
                    XmpData* xmp_data) {
-  const string& lower_filename = strings::ToLower(filename);
-  if (!HasSuffixString(lower_filename, kJpgExtension) &&
-      !HasSuffixString(lower_filename, kJpegExtension)) {
-    LOG(WARNING) << "XMP parse: only JPEG file is supported";
+  return ReadXmpHeader(filename, skip_extended, nullptr, xmp_data);
+}
+
+bool ReadXmpHeader(const string& filename, const bool skip_extended,
+                   XmpParserContext* context, XmpData* xmp_data) {
+  std::unique_ptr<SectionIndex> index = IndexJpegFile(filename);
+  if (index == nullptr) {
     return false;
   }
+  return ExtractXmpMeta(skip_extended, *index, context, xmp_data);
+}
 
-  std::ifstream file(filename.c_str(), std::ios::binary);
-  if (!file.is_open()) {
-    LOG(WARNING) << " Could not read file: " << filename;
+bool ExtractXmpProperties(const string& filename,
+                          xml::PropertyExtractor* extractor) {
+  std::unique_ptr<SectionIndex> index = IndexJpegFile(filename);
+  if (index == nullptr) {
+    return false;
+  }
+  const char* content_start;
+  size_t content_length;
+  if (!FindFirstValidXMPSection(index->FindApp1Sections(""), &content_start,
+                                &content_length)) {
+    return false;
+  }
+  return CHECK_NOTNULL(extractor)->Extract(content_start, content_length);
+}
+
+bool ReadExtendedXmpBase64Property(const string& filename,
+                                   const string& prefix, const string& name,
+                                   const DataSink& sink) {
+  std::unique_ptr<SectionIndex> index = IndexJpegFile(filename);
+  if (index == nullptr) {
+    return false;
+  }
+  const std::vector<SectionView> sections = index->FindApp1Sections("");
+  const char* content_start;
+  size_t content_length;
+  if (!FindFirstValidXMPSection(sections, &content_start, &content_length)) {
+    LOG(WARNING) << "Could not find the standard section.";
+    return false;
+  }
+  xml::PropertyExtractor extractor(std::vector<std::pair<string, string>>{
+      {XmpConst::HasExtensionPrefix(), XmpConst::HasExtension()}});
+  string extension_name;
+  if (!extractor.Extract(content_start, content_length) ||
+      !extractor.ParseString(XmpConst::HasExtensionPrefix(),
+                             XmpConst::HasExtension(), &extension_name)) {
+    LOG(WARNING) << "No extended sections present.";
+    return false;
+  }
+  std::vector<ExtendedXmpChunk> chunks;
+  size_t total_length = 0;
+  if (!GetExtendedXmpChunks(sections, extension_name, &chunks,
+                            &total_length)) {
     return false;
   }
-  return ExtractXmpMeta(skip_extended, &file, xmp_data);
+
+  std::vector<std::pair<const char*, size_t>> pieces;
+  for (const ExtendedXmpChunk& chunk : chunks) {
+    pieces.push_back({chunk.data, chunk.length});
+  }
+  // Decode the value as it is read from the mapped chunks.
+  Base64Decoder decoder(sink);
+  if (!xml::StreamPropertyValue(pieces, prefix, name,
+                                [&decoder](const char* data, size_t size) {
+                                  return decoder.Update(data, size);
+                                })) {
+    LOG(WARNING) << "Could not read " << prefix << ":" << name
+                 << " from the extended sections.";
+    return false;
+  }
+  return decoder.Finish();
+}
+
+bool ReadXmpHeaderLazily(const string& filename, XmpData* xmp_data) {
+  CHECK_NOTNULL(xmp_data)->Reset();
+  // Shared with the lazy parser, which keeps the file mapped.
+  std::shared_ptr<SectionIndex> index = IndexJpegFile(filename);
+  if (index == nullptr) {
+    return false;
+  }
+  const std::vector<SectionView> sections = index->FindApp1Sections("");
+  if (sections.empty()) {
+    LOG(WARNING) << "No sections found.";
+    return false;
+  }
+  if (!ParseFirstValidXMPSection(sections, nullptr, xmp_data)) {
+    LOG(WARNING) << "Could not parse first section.";
+    return false;
+  }
+  string extension_name;
+  if (!GetExtendedSectionName(*xmp_data, &extension_name)) {
+    return true;
+  }
+  // Check the layout of the extended sections now, so that only the XML
+  // parse is deferred.
+  std::vector<ExtendedXmpChunk> chunks;
+  size_t total_length = 0;
+  if (!GetExtendedXmpChunks(sections, extension_name, &chunks,
+                            &total_length)) {
+    LOG(WARNING) << "Extended sections present, but could not be parsed.";
+    return false;
+  }
+  xmp_data->SetLazyExtendedSection([index, chunks, total_length]() {
+    return ParseExtendedXmpChunks(chunks, total_length, nullptr);
+  });
+  return true;
 }
 
 bool ReadXmpFromMemory(const string& jpeg_contents, const bool skip_extended,
                        XmpData* xmp_data) {
-  std::istringstream stream(jpeg_contents);
-  return ExtractXmpMeta(skip_extended, &stream, xmp_data);
+  return ReadXmpFromMemory(jpeg_contents, skip_extended, nullptr, xmp_data);
+}
+
+bool ReadXmpFromMemory(const string& jpeg_contents, const bool skip_extended,
+                       XmpParserContext* context, XmpData* xmp_data) {
+  std::unique_ptr<SectionIndex> index =
+      SectionIndex::FromBuffer(jpeg_contents.data(), jpeg_contents.size());
+  return ExtractXmpMeta(skip_extended, *index, context, xmp_data);
 }
 
 bool ReadXmpHeader(std::istream* input_stream, bool skip_extended,
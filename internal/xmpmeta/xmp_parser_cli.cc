@@ -25,12 +25,12 @@
 //    --output_audio=<output_audio_file> \
 //    --alsologtostderr
 
+#include <fstream>
 #include <memory>
 #include <string>
 
 #include "gflags/gflags.h"
 #include "glog/logging.h"
-#include "xmpmeta/file.h"
 #include "xmpmeta/gaudio.h"
 #include "xmpmeta/gimage.h"
 #include "xmpmeta/gpano.h"
@@ -48,7 +48,6 @@ using xmpmeta::GAudio;
 using xmpmeta::GImage;
 using xmpmeta::GPano;
 using xmpmeta::ReadXmpHeader;
-using xmpmeta::WriteStringToFileOrDie;
 using xmpmeta::XmpData;
 
 // Prints the PanoMetaData to the log.
@@ -67,11 +66,11 @@ int main(int argc, char** argv) {
   InitGoogle(argv[0], &argc, &argv, true);
   QCHECK(!FLAGS_input.empty());
 
-  // Parse the XMP.
+  // Parse the XMP. The right image and audio are streamed out of the extended
+  // section below, so it is not parsed here.
   XmpData xmp;
-  const bool skip_extended =
-      FLAGS_output_image.empty() && FLAGS_output_audio.empty();
-  QCHECK(ReadXmpHeader(FLAGS_input, skip_extended, &xmp));
+  const bool kSkipExtended = true;
+  QCHECK(ReadXmpHeader(FLAGS_input, kSkipExtended, &xmp));
 
   // Print the PanoMetaData.
   auto gpano = CHECK_NOTNULL(GPano::FromXmp(xmp));
@@ -79,15 +78,16 @@ int main(int argc, char** argv) {
 
   // Optionally decode and save the right image.
   if (!FLAGS_output_image.empty()) {
-    auto gimage = CHECK_NOTNULL(GImage::FromXmp(xmp));
-    WriteStringToFileOrDie(gimage->GetData(), FLAGS_output_image);
+    QCHECK(GImage::IsPresent(xmp));
+    std::ofstream output(FLAGS_output_image, std::ios::binary);
+    QCHECK(GImage::ReadDataFromJpegFile(FLAGS_input, &output));
   }
 
   // Optionally decode and save the audio (if it exists).
   if (!FLAGS_output_audio.empty()) {
-    auto gaudio = GAudio::FromXmp(xmp);
-    if (gaudio != nullptr) {
-      WriteStringToFileOrDie(gaudio->GetData(), FLAGS_output_audio);
+    if (GAudio::IsPresent(xmp)) {
+      std::ofstream output(FLAGS_output_audio, std::ios::binary);
+      QCHECK(GAudio::ReadDataFromJpegFile(FLAGS_input, &output));
     } else {
       LOG(WARNING) << "Pano does not appear to have audio";
     }
@@ -0,0 +1,109 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xmp_parser_context.h"
+
+#include <libxml/dict.h>
+
+#include "glog/logging.h"
+#include "xmpmeta/xmp_const.h"
+#include "xmpmeta/xml/const.h"
+#include "xmpmeta/xml/utils.h"
+
+using xmpmeta::xml::ToXmlChar;
+using xmpmeta::xml::XmlConst;
+
+namespace xmpmeta {
+namespace {
+
+// Names that XMP packets commonly use, beyond those in XmlConst and XmpConst.
+const char* const kCommonNames[] = {
+    "xmlns",
+    "xmptk",
+    "xpacket",
+    "GAudio",
+    "GImage",
+    "GPano",
+    "Data",
+    "Mime",
+    "CroppedAreaImageHeightPixels",
+    "CroppedAreaImageWidthPixels",
+    "CroppedAreaLeftPixels",
+    "CroppedAreaTopPixels",
+    "FullPanoHeightPixels",
+    "FullPanoWidthPixels",
+    "InitialViewHeadingDegrees",
+    "PoseHeadingDegrees",
+    "ProjectionType",
+    "UsePanoramaViewer",
+    "Device",
+    "Revision",
+    "Cameras",
+    "Camera",
+    "Profiles",
+    "Profile",
+    "Pose",
+    "Image",
+    "Audio",
+};
+
+// Adds the common XMP names to the dictionary.
+void WarmDictionary(xmlDictPtr dictionary) {
+  const char* const xmp_names[] = {
+      XmlConst::RdfPrefix(),
+      XmlConst::RdfNodeName(),
+      XmlConst::RdfDescription(),
+      XmlConst::RdfAbout(),
+      XmlConst::RdfSeq(),
+      XmlConst::RdfLi(),
+      XmpConst::NamespacePrefix(),
+      XmpConst::NodeName(),
+      XmpConst::HasExtensionPrefix(),
+      XmpConst::HasExtension(),
+  };
+  for (const char* name : xmp_names) {
+    xmlDictLookup(dictionary, ToXmlChar(name), -1);
+  }
+  for (const char* name : kCommonNames) {
+    xmlDictLookup(dictionary, ToXmlChar(name), -1);
+  }
+}
+
+}  // namespace
+
+XmpParserContext::XmpParserContext() : context_(xmlNewParserCtxt()) {
+  CHECK(context_ != nullptr) << "Could not create a libxml2 parser context";
+  WarmDictionary(context_->dict);
+}
+
+XmpParserContext::~XmpParserContext() {
+  // Documents hold their own reference to the dictionary.
+  xmlFreeParserCtxt(context_);
+}
+
+xmlDocPtr XmpParserContext::ReadMemory(const char* data, int size,
+                                       int options) {
+  // xmlCtxtReadMemory resets the context, keeping its dictionary.
+  xmlDocPtr doc =
+      xmlCtxtReadMemory(context_, data, size, nullptr, nullptr, options);
+  // Release the copy of the input now rather than at the next parse.
+  xmlCtxtReset(context_);
+  return doc;
+}
+
+const xmlDict* XmpParserContext::Dictionary() const {
+  return context_->dict;
+}
+
+}  // namespace xmpmeta
@@ -0,0 +1,83 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xmp_parser_context.h"
+
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "xmpmeta/benchmark.h"
+#include "xmpmeta/file.h"
+#include "xmpmeta/xmp_const.h"
+#include "xmpmeta/xmp_data.h"
+#include "xmpmeta/xmp_parser.h"
+
+namespace xmpmeta {
+namespace {
+
+const int kCorpusSize = 64;
+
+// Returns small photo sphere JPEGs whose standard XMP sections differ in one
+// GPano value.
+std::vector<string> CreatePhotoSphereCorpus() {
+  string xmp;
+  ReadFileToStringOrDie(
+      BenchmarkDataPath("photo_sphere_std_section_data.txt"), &xmp);
+  const string value = "CroppedAreaLeftPixels=\"0\"";
+  const size_t value_position = xmp.find(value);
+  CHECK_NE(string::npos, value_position);
+
+  std::vector<string> corpus;
+  for (int i = 0; i < kCorpusSize; ++i) {
+    string packet = xmp;
+    packet.replace(value_position, value.size(),
+                   "CroppedAreaLeftPixels=\"" + std::to_string(i) + "\"");
+    const string data = string(XmpConst::Header()) + '\0' + packet;
+    string jpeg = "\xff\xd8\xff\xe1";
+    jpeg += static_cast<char>((data.size() + 2) >> 8);
+    jpeg += static_cast<char>((data.size() + 2) & 0xff);
+    jpeg += data;
+    jpeg += "\xff\xda";
+    jpeg += string(1024, '\0');
+    corpus.push_back(jpeg);
+  }
+  return corpus;
+}
+
+// Measures the cost per file of parsing the standard XMP section of small
+// photo sphere JPEGs, with a fresh libxml2 parser for each file and with one
+// XmpParserContext reused across them.
+void BM_ReadPhotoSphereXmp() {
+  const std::vector<string> corpus = CreatePhotoSphereCorpus();
+  const bool kSkipExtended = true;
+  RunBenchmarkCase("ReadXmpFromMemory", 0, corpus.size(), [&]() {
+    for (const string& jpeg : corpus) {
+      XmpData xmp_data;
+      CHECK(ReadXmpFromMemory(jpeg, kSkipExtended, &xmp_data));
+    }
+  });
+  XmpParserContext context;
+  RunBenchmarkCase("ReadXmpFromMemory/XmpParserContext", 0, corpus.size(),
+                   [&]() {
+    for (const string& jpeg : corpus) {
+      XmpData xmp_data;
+      CHECK(ReadXmpFromMemory(jpeg, kSkipExtended, &context, &xmp_data));
+    }
+  });
+}
+XMPMETA_BENCHMARK(BM_ReadPhotoSphereXmp);
+
+}  // namespace
+}  // namespace xmpmeta
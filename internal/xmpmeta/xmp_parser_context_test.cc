@@ -0,0 +1,111 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xmp_parser_context.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libxml/tree.h>
+
+#include "base/port.h"
+#include "gtest/gtest.h"
+#include "xmpmeta/test_util.h"
+#include "xmpmeta/test_xmp_creator.h"
+#include "xmpmeta/xmp_parser.h"
+#include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/utils.h"
+
+using xmpmeta::xml::DeserializerImpl;
+using xmpmeta::xml::GetFirstDescriptionElement;
+
+namespace xmpmeta {
+namespace {
+
+const char kXmpBody[] =
+    "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
+    "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+    "    <rdf:Description rdf:about=\"\"\n"
+    "      xmlns:GPano=\"http://ns.google.com/photos/1.0/panorama/\"\n"
+    "      GPano:CroppedAreaLeftPixels=\"10\"/>\n"
+    "  </rdf:RDF>\n"
+    "</x:xmpmeta>\n";
+
+const char kMalformedXml[] = "<x:xmpmeta><rdf:RDF></x:xmpmeta>";
+
+TEST(XmpParserContext, ReusesContextAndDictionary) {
+  XmpParserContext context;
+  const string xml = kXmpBody;
+  xmlDocPtr first =
+      context.ReadMemory(xml.data(), static_cast<int>(xml.size()), 0);
+  xmlDocPtr second =
+      context.ReadMemory(xml.data(), static_cast<int>(xml.size()), 0);
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+  EXPECT_EQ(context.Dictionary(), first->dict);
+  EXPECT_EQ(context.Dictionary(), second->dict);
+  EXPECT_EQ(xml::XmlDocToString(first), xml::XmlDocToString(second));
+  xmlFreeDoc(first);
+  xmlFreeDoc(second);
+}
+
+TEST(XmpParserContext, RecoversAfterMalformedDocument) {
+  XmpParserContext context;
+  const string malformed = kMalformedXml;
+  EXPECT_EQ(nullptr, context.ReadMemory(malformed.data(),
+                                        static_cast<int>(malformed.size()),
+                                        0));
+  const string xml = kXmpBody;
+  xmlDocPtr doc =
+      context.ReadMemory(xml.data(), static_cast<int>(xml.size()), 0);
+  ASSERT_NE(nullptr, doc);
+  xmlFreeDoc(doc);
+}
+
+TEST(XmpParserContext, DocumentsOutliveContext) {
+  const string xml = kXmpBody;
+  xmlDocPtr doc;
+  {
+    XmpParserContext context;
+    doc = context.ReadMemory(xml.data(), static_cast<int>(xml.size()), 0);
+  }
+  ASSERT_NE(nullptr, doc);
+  DeserializerImpl deserializer(GetFirstDescriptionElement(doc));
+  int value;
+  ASSERT_TRUE(deserializer.ParseInt("GPano", "CroppedAreaLeftPixels", &value));
+  EXPECT_EQ(10, value);
+  xmlFreeDoc(doc);
+}
+
+TEST(XmpParserContext, ReadXmpFromMemoryWithContext) {
+  std::vector<string> sections;
+  sections.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(sections);
+
+  XmpParserContext context;
+  for (int i = 0; i < 3; ++i) {
+    XmpData xmp_data;
+    ASSERT_TRUE(ReadXmpFromMemory(contents, false, &context, &xmp_data));
+    DeserializerImpl deserializer(
+        GetFirstDescriptionElement(xmp_data.StandardSection()));
+    int value;
+    ASSERT_TRUE(
+        deserializer.ParseInt("GPano", "CroppedAreaLeftPixels", &value));
+    EXPECT_EQ(10, value);
+  }
+}
+
+}  // namespace
+}  // namespace xmpmeta
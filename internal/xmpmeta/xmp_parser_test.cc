@@ -14,13 +14,17 @@
 
 #include "xmpmeta/xmp_parser.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/port.h"
 #include "gtest/gtest.h"
 #include "xmpmeta/test_util.h"
 #include "xmpmeta/test_xmp_creator.h"
+#include "xmpmeta/xmp_const.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/deserializer_impl.h"
 #include "xmpmeta/xml/utils.h"
@@ -58,7 +62,7 @@ const char* kAltXmpBody =
     "</x:xmpmeta>\n";
 
 // XMP extension test data.
-const char* kXmpExtensionHeaderPart2 = "123ABCxxxxxxxx";
+const char* kXmpExtensionHeaderPart2 = "123ABC";
 const char* kXmpExtensionBody =
     "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
     "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
@@ -265,5 +269,220 @@ TEST(XmpParser, ReadExtendedXmp) {
   ASSERT_EQ(string("9865"), value);
 }
 
+// Returns the standard XMP section followed by the given extended sections.
+std::vector<string> WithStandardSection(std::vector<string> sections) {
+  sections.insert(sections.begin(),
+                  TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  return sections;
+}
+
+TEST(XmpParser, ReadExtendedXmpOutOfOrder) {
+  std::vector<string> extended_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(3, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  std::swap(extended_sections[0], extended_sections[2]);
+  const string contents = TestXmpCreator::MakeJPEGFileContents(
+      WithStandardSection(extended_sections));
+
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpFromMemory(contents, false, &xmp_data));
+  string value;
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(xmp_data.ExtendedSection()));
+  ASSERT_TRUE(deserializer.ParseString("GImage", "Data", &value));
+  EXPECT_EQ(string("9865"), value);
+}
+
+TEST(XmpParser, ReadExtendedXmpWithMissingSection) {
+  std::vector<string> extended_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(3, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  extended_sections.erase(extended_sections.begin() + 1);
+  const string contents = TestXmpCreator::MakeJPEGFileContents(
+      WithStandardSection(extended_sections));
+
+  XmpData xmp_data;
+  EXPECT_FALSE(ReadXmpFromMemory(contents, false, &xmp_data));
+  EXPECT_EQ(nullptr, xmp_data.ExtendedSection());
+}
+
+TEST(XmpParser, ReadExtendedXmpWithOverlappingSections) {
+  std::vector<string> extended_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  extended_sections.push_back(extended_sections[1]);
+  const string contents = TestXmpCreator::MakeJPEGFileContents(
+      WithStandardSection(extended_sections));
+
+  XmpData xmp_data;
+  EXPECT_FALSE(ReadXmpFromMemory(contents, false, &xmp_data));
+}
+
+TEST(XmpParser, ReadExtendedXmpWithInconsistentLength) {
+  std::vector<string> extended_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  // Corrupt the low byte of the second section's declared total length.
+  const size_t length_position =
+      strlen(XmpConst::ExtensionHeader()) + 1 +
+      strlen(kXmpExtensionHeaderPart2) + 3;
+  extended_sections[1][length_position] ^= 1;
+  const string contents = TestXmpCreator::MakeJPEGFileContents(
+      WithStandardSection(extended_sections));
+
+  XmpData xmp_data;
+  EXPECT_FALSE(ReadXmpFromMemory(contents, false, &xmp_data));
+}
+
+TEST(XmpParser, ReadXmpHeaderLazily) {
+  const string filename = TempFileAbsolutePath("test.jpg");
+  TestXmpCreator::WriteJPEGFile(
+      filename, WithStandardSection(TestXmpCreator::CreateExtensionXmpStrings(
+                    2, kXmpExtensionHeaderPart2, kXmpExtensionBody)));
+
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeaderLazily(filename, &xmp_data));
+  ASSERT_NE(nullptr, xmp_data.StandardSection());
+  EXPECT_TRUE(xmp_data.HasExtendedSection());
+
+  string value;
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(xmp_data.ExtendedSection()));
+  ASSERT_TRUE(deserializer.ParseString("GImage", "Data", &value));
+  EXPECT_EQ(string("9865"), value);
+}
+
+TEST(XmpParser, ReadXmpHeaderLazilyWithoutExtendedSection) {
+  const string filename = TempFileAbsolutePath("test.jpg");
+  TestXmpCreator::WriteJPEGFile(
+      filename, {TestXmpCreator::CreateStandardXmpString(kAltXmpBody)});
+
+  XmpData xmp_data;
+  // The standard section names an extended section that is not in the file.
+  EXPECT_FALSE(ReadXmpHeaderLazily(filename, &xmp_data));
+
+  const char* body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
+      "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+      "    <rdf:Description rdf:about=\"\"/>\n"
+      "  </rdf:RDF>\n"
+      "</x:xmpmeta>\n";
+  TestXmpCreator::WriteJPEGFile(
+      filename, {TestXmpCreator::CreateStandardXmpString(body)});
+  ASSERT_TRUE(ReadXmpHeaderLazily(filename, &xmp_data));
+  EXPECT_NE(nullptr, xmp_data.StandardSection());
+  EXPECT_FALSE(xmp_data.HasExtendedSection());
+  EXPECT_EQ(nullptr, xmp_data.ExtendedSection());
+}
+
+TEST(XmpParser, ReadXmpHeaderLazilyWithMalformedExtendedXml) {
+  const string filename = TempFileAbsolutePath("test.jpg");
+  TestXmpCreator::WriteJPEGFile(
+      filename, WithStandardSection(TestXmpCreator::CreateExtensionXmpStrings(
+                    2, kXmpExtensionHeaderPart2, kXmpMalformedBody)));
+
+  XmpData xmp_data;
+  // Only the section layout is checked up front.
+  ASSERT_TRUE(ReadXmpHeaderLazily(filename, &xmp_data));
+  EXPECT_TRUE(xmp_data.HasExtendedSection());
+  EXPECT_EQ(nullptr, xmp_data.ExtendedSection());
+  EXPECT_FALSE(xmp_data.HasExtendedSection());
+}
+
+// Writes a JPEG file with the standard section and the given extended body
+// split over num_sections sections, in reverse order.
+string WriteFileWithExtendedBody(int num_sections, const char* body) {
+  const string filename = TempFileAbsolutePath("test.jpg");
+  std::vector<string> extended_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(
+          num_sections, kXmpExtensionHeaderPart2, body);
+  std::reverse(extended_sections.begin(), extended_sections.end());
+  TestXmpCreator::WriteJPEGFile(filename,
+                                WithStandardSection(extended_sections));
+  return filename;
+}
+
+// Returns a sink that appends to output.
+DataSink AppendTo(string* output) {
+  return [output](const char* data, size_t size) {
+    output->append(data, size);
+    return true;
+  };
+}
+
+TEST(XmpParser, ReadExtendedXmpBase64PropertyFromAttribute) {
+  const char* body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
+      "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+      "    <rdf:Description rdf:about=\"\"\n"
+      "      xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\"\n"
+      "      GImage:Mime=\"image/jpeg\"\n"
+      "      GImage:Data = \"ZXh0ZW5kZWQgZGF0YQ==\"/>\n"
+      "  </rdf:RDF>\n"
+      "</x:xmpmeta>\n";
+  const string filename = WriteFileWithExtendedBody(7, body);
+
+  string data;
+  ASSERT_TRUE(ReadExtendedXmpBase64Property(filename, "GImage", "Data",
+                                            AppendTo(&data)));
+  EXPECT_EQ("extended data", data);
+}
+
+TEST(XmpParser, ReadExtendedXmpBase64PropertyFromElement) {
+  const char* body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
+      "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+      "    <rdf:Description rdf:about=\"\"\n"
+      "      xmlns:GAudio=\"http://ns.google.com/photos/1.0/audio/\">\n"
+      "      <GAudio:Mime>audio/mp4</GAudio:Mime>\n"
+      "      <GAudio:Data>ZXh0ZW5kZWQg\n  ZGF0YQ</GAudio:Data>\n"
+      "    </rdf:Description>\n"
+      "  </rdf:RDF>\n"
+      "</x:xmpmeta>\n";
+  const string filename = WriteFileWithExtendedBody(5, body);
+
+  string data;
+  ASSERT_TRUE(ReadExtendedXmpBase64Property(filename, "GAudio", "Data",
+                                            AppendTo(&data)));
+  EXPECT_EQ("extended data", data);
+}
+
+TEST(XmpParser, ReadExtendedXmpBase64PropertyIgnoresMarkupLookalikes) {
+  const char* body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
+      "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+      "    <!-- <GImage:Data>bm90IHRoaXM=</GImage:Data> -->\n"
+      "    <rdf:Description rdf:about=\"\"\n"
+      "      xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\"\n"
+      "      GImage:Mime=\"a/> GImage:Data='bm90IHRoaXM='\"\n"
+      "      GImage:Data=\"ZXh0ZW5kZWQgZGF0YQ==\"/>\n"
+      "  </rdf:RDF>\n"
+      "</x:xmpmeta>\n";
+  const string filename = WriteFileWithExtendedBody(3, body);
+
+  string data;
+  ASSERT_TRUE(ReadExtendedXmpBase64Property(filename, "GImage", "Data",
+                                            AppendTo(&data)));
+  EXPECT_EQ("extended data", data);
+}
+
+TEST(XmpParser, ReadExtendedXmpBase64PropertyMissing) {
+  const string filename = WriteFileWithExtendedBody(2, kXmpExtensionBody);
+
+  string data;
+  EXPECT_FALSE(ReadExtendedXmpBase64Property(filename, "GAudio", "Data",
+                                             AppendTo(&data)));
+  EXPECT_FALSE(ReadExtendedXmpBase64Property(filename, "GImage", "Mime",
+                                             AppendTo(&data)));
+  EXPECT_TRUE(data.empty());
+}
+
+TEST(XmpParser, ReadExtendedXmpBase64PropertySinkFailure) {
+  const string filename = WriteFileWithExtendedBody(2, kXmpExtensionBody);
+  EXPECT_FALSE(ReadExtendedXmpBase64Property(
+      filename, "GImage", "Data",
+      [](const char* data, size_t size) { return false; }));
+}
+
 }  // namespace
 }  // namespace xmpmeta
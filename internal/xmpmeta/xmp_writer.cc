@@ -14,9 +14,13 @@
 
 #include "xmpmeta/xmp_writer.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
-#include <sstream>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <libxml/tree.h>
@@ -25,6 +29,7 @@
 
 #include "glog/logging.h"
 #include "strings/util.h"
+#include "xmpmeta/file.h"
 #include "xmpmeta/jpeg_io.h"
 #include "xmpmeta/md5.h"
 #include "xmpmeta/xmp_const.h"
@@ -42,10 +47,12 @@ namespace {
 
 const char kXmlStartTag = '<';
 
-const char kCEmptyString[] = "\x00";
 const int kXmlDumpFormat = 1;
 const int kInvalidIndex = -1;
 
+// XMP packet padding is whitespace, with a newline every 100 bytes.
+const size_t kPaddingLineLength = 100;
+
 // Creates the outer rdf:RDF node for XMP.
 xmlNodePtr CreateXmpRdfNode() {
   xmlNodePtr rdf_node =
@@ -96,13 +103,6 @@ xmlDocPtr CreateXmpSection() {
   return xmp_meta;
 }
 
-void WriteIntTo4Bytes(int integer, std::ostream* output_stream) {
-  output_stream->put((integer >> 24) & 0xff);
-  output_stream->put((integer >> 16) & 0xff);
-  output_stream->put((integer >> 8) & 0xff);
-  output_stream->put(integer & 0xff);
-}
-
 // Serializes an XML document to a string.
 void SerializeMeta(const xmlDocPtr parent, string* serialized_value) {
   if (parent == nullptr || parent->children == nullptr) {
@@ -111,7 +111,6 @@ void SerializeMeta(const xmlDocPtr parent, string* serialized_value) {
     return;
   }
 
-  std::ostringstream serialized_stream;
   xmlChar* xml_doc_contents;
   int doc_size = 0;
   xmlDocDumpFormatMemoryEnc(parent, &xml_doc_contents, &doc_size,
@@ -124,99 +123,180 @@ void SerializeMeta(const xmlDocPtr parent, string* serialized_value) {
   const int xmp_start_idx =
       static_cast<int>(strchr(&xml_doc_string[2],
                               kXmlStartTag) - xml_doc_string) - 1;
-  serialized_stream.write(&xml_doc_string[xmp_start_idx],
-                          doc_size - xmp_start_idx);
+  serialized_value->assign(&xml_doc_string[xmp_start_idx],
+                           doc_size - xmp_start_idx);
   xmlFree(xml_doc_contents);
-  *serialized_value = serialized_stream.str();
-}
-
-// TODO(miraleung): Switch to different library for Android if needed.
-const string GetGUID(const string& to_hash) {
-  return MD5Hash(to_hash);
 }
 
-// Creates the standard XMP section.
-void CreateStandardSectionXmpString(const string& buffer, string* value) {
-  std::ostringstream data_stream;
-  data_stream.write(XmpConst::Header(), strlen(XmpConst::Header()));
-  data_stream.write(kCEmptyString, 1);
-  data_stream.write(buffer.c_str(), buffer.length());
-  *value = data_stream.str();
-}
+// The new XMP sections of a JPEG file. The serialized XMP is not copied into
+// the sections: each section is written as a header followed by a slice of an
+// XMP packet, and the headers of all the sections share one buffer.
+class XmpSections {
+ public:
+  XmpSections() = default;
+
+  // Builds the sections for the given standard and extended XMP packets,
+  // which must outlive this object. extended_guid is the MD5 of
+  // extended_buffer, and is unused if extended_buffer is empty.
+  bool Init(const string& main_buffer, const string& extended_buffer,
+            const string& extended_guid);
+
+  // Same as Init, but moves the packets into this object.
+  bool Adopt(string* main_buffer, string* extended_buffer,
+             const string& extended_guid);
+
+  // Returns the number of sections; the first one holds the standard XMP.
+  size_t size() const { return sections_.size(); }
+
+  // Returns the GUID of the extended sections.
+  const string& extended_guid() const { return extended_guid_; }
+
+  // Returns the data length of a section.
+  size_t Length(size_t index) const;
+
+  // Returns a copy of the data of a section.
+  string Data(size_t index) const;
+
+  // Writes all the sections, including their markers and lengths.
+  void Write(std::ostream* output_stream) const;
+
+ private:
+  struct Part {
+    size_t header_offset;
+    size_t header_length;
+    const char* data;
+    size_t data_length;
+  };
+
+  // Appends a section, whose header is everything appended to headers_ since
+  // header_offset.
+  void AddSection(size_t header_offset, const char* data, size_t length);
+
+  // Appends integer to headers_ as 4 big-endian bytes.
+  void AppendIntTo4Bytes(int integer);
+
+  string headers_;
+  std::vector<Part> sections_;
+  string extended_guid_;
+  string owned_main_buffer_;
+  string owned_extended_buffer_;
+
+  XmpSections(const XmpSections&) = delete;
+  void operator=(const XmpSections&) = delete;
+};
+
+bool XmpSections::Init(const string& main_buffer,
+                       const string& extended_buffer,
+                       const string& extended_guid) {
+  if (main_buffer.empty()) {
+    LOG(WARNING) << "Main section was empty";
+    return false;
+  }
+  if (main_buffer.length() > XmpConst::MaxBufferSize()) {
+    LOG(WARNING) << "The standard XMP section (at size " << main_buffer.length()
+                 << ") cannot have a size larger than "
+                 << XmpConst::MaxBufferSize() << " bytes";
+    return false;
+  }
 
-// Creates the extended XMP section.
-void CreateExtendedSections(const string& buffer,
-                            std::vector<Section>* extended_sections) {
-  string guid = GetGUID(buffer);
   // Increment by 1 for the null byte in the middle.
+  const size_t main_header_length = strlen(XmpConst::Header()) + 1;
   const int header_length =
       static_cast<int>(strlen(XmpConst::ExtensionHeader()) + 1 +
-                       guid.length());
-  const int buffer_length = static_cast<int>(buffer.length());
+                       extended_guid.length());
+  const int buffer_length = static_cast<int>(extended_buffer.length());
   const int overhead = header_length + XmpConst::ExtensionHeaderOffset();
-  const int num_sections =
+  const int num_extended_sections = extended_buffer.empty() ? 0 :
       buffer_length / (XmpConst::ExtendedMaxBufferSize() - overhead) + 1;
-  for (int i = 0, position = 0; i < num_sections; ++i) {
+
+  // Reserve all the headers up front; Part refers to them by offset anyway.
+  headers_.clear();
+  headers_.reserve(main_header_length +
+                   static_cast<size_t>(num_extended_sections) * overhead);
+  sections_.clear();
+  sections_.reserve(1 + num_extended_sections);
+  extended_guid_ = extended_guid;
+
+  headers_.append(XmpConst::Header(), main_header_length);
+  AddSection(0, main_buffer.data(), main_buffer.length());
+
+  for (int i = 0, position = 0; i < num_extended_sections; ++i) {
     const int section_size =
         std::min(static_cast<int>(buffer_length - position + overhead),
                  XmpConst::ExtendedMaxBufferSize());
     const int bytes_from_buffer = section_size - overhead;
 
-    // Header and GUID.
-    std::ostringstream data_stream;
-    data_stream.write(XmpConst::ExtensionHeader(),
-                      strlen(XmpConst::ExtensionHeader()));
-    data_stream.write(kCEmptyString, 1);
-    data_stream.write(guid.c_str(), guid.length());
-
-    // Total buffer length.
-    WriteIntTo4Bytes(buffer_length, &data_stream);
-    // Current position.
-    WriteIntTo4Bytes(position, &data_stream);
-    // Data
-    data_stream.write(&buffer[position], bytes_from_buffer);
+    // Header and GUID, total buffer length and current position.
+    const size_t header_offset = headers_.size();
+    headers_.append(XmpConst::ExtensionHeader(),
+                    strlen(XmpConst::ExtensionHeader()) + 1);
+    headers_.append(extended_guid);
+    AppendIntTo4Bytes(buffer_length);
+    AppendIntTo4Bytes(position);
+    AddSection(header_offset, &extended_buffer[position], bytes_from_buffer);
     position += bytes_from_buffer;
+  }
+  return true;
+}
 
-    extended_sections->push_back(Section(data_stream.str()));
+bool XmpSections::Adopt(string* main_buffer, string* extended_buffer,
+                        const string& extended_guid) {
+  owned_main_buffer_.swap(*main_buffer);
+  owned_extended_buffer_.swap(*extended_buffer);
+  return Init(owned_main_buffer_, owned_extended_buffer_, extended_guid);
+}
+
+size_t XmpSections::Length(size_t index) const {
+  const Part& part = sections_[index];
+  return part.header_length + part.data_length;
+}
+
+string XmpSections::Data(size_t index) const {
+  const Part& part = sections_[index];
+  string data;
+  data.reserve(part.header_length + part.data_length);
+  data.append(headers_, part.header_offset, part.header_length);
+  data.append(part.data, part.data_length);
+  return data;
+}
+
+void XmpSections::Write(std::ostream* output_stream) const {
+  for (const Part& part : sections_) {
+    WriteApp1Section(&headers_[part.header_offset], part.header_length,
+                     part.data, part.data_length, output_stream);
   }
 }
 
-int InsertStandardXMPSection(const string& buffer,
-                             std::vector<Section>* sections) {
-    if (buffer.length() > XmpConst::MaxBufferSize()) {
-    LOG(WARNING) << "The standard XMP section (at size " << buffer.length()
-                 << ") cannot have a size larger than "
-                 << XmpConst::MaxBufferSize() << " bytes";
-    return kInvalidIndex;
-  }
-  string value;
-  CreateStandardSectionXmpString(buffer, &value);
-  Section xmp_section(value);
-  // If we can find the old XMP section, replace it with the new one
-  for (int index = 0; index < sections->size(); ++index) {
-    if (sections->at(index).IsMarkerApp1() &&
-        HasPrefixString(sections->at(index).data, XmpConst::Header())) {
-      // Replace with the new XMP data.
-      sections->at(index) = xmp_section;
+void XmpSections::AddSection(size_t header_offset, const char* data,
+                             size_t length) {
+  sections_.push_back(
+      {header_offset, headers_.size() - header_offset, data, length});
+}
+
+void XmpSections::AppendIntTo4Bytes(int integer) {
+  headers_.push_back(static_cast<char>((integer >> 24) & 0xff));
+  headers_.push_back(static_cast<char>((integer >> 16) & 0xff));
+  headers_.push_back(static_cast<char>((integer >> 8) & 0xff));
+  headers_.push_back(static_cast<char>(integer & 0xff));
+}
+
+// Returns the index at which the standard XMP section goes in the list of
+// JPEG sections. replace is set to true if it replaces the old XMP section
+// at that index.
+size_t FindStandardXmpPosition(const std::vector<SectionView>& sections,
+                               bool* replace) {
+  // If we can find the old XMP section, replace it with the new one.
+  for (size_t index = 0; index < sections.size(); ++index) {
+    if (sections[index].IsMarkerApp1() &&
+        sections[index].HasPrefix(XmpConst::Header())) {
+      *replace = true;
       return index;
     }
   }
   // If the first section is EXIF, insert XMP data after it.
   // Otherwise, make XMP data the first section.
-  const int position =
-      (!sections->empty() && sections->at(0).IsMarkerApp1()) ? 1 : 0;
-  sections->emplace(sections->begin() + position, xmp_section);
-  return position;
-}
-
-// Position is the index in the Section vector where the extended sections
-// will be inserted.
-void InsertExtendedXMPSections(const string& buffer, int position,
-                               std::vector<Section>* sections) {
-  std::vector<Section> extended_sections;
-  CreateExtendedSections(buffer, &extended_sections);
-  sections->insert(sections->begin() + position, extended_sections.begin(),
-                  extended_sections.end());
+  *replace = false;
+  return (!sections.empty() && sections[0].IsMarkerApp1()) ? 1 : 0;
 }
 
 // Returns true if the respective sections in xmp_data and their serialized
@@ -236,30 +316,7 @@ bool XmpSectionsAndSerializedDataValid(const XmpData& xmp_data,
   return is_valid;
 }
 
-// Updates a list of JPEG sections with serialized XMP data.
-bool UpdateSections(const string& main_buffer, const string& extended_buffer,
-                    std::vector<Section>* sections) {
-  if (main_buffer.empty()) {
-    LOG(WARNING) << "Main section was empty";
-    return false;
-  }
-
-  // Update the list of sections with the new standard XMP section.
-  const int main_index = InsertStandardXMPSection(main_buffer, sections);
-  if (main_index < 0) {
-    LOG(WARNING) << "Could not find a valid index for inserting the "
-                 << "standard sections";
-    return false;
-  }
-
-  // Insert the extended section right after the main section.
-  if (!extended_buffer.empty()) {
-    InsertExtendedXMPSections(extended_buffer, main_index + 1, sections);
-  }
-  return true;
-}
-
-void LinkXmpStandardAndExtendedSections(const string& extended_buffer,
+void LinkXmpStandardAndExtendedSections(const string& extended_guid,
                                         xmlDocPtr standard_section) {
   xmlNodePtr description_node =
       xml::GetFirstDescriptionElement(standard_section);
@@ -267,14 +324,209 @@ void LinkXmpStandardAndExtendedSections(const string& extended_buffer,
       xmlNewNs(description_node,
                ToXmlChar(XmpConst::NoteNamespace()),
                ToXmlChar(XmpConst::HasExtensionPrefix()));
-  const string extended_id = GetGUID(extended_buffer);
   xmlSetNsProp(description_node, xmp_note_ns_ptr,
                ToXmlChar(XmpConst::HasExtension()),
-               ToXmlChar(extended_id.c_str()));
+               ToXmlChar(extended_guid.c_str()));
   xmlUnsetProp(description_node,
                ToXmlChar(XmpConst::HasExtension()));
 }
 
+// Returns the GUID that a serialized standard XMP packet links to its
+// extended packet with, or an empty string if it has none.
+string FindExtendedGuid(const string& main_buffer) {
+  const string attribute = string(XmpConst::HasExtensionPrefix()) + ":" +
+      XmpConst::HasExtension() + "=\"";
+  const size_t start = main_buffer.find(attribute);
+  if (start == string::npos) {
+    return "";
+  }
+  const size_t value_start = start + attribute.size();
+  const size_t value_end = main_buffer.find('"', value_start);
+  if (value_end == string::npos) {
+    return "";
+  }
+  return main_buffer.substr(value_start, value_end - value_start);
+}
+
+// Serializes xmp_data into new standard and extended XMP sections. The
+// extended section is hashed once, for both the link from the standard
+// section and the headers of the extended sections.
+bool CreateXmpSections(const XmpData& xmp_data, XmpSections* xmp_sections) {
+  string extended_buffer;
+  string extended_guid;
+  if (xmp_data.ExtendedSection() != nullptr) {
+    SerializeMeta(xmp_data.ExtendedSection(), &extended_buffer);
+    extended_guid = MD5Hash(extended_buffer);
+    LinkXmpStandardAndExtendedSections(extended_guid,
+                                       xmp_data.StandardSection());
+  }
+  string main_buffer;
+  SerializeMeta(xmp_data.StandardSection(), &main_buffer);
+  if (!XmpSectionsAndSerializedDataValid(xmp_data, main_buffer,
+                                         extended_buffer)) {
+    return false;
+  }
+  return xmp_sections->Adopt(&main_buffer, &extended_buffer, extended_guid);
+}
+
+// Returns true if the section holds standard or extended XMP data.
+bool IsXmpSection(const SectionView& section) {
+  return section.IsMarkerApp1() &&
+      (section.HasPrefix(XmpConst::Header()) ||
+       section.HasPrefix(XmpConst::ExtensionHeader()));
+}
+
+// Writes sections to output_stream, with xmp_sections placed as
+// FindStandardXmpPosition decides.
+void WriteSectionsWithXmp(const std::vector<SectionView>& sections,
+                          const XmpSections& xmp_sections,
+                          std::ostream* output_stream) {
+  bool replace;
+  const size_t xmp_position = FindStandardXmpPosition(sections, &replace);
+  for (size_t i = 0; i < sections.size(); ++i) {
+    if (i == xmp_position) {
+      xmp_sections.Write(output_stream);
+      if (replace) {
+        continue;
+      }
+    }
+    WriteSection(sections[i], output_stream);
+  }
+  if (xmp_position == sections.size()) {
+    xmp_sections.Write(output_stream);
+  }
+}
+
+// Copies the metadata sections read by reader to output_jpeg_stream, dropping
+// all the existing XMP sections and writing xmp_sections in place of the old
+// standard section, as the in-memory writer does. Sections are held in memory
+// only until the old standard section is found; the rest are streamed.
+void StreamSectionsWithXmp(const XmpSections& xmp_sections,
+                           SectionReader* reader,
+                           std::ostream* output_jpeg_stream) {
+  WriteStartOfImage(output_jpeg_stream);
+  std::vector<Section> leading_sections;
+  Section section;
+  while (reader->Next(&section)) {
+    const SectionView view(section);
+    const bool is_standard_xmp =
+        view.IsMarkerApp1() && view.HasPrefix(XmpConst::Header());
+    if (IsXmpSection(view) && !is_standard_xmp) {
+      continue;
+    }
+    leading_sections.push_back(std::move(section));
+    if (is_standard_xmp) {
+      break;
+    }
+  }
+  // The views are taken once the vector no longer moves its sections.
+  const std::vector<SectionView> views(leading_sections.begin(),
+                                       leading_sections.end());
+  WriteSectionsWithXmp(views, xmp_sections, output_jpeg_stream);
+  while (reader->Next(&section)) {
+    const SectionView view(section);
+    if (!IsXmpSection(view)) {
+      WriteSection(view, output_jpeg_stream);
+    }
+  }
+}
+
+// Writes the JPEG read from input_jpeg_stream, with xmp_sections in place of
+// its XMP sections, to output_jpeg_stream.
+bool WriteJpegStreamWithXmp(const XmpSections& xmp_sections,
+                            std::istream* input_jpeg_stream,
+                            std::ostream* output_jpeg_stream) {
+  SectionReader reader(input_jpeg_stream);
+  StreamSectionsWithXmp(xmp_sections, &reader, output_jpeg_stream);
+  if (reader.AtScanData() && !reader.CopyScanData(output_jpeg_stream)) {
+    LOG(ERROR) << "Could not write the image data";
+    return false;
+  }
+  return true;
+}
+
+// Writes the JPEG in input_filename, with xmp_sections in place of its XMP
+// sections, to output_filename.
+bool WriteJpegFileWithXmp(const string& input_filename,
+                          const XmpSections& xmp_sections,
+                          const string& output_filename) {
+  std::ifstream input_jpeg_stream(input_filename.c_str(), std::ios::binary);
+  if (!input_jpeg_stream.is_open()) {
+    LOG(ERROR) << "Could not read file: " << input_filename;
+    return false;
+  }
+  std::ofstream output_jpeg_stream(output_filename.c_str(),
+                                   std::ios::binary | std::ios::trunc);
+  if (!output_jpeg_stream.is_open()) {
+    LOG(ERROR) << "Could not write to file: " << output_filename;
+    return false;
+  }
+
+  SectionReader reader(&input_jpeg_stream);
+  StreamSectionsWithXmp(xmp_sections, &reader, &output_jpeg_stream);
+  if (!reader.AtScanData()) {
+    output_jpeg_stream.close();
+    return !output_jpeg_stream.fail();
+  }
+  // Write the start of scan marker, then let the file layer copy the image
+  // data directly between the files.
+  WriteStartOfScan(&output_jpeg_stream);
+  output_jpeg_stream.close();
+  if (output_jpeg_stream.fail()) {
+    LOG(ERROR) << "Could not write to file: " << output_filename;
+    return false;
+  }
+  return AppendFileRange(input_filename, reader.Position(), output_filename);
+}
+
+// Finds the existing standard XMP section of a JPEG file, if the new standard
+// section fits in it and the file's extended sections, if any, are exactly the
+// new ones.
+// Sets offset and length to the location of the section's data in the file.
+bool FindXmpSlot(const string& filename,
+                 const XmpSections& xmp_sections, size_t* offset,
+                 size_t* length) {
+  std::unique_ptr<SectionIndex> index = SectionIndex::FromFile(filename);
+  if (index == nullptr) {
+    return false;
+  }
+  const std::vector<SectionView> standard_sections =
+      index->FindApp1Sections(XmpConst::Header());
+  if (standard_sections.empty() ||
+      standard_sections[0].length < xmp_sections.Length(0)) {
+    return false;
+  }
+  // The extended sections are named by the MD5 of their content, so the file
+  // holds the same extended data if it has as many sections, all with the
+  // new GUID. Old extended sections that the new standard section does not
+  // refer to must be removed, which takes a rewrite.
+  const string extended_prefix = string(XmpConst::ExtensionHeader()) + '\0';
+  const std::vector<SectionView> extended_sections =
+      index->FindApp1Sections(extended_prefix);
+  if (extended_sections.size() != xmp_sections.size() - 1) {
+    return false;
+  }
+  for (const SectionView& section : extended_sections) {
+    if (!section.HasPrefix(extended_prefix + xmp_sections.extended_guid())) {
+      return false;
+    }
+  }
+  *offset = standard_sections[0].offset;
+  *length = standard_sections[0].length;
+  return true;
+}
+
+// Appends XMP packet padding to data until it is length bytes long. Parsers
+// ignore whitespace after the root element.
+void PadXmpPacket(size_t length, string* data) {
+  const size_t content_length = data->size();
+  data->resize(length, ' ');
+  for (size_t i = content_length + kPaddingLineLength - 1; i < length;
+       i += kPaddingLineLength) {
+    (*data)[i] = '\n';
+  }
+}
+
 }  // namespace
 
 std::unique_ptr<XmpData> CreateXmpData(bool create_extended) {
@@ -288,31 +540,22 @@ std::unique_ptr<XmpData> CreateXmpData(bool create_extended) {
 
 bool WriteLeftEyeAndXmpMeta(const string& left_data, const string& filename,
                             const XmpData& xmp_data) {
-  std::istringstream input_jpeg_stream(left_data);
+  // Index the sections of the input image; their data is not copied.
+  std::unique_ptr<SectionIndex> index =
+      SectionIndex::FromBuffer(left_data.data(), left_data.size());
+  const std::vector<SectionView>& sections = index->Sections();
 
-  // Get a list of sections from the input stream.
-  ParseOptions parse_options;
-  std::vector<Section> sections = Parse(parse_options, &input_jpeg_stream);
-
-  string extended_buffer;
-  if (xmp_data.ExtendedSection() != nullptr) {
-    SerializeMeta(xmp_data.ExtendedSection(), &extended_buffer);
-    LinkXmpStandardAndExtendedSections(extended_buffer,
-                                       xmp_data.StandardSection());
-  }
-  string main_buffer;
-  SerializeMeta(xmp_data.StandardSection(), &main_buffer);
-
-  // Update the input sections with the XMP data.
-  if (!XmpSectionsAndSerializedDataValid(xmp_data, main_buffer, extended_buffer)
-      || !UpdateSections(main_buffer, extended_buffer, &sections)) {
+  XmpSections xmp_sections;
+  if (!CreateXmpSections(xmp_data, &xmp_sections)) {
     return false;
   }
 
-  // Write the sections to the output stream.
+  // Write the sections to the output stream, with the new XMP sections in
+  // place of the old standard XMP section.
   std::ofstream output_jpeg_stream;
   output_jpeg_stream.open(filename, std::ostream::out);
-  WriteSections(sections, &output_jpeg_stream);
+  WriteStartOfImage(&output_jpeg_stream);
+  WriteSectionsWithXmp(sections, xmp_sections, &output_jpeg_stream);
   output_jpeg_stream.close();
   return true;
 }
@@ -320,26 +563,84 @@ bool WriteLeftEyeAndXmpMeta(const string& left_data, const string& filename,
 bool AddXmpMetaToJpegStream(std::istream* input_jpeg_stream,
                             const XmpData& xmp_data,
                             std::ostream* output_jpeg_stream) {
-  // Get a list of sections from the input stream.
-  ParseOptions parse_options;
-  std::vector<Section> sections = Parse(parse_options, input_jpeg_stream);
+  XmpSections xmp_sections;
+  if (!CreateXmpSections(xmp_data, &xmp_sections)) {
+    return false;
+  }
+  return WriteJpegStreamWithXmp(xmp_sections, input_jpeg_stream,
+                                output_jpeg_stream);
+}
 
-  string extended_buffer;
-  if (xmp_data.ExtendedSection() != nullptr) {
-    SerializeMeta(xmp_data.ExtendedSection(), &extended_buffer);
-    LinkXmpStandardAndExtendedSections(extended_buffer,
-                                       xmp_data.StandardSection());
+bool AddXmpPacketsToJpegStream(std::istream* input_jpeg_stream,
+                               const string& standard_xmp,
+                               const string& extended_xmp,
+                               std::ostream* output_jpeg_stream) {
+  // The standard packet already holds the MD5 of the extended packet, so it
+  // is not hashed again.
+  string extended_guid;
+  if (!extended_xmp.empty()) {
+    extended_guid = FindExtendedGuid(standard_xmp);
+    if (extended_guid.empty()) {
+      LOG(ERROR) << "The standard XMP packet does not link the extended one";
+      return false;
+    }
   }
-  string main_buffer;
-  SerializeMeta(xmp_data.StandardSection(), &main_buffer);
+  XmpSections xmp_sections;
+  if (!xmp_sections.Init(standard_xmp, extended_xmp, extended_guid)) {
+    return false;
+  }
+  return WriteJpegStreamWithXmp(xmp_sections, input_jpeg_stream,
+                                output_jpeg_stream);
+}
 
-  // Update the input sections with the XMP data.
-  if (!XmpSectionsAndSerializedDataValid(xmp_data, main_buffer, extended_buffer)
-      || !UpdateSections(main_buffer, extended_buffer, &sections)) {
+bool AddXmpMetaToJpegFile(const string& input_filename,
+                          const XmpData& xmp_data,
+                          const string& output_filename) {
+  if (input_filename == output_filename) {
+    LOG(ERROR) << "Input and output files must differ: " << input_filename;
     return false;
   }
+  XmpSections xmp_sections;
+  if (!CreateXmpSections(xmp_data, &xmp_sections)) {
+    return false;
+  }
+  return WriteJpegFileWithXmp(input_filename, xmp_sections, output_filename);
+}
 
-  WriteSections(sections, output_jpeg_stream);
+bool UpdateXmpMetaInJpegFile(const string& filename,
+                             const XmpData& xmp_data) {
+  XmpSections xmp_sections;
+  if (!CreateXmpSections(xmp_data, &xmp_sections)) {
+    return false;
+  }
+
+  size_t offset = 0;
+  size_t length = 0;
+  if (FindXmpSlot(filename, xmp_sections, &offset, &length)) {
+    string data = xmp_sections.Data(0);
+    PadXmpPacket(length, &data);
+    if (WriteFileRange(filename, offset, data)) {
+      return true;
+    }
+    // The rewrite below drops the old standard section, so a partial write
+    // does not leave the file corrupt.
+    LOG(WARNING) << "Could not update " << filename << " in place";
+  }
+
+  // Rewrite the whole file next to the original, then replace it.
+  string temp_filename;
+  if (!CreateTempFileNextTo(filename, &temp_filename)) {
+    return false;
+  }
+  if (!WriteJpegFileWithXmp(filename, xmp_sections, temp_filename)) {
+    std::remove(temp_filename.c_str());
+    return false;
+  }
+  if (std::rename(temp_filename.c_str(), filename.c_str()) != 0) {
+    LOG(ERROR) << "Could not replace " << filename;
+    std::remove(temp_filename.c_str());
+    return false;
+  }
   return true;
 }
 
@@ -15,13 +15,19 @@
 #include "xmpmeta/xmp_writer.h"
 
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif  // _WIN32
+
 #include <libxml/tree.h>
 
 #include "base/port.h"
 #include "xmpmeta/file.h"
+#include "xmpmeta/jpeg_io.h"
 #include "xmpmeta/test_util.h"
 #include "xmpmeta/test_xmp_creator.h"
 #include "xmpmeta/xmp_const.h"
@@ -40,7 +46,7 @@ namespace xmpmeta {
 namespace {
 
 // TODO(miraleung): Add check for buffer length and position in header of
-// extended XMP, here and in parser.
+// extended XMP.
 
 const char kDataName[] = "Data";
 const char kDataValue[] = "9865";
@@ -69,7 +75,7 @@ const char kXmpBody[] =
 
 // XMP extension test data.
 const char kXmpExtensionHeaderPart2[] =
-    "c5247828a5155031a73ef9faeeb31391xxxxxxxx";
+    "c5247828a5155031a73ef9faeeb31391";
 const char kXmpExtensionBody[] =
     "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
     "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
@@ -92,7 +98,7 @@ const char kXdmBody[] =
     "</x:xmpmeta>\n";
 
 const char kXdmExtensionHeaderPart2[] =
-    "a1a13d8dc9a1e69ad632d16906eb02aexxxxxxxx";
+    "a1a13d8dc9a1e69ad632d16906eb02ae";
 const char kXdmExtensionBody[] =
     "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
     "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\"\n"
@@ -164,6 +170,18 @@ void ClearAndSetProperty(XmpData* xmp_data, bool set_property_on_extended,
              ToXmlChar(property_value.c_str()));
 }
 
+// Sets GImage:Mime on the standard section.
+void SetMimeProperty(const string& value, XmpData* xmp_data) {
+  xmlNodePtr description_node =
+      GetFirstDescriptionElement(*xmp_data->MutableStandardSection());
+  ASSERT_TRUE(description_node != nullptr);
+  xmlNsPtr ns = xmlSearchNs(description_node->doc, description_node,
+                            ToXmlChar(kPrefix));
+  ASSERT_TRUE(ns != nullptr);
+  xmlSetNsProp(description_node, ns, ToXmlChar(kMimeName),
+               ToXmlChar(value.c_str()));
+}
+
 // xmp_string includes both the standard and extended sections.
 int NumExtendedSections(const string& xmp_string) {
   int num_extended_sections = 0;
@@ -561,5 +579,238 @@ TEST(XmpWriter, WriteXmpExtendedSectionLimits) {
   ASSERT_EQ(10, NumExtendedSections(xmp_from_file));
 }
 
+// Returns JPEG contents with an EXIF section followed by a standard and two
+// extended XMP sections.
+string MakeJpegWithExifAndXmp() {
+  std::vector<string> sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  sections.insert(sections.begin(),
+                  TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  string exif("Exif");
+  exif.append(2, '\0');
+  exif.append("fake exif data");
+  sections.insert(sections.begin(), exif);
+  return TestXmpCreator::MakeJPEGFileContents(sections);
+}
+
+TEST(XmpWriter, AddXmpMetaToJpegStreamReplacesXmpSections) {
+  const string contents = MakeJpegWithExifAndXmp();
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpFromMemory(contents, false, &xmp_data));
+
+  std::istringstream input_stream(contents);
+  std::ostringstream output_stream;
+  ASSERT_TRUE(AddXmpMetaToJpegStream(&input_stream, xmp_data, &output_stream));
+  const string output = output_stream.str();
+
+  // The old extended sections are replaced by a single new one.
+  EXPECT_EQ(1, NumExtendedSections(output));
+  std::istringstream parse_stream(output);
+  const std::vector<Section> sections = Parse(ParseOptions(), &parse_stream);
+  ASSERT_EQ(4, sections.size());
+  EXPECT_EQ(0, sections[0].data.find("Exif"));
+  EXPECT_EQ(0, sections[1].data.find(XmpConst::Header()));
+  EXPECT_EQ(0, sections[2].data.find(XmpConst::ExtensionHeader()));
+  EXPECT_TRUE(sections[3].is_image_section);
+  EXPECT_EQ(TestXmpCreator::GetFakeJpegPayload().substr(2), sections[3].data);
+
+  XmpData new_xmp_data;
+  ASSERT_TRUE(ReadXmpFromMemory(output, false, &new_xmp_data));
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(new_xmp_data.ExtendedSection()));
+  string value;
+  ASSERT_TRUE(deserializer.ParseString(kPrefix, kDataName, &value));
+  EXPECT_EQ(kDataValue, value);
+}
+
+TEST(XmpWriter, AddXmpMetaToJpegStreamWithoutExif) {
+  std::vector<string> sections;
+  sections.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(sections);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpFromMemory(contents, true, &xmp_data));
+
+  std::istringstream input_stream(contents);
+  std::ostringstream output_stream;
+  ASSERT_TRUE(AddXmpMetaToJpegStream(&input_stream, xmp_data, &output_stream));
+  std::istringstream parse_stream(output_stream.str());
+  const std::vector<Section> output_sections =
+      Parse(ParseOptions(), &parse_stream);
+  ASSERT_EQ(2, output_sections.size());
+  EXPECT_EQ(0, output_sections[0].data.find(XmpConst::Header()));
+  EXPECT_TRUE(output_sections[1].is_image_section);
+}
+
+TEST(XmpWriter, AddXmpMetaToJpegStreamKeepsJfifFirst) {
+  std::vector<string> sections;
+  sections.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  string contents = TestXmpCreator::MakeJPEGFileContents(sections);
+  // Insert a JFIF APP0 section after the start of image marker.
+  const string jfif("JFIF\0\x01\x02\0\0\x01\0\x01\0\0", 14);
+  contents.insert(2, string("\xff\xe0\0\x10", 4) + jfif);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpFromMemory(contents, true, &xmp_data));
+
+  std::istringstream input_stream(contents);
+  std::ostringstream output_stream;
+  ASSERT_TRUE(AddXmpMetaToJpegStream(&input_stream, xmp_data, &output_stream));
+  std::istringstream parse_stream(output_stream.str());
+  const std::vector<Section> output_sections =
+      Parse(ParseOptions(), &parse_stream);
+  ASSERT_EQ(3, output_sections.size());
+  EXPECT_EQ(0xe0, output_sections[0].marker);
+  EXPECT_EQ(jfif, output_sections[0].data);
+  EXPECT_EQ(0, output_sections[1].data.find(XmpConst::Header()));
+  EXPECT_TRUE(output_sections[2].is_image_section);
+
+  // The in-memory writer places the XMP the same way.
+  const string out_filename = TempFileAbsolutePath(kOutFile);
+  ASSERT_TRUE(WriteLeftEyeAndXmpMeta(contents, out_filename, xmp_data));
+  string output;
+  ReadFileToStringOrDie(out_filename, &output);
+  EXPECT_EQ(output_stream.str(), output);
+}
+
+TEST(XmpWriter, AddXmpPacketsToJpegStreamRequiresLink) {
+  const string contents = MakeJpegWithExifAndXmp();
+  const string standard_xmp =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\"/>\n";
+  std::istringstream input_stream(contents);
+  std::ostringstream output_stream;
+  EXPECT_FALSE(AddXmpPacketsToJpegStream(&input_stream, standard_xmp, kXmpBody,
+                                         &output_stream));
+
+  // The extended packet is only linked, not checked.
+  std::istringstream linked_input_stream(contents);
+  EXPECT_TRUE(AddXmpPacketsToJpegStream(&linked_input_stream, kXmpBody,
+                                        standard_xmp, &output_stream));
+  EXPECT_EQ(1, NumExtendedSections(output_stream.str()));
+}
+
+TEST(XmpWriter, AddXmpMetaToJpegFileMatchesStream) {
+  const string contents = MakeJpegWithExifAndXmp();
+  const string in_filename = TempFileAbsolutePath(kInFile);
+  const string out_filename = TempFileAbsolutePath(kOutFile);
+  WriteStringToFileOrDie(contents, in_filename);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(in_filename, false, &xmp_data));
+
+  std::istringstream input_stream(contents);
+  std::ostringstream output_stream;
+  ASSERT_TRUE(AddXmpMetaToJpegStream(&input_stream, xmp_data, &output_stream));
+  ASSERT_TRUE(AddXmpMetaToJpegFile(in_filename, xmp_data, out_filename));
+  string output;
+  ReadFileToStringOrDie(out_filename, &output);
+  EXPECT_EQ(output_stream.str(), output);
+  EXPECT_FALSE(AddXmpMetaToJpegFile(in_filename, xmp_data, in_filename));
+}
+
+TEST(XmpWriter, UpdateXmpMetaInJpegFileInPlace) {
+  // Leave room in the standard section for the edit.
+  std::vector<string> sections;
+  sections.push_back(TestXmpCreator::CreateStandardXmpString(
+      string(kXmpBody) + string(1024, ' ')));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(sections);
+  const string filename = TempFileAbsolutePath(kInFile);
+  WriteStringToFileOrDie(contents, filename);
+
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(filename, true, &xmp_data));
+  SetMimeProperty("image/png", &xmp_data);
+  ASSERT_TRUE(UpdateXmpMetaInJpegFile(filename, xmp_data));
+
+  // Only the standard section changed.
+  string output;
+  ReadFileToStringOrDie(filename, &output);
+  ASSERT_EQ(contents.size(), output.size());
+  EXPECT_EQ(contents.substr(0, 6), output.substr(0, 6));
+  const string payload = TestXmpCreator::GetFakeJpegPayload();
+  EXPECT_EQ(payload, output.substr(output.size() - payload.size()));
+
+  XmpData new_xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(filename, true, &new_xmp_data));
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(new_xmp_data.StandardSection()));
+  string value;
+  ASSERT_TRUE(deserializer.ParseString(kPrefix, kMimeName, &value));
+  EXPECT_EQ("image/png", value);
+}
+
+TEST(XmpWriter, UpdateXmpMetaInJpegFileFallsBackToRewrite) {
+  std::vector<string> sections;
+  sections.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(sections);
+  const string filename = TempFileAbsolutePath(kInFile);
+  WriteStringToFileOrDie(contents, filename);
+
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(filename, true, &xmp_data));
+  SetMimeProperty(string(512, 'x'), &xmp_data);
+  ASSERT_TRUE(UpdateXmpMetaInJpegFile(filename, xmp_data));
+
+  string output;
+  ReadFileToStringOrDie(filename, &output);
+  EXPECT_LT(contents.size(), output.size());
+  XmpData new_xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(filename, true, &new_xmp_data));
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(new_xmp_data.StandardSection()));
+  string value;
+  ASSERT_TRUE(deserializer.ParseString(kPrefix, kMimeName, &value));
+  EXPECT_EQ(string(512, 'x'), value);
+}
+
+TEST(XmpWriter, UpdateXmpMetaInJpegFileDropsOldExtendedSections) {
+  std::vector<string> sections;
+  sections.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string input_filename = TempFileAbsolutePath(kOutFile);
+  WriteStringToFileOrDie(TestXmpCreator::MakeJPEGFileContents(sections),
+                         input_filename);
+  const string filename = TempFileAbsolutePath(kInFile);
+  ASSERT_TRUE(
+      AddXmpMetaToJpegFile(input_filename, *CreateXmpData(true), filename));
+  const string extended_prefix = string(XmpConst::ExtensionHeader()) + '\0';
+  ASSERT_FALSE(SectionIndex::FromFile(filename)
+                   ->FindApp1Sections(extended_prefix)
+                   .empty());
+
+  // The new standard section is smaller, but nothing would refer to the old
+  // extended sections if only the standard section were replaced.
+  ASSERT_TRUE(UpdateXmpMetaInJpegFile(filename, *CreateXmpData(false)));
+  EXPECT_TRUE(SectionIndex::FromFile(filename)
+                  ->FindApp1Sections(extended_prefix)
+                  .empty());
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(filename, false, &xmp_data));
+  EXPECT_EQ(nullptr, xmp_data.ExtendedSection());
+}
+
+#ifndef _WIN32
+TEST(XmpWriter, UpdateXmpMetaInJpegFileKeepsPermissions) {
+  std::vector<string> sections;
+  sections.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string filename = TempFileAbsolutePath(kInFile);
+  WriteStringToFileOrDie(TestXmpCreator::MakeJPEGFileContents(sections),
+                         filename);
+  ASSERT_EQ(0, chmod(filename.c_str(), 0640));
+  // A file that happens to have a temporary-looking name is left alone.
+  const string other_filename = filename + ".tmp";
+  WriteStringToFileOrDie("other", other_filename);
+
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(filename, true, &xmp_data));
+  SetMimeProperty(string(512, 'x'), &xmp_data);
+  ASSERT_TRUE(UpdateXmpMetaInJpegFile(filename, xmp_data));
+
+  struct stat file_stat;
+  ASSERT_EQ(0, stat(filename.c_str(), &file_stat));
+  EXPECT_EQ(0640, file_stat.st_mode & 0777);
+  string other;
+  ReadFileToStringOrDie(other_filename, &other);
+  EXPECT_EQ("other", other);
+}
+#endif  // _WIN32
+
 }  // namespace
 }  // namespace xmpmeta
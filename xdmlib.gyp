@@ -38,6 +38,7 @@
         '<(DEPTH)/third_party/xmpmeta/internal/',
       ],
       'sources': [
+        '<(xdmlib_dir)/aligned_buffer.cc',
         '<(xdmlib_dir)/audio.cc',
         '<(xdmlib_dir)/camera.cc',
         '<(xdmlib_dir)/cameras.cc',
@@ -47,7 +48,11 @@
         '<(xdmlib_dir)/device_pose.cc',
         '<(xdmlib_dir)/equirect_model.cc',
         '<(xdmlib_dir)/image.cc',
+        '<(xdmlib_dir)/lazy_base64_data.cc',
+        '<(xdmlib_dir)/point_arrays.cc',
         '<(xdmlib_dir)/point_cloud.cc',
+        '<(xdmlib_dir)/point_cloud_codec.cc',
+        '<(xdmlib_dir)/point_cloud_index.cc',
         '<(xdmlib_dir)/profile.cc',
         '<(xdmlib_dir)/profiles.cc',
       ],
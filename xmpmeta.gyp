@@ -44,15 +44,18 @@
       ],
       'sources': [
         '<(xmpmeta_dir)/base64.cc',
+        '<(xmpmeta_dir)/batch_xmp_reader.cc',
         '<(xmpmeta_dir)/gaudio.cc',
         '<(xmpmeta_dir)/gimage.cc',
         '<(xmpmeta_dir)/gpano.cc',
         '<(xmpmeta_dir)/jpeg_io.cc',
         '<(xmpmeta_dir)/md5.cc',
+        '<(xmpmeta_dir)/number_parser.cc',
         '<(xmpmeta_dir)/vr_photo_writer.cc',
         '<(xmpmeta_dir)/xmp_const.cc',
         '<(xmpmeta_dir)/xmp_data.cc',
         '<(xmpmeta_dir)/xmp_parser.cc',
+        '<(xmpmeta_dir)/xmp_parser_context.cc',
         '<(xmpmeta_dir)/xmp_writer.cc',
       ]
     },